@@ -0,0 +1,187 @@
+// bench.c
+// Microbenchmarks da biblioteca: table_load_csv, table_filter, table_save_csv,
+// table_delete_row (+ table_compact) e table_free sobre um ficheiro CSV (ver csvgen.c)
+//
+// cada medição é escrita numa linha JSON (um objeto por linha), para ser lida por scripts:
+//   {"bench":"load","run":1,"rows":...,"bytes":...,"seconds":...,"mb_per_s":...,
+//    "ns_per_row":...,"allocs":...,"alloc_bytes":...,"peak_rss_kb":...}
+//
+// as alocações são contadas com os wrappers __wrap_malloc/__wrap_calloc/__wrap_realloc
+// (o programa é ligado com -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "table.h"
+#include "csv_scan.h"
+
+// contadores das alocações (atualizados também pelas threads da biblioteca)
+static unsigned long alloc_count;
+static unsigned long alloc_bytes;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&alloc_bytes, size, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&alloc_bytes, n * size, __ATOMIC_RELAXED);
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&alloc_bytes, size, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+
+// medição em curso
+struct measure
+{
+    double start;
+    unsigned long allocs;
+    unsigned long bytes;
+};
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void measure_start(struct measure *m)
+{
+    m->allocs = __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+    m->bytes = __atomic_load_n(&alloc_bytes, __ATOMIC_RELAXED);
+    m->start = now_seconds();
+}
+
+// termina a medição e escreve a linha JSON
+// rows: linhas processadas (para ns_per_row); data_bytes: bytes do ficheiro lido/escrito (ou 0)
+static void measure_report(const struct measure *m, const char *name, int run, size_t rows, long data_bytes)
+{
+    double seconds = now_seconds() - m->start;
+    unsigned long allocs = __atomic_load_n(&alloc_count, __ATOMIC_RELAXED) - m->allocs;
+    unsigned long bytes = __atomic_load_n(&alloc_bytes, __ATOMIC_RELAXED) - m->bytes;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("{\"bench\":\"%s\",\"run\":%d,\"rows\":%lu,\"bytes\":%ld,\"seconds\":%.6f,"
+           "\"mb_per_s\":%.1f,\"ns_per_row\":%.1f,\"allocs\":%lu,\"alloc_bytes\":%lu,\"peak_rss_kb\":%ld}\n",
+           name, run, (unsigned long)rows, data_bytes, seconds,
+           data_bytes > 0 && seconds > 0 ? data_bytes / seconds / 1e6 : 0.0,
+           rows > 0 ? seconds * 1e9 / rows : 0.0, allocs, bytes, usage.ru_maxrss);
+    fflush(stdout);
+}
+
+// predicado do benchmark de table_filter: fica cerca de metade das linhas geradas pelo csvgen
+static bool first_half_of_alphabet(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    (void)context;
+    return row[0] && row[0][0] < 'n';
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[1]: ficheiro CSV a ler
+    // opções: runs=N (repetições), deletes=N (linhas eliminadas), out=FILE (destino do save)
+    if (argc < 2)
+    {
+        fprintf(stderr, "Please do: %s <csv_file> [runs=N] [deletes=N] [out=FILE]\n", argv[0]);
+        return 1;
+    }
+
+    const char *src_file = argv[1];
+    const char *out_file = "bench_out.csv";
+    int runs = 3;
+    long deletes = 100000;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (strncmp(argv[i], "runs=", 5) == 0)
+            runs = atoi(argv[i] + 5);
+        else if (strncmp(argv[i], "deletes=", 8) == 0)
+            deletes = atol(argv[i] + 8);
+        else if (strncmp(argv[i], "out=", 4) == 0)
+            out_file = argv[i] + 4;
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    struct stat st;
+    if (stat(src_file, &st) != 0)
+    {
+        fprintf(stderr, "ERROR opening file %s\n", src_file);
+        return 1;
+    }
+
+    printf("{\"bench\":\"info\",\"file\":\"%s\",\"file_bytes\":%ld,\"runs\":%d,\"scanner\":\"%s\"}\n",
+           src_file, (long)st.st_size, runs, csv_scan_impl());
+
+    for (int run = 1; run <= runs; run++)
+    {
+        struct measure m;
+
+        measure_start(&m);
+        struct table *table = table_load_csv(src_file);
+        if (!table)
+        {
+            fprintf(stderr, "ERROR loading file %s\n", src_file);
+            return 1;
+        }
+        measure_report(&m, "load", run, table->num_rows, (long)st.st_size);
+
+        measure_start(&m);
+        struct table *filtered = table_filter(table, first_half_of_alphabet, NULL);
+        measure_report(&m, "filter", run, table->num_rows, 0);
+        table_free(filtered);
+
+        measure_start(&m);
+        long saved = table_save_csv(table, out_file);
+        measure_report(&m, "save", run, table->num_rows, saved);
+
+        // eliminar linhas em posições pseudo-aleatórias (sempre as mesmas), sem o cabeçalho
+        size_t count = table->num_rows > 1 ? (size_t)deletes : 0;
+        if (count > table->num_rows / 2)
+            count = table->num_rows / 2;
+        unsigned long long state = 88172645463325252ull;
+        measure_start(&m);
+        for (size_t k = 0; k < count; k++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            table_delete_row(table, 1 + state % (table->num_rows - 1));
+        }
+        measure_report(&m, "delete_row", run, count, 0);
+
+        // as eliminações só marcam as linhas: a compactação é medida à parte
+        measure_start(&m);
+        table_compact(table);
+        measure_report(&m, "compact", run, table->num_rows, 0);
+
+        size_t rows = table->num_rows;
+        measure_start(&m);
+        table_free(table);
+        measure_report(&m, "free", run, rows, 0);
+    }
+
+    return 0;
+}
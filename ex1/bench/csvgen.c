@@ -0,0 +1,158 @@
+// csvgen.c
+// Gerador determinístico de ficheiros CSV para os benchmarks (a mesma semente dá sempre o
+// mesmo ficheiro)
+//
+// opções (nome=valor, em qualquer ordem):
+//   rows=N     número de linhas de dados (além do cabeçalho)      [100000]
+//   cols=N     número de colunas (1 a MAX_COLS)                    [5]
+//   len=N      comprimento médio dos campos de texto               [8]
+//   quote=F    fração dos campos de texto que precisam de aspas    [0.05]
+//   numeric=F  fração das colunas numéricas (as últimas colunas)   [0.4]
+//   seed=N     semente do gerador                                  [1]
+//   out=FILE   ficheiro de destino                                 [stdout]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "table.h"
+
+// gerador xorshift64*: rápido e igual em todas as máquinas (ao contrário de rand)
+static uint64_t rng_state;
+
+static uint64_t rng_next(void)
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1Dull;
+}
+
+// número aleatório em [0, n)
+static uint64_t rng_below(uint64_t n)
+{
+    return rng_next() % n;
+}
+
+// número aleatório em [0, 1)
+static double rng_unit(void)
+{
+    return (rng_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// escreve um campo de texto com comprimento entre 1 e 2 * len - 1
+// os campos que precisam de aspas têm uma vírgula ou uma aspa no meio
+static void write_text_field(FILE *out, int len, double quote_ratio)
+{
+    char field[1024];
+    int n = 1 + (int)rng_below(2 * len - 1);
+
+    for (int i = 0; i < n; i++)
+        field[i] = 'a' + (char)rng_below(26);
+
+    if (rng_unit() < quote_ratio)
+    {
+        field[n / 2] = rng_below(2) ? ',' : '"';
+        fputc('"', out);
+        for (int i = 0; i < n; i++)
+        {
+            if (field[i] == '"')
+                fputc('"', out);
+            fputc(field[i], out);
+        }
+        fputc('"', out);
+    }
+    else
+        fwrite(field, 1, n, out);
+}
+
+// escreve um campo numérico: inteiro na primeira coluna numérica, decimal nas outras
+static void write_numeric_field(FILE *out, bool integer)
+{
+    if (integer)
+        fprintf(out, "%llu", (unsigned long long)rng_below(1000000));
+    else
+        fprintf(out, "%llu.%02llu", (unsigned long long)rng_below(10000), (unsigned long long)rng_below(100));
+}
+
+int main(int argc, char *argv[])
+{
+    long rows = 100000;
+    int cols = 5;
+    int len = 8;
+    double quote_ratio = 0.05;
+    double numeric_ratio = 0.4;
+    unsigned long long seed = 1;
+    const char *out_file = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *eq = strchr(argv[i], '=');
+        if (!eq)
+        {
+            fprintf(stderr, "Please do: %s [rows=N] [cols=N] [len=N] [quote=F] [numeric=F] [seed=N] [out=FILE]\n", argv[0]);
+            return 1;
+        }
+
+        const char *value = eq + 1;
+        if (strncmp(argv[i], "rows=", 5) == 0)
+            rows = atol(value);
+        else if (strncmp(argv[i], "cols=", 5) == 0)
+            cols = atoi(value);
+        else if (strncmp(argv[i], "len=", 4) == 0)
+            len = atoi(value);
+        else if (strncmp(argv[i], "quote=", 6) == 0)
+            quote_ratio = atof(value);
+        else if (strncmp(argv[i], "numeric=", 8) == 0)
+            numeric_ratio = atof(value);
+        else if (strncmp(argv[i], "seed=", 5) == 0)
+            seed = strtoull(value, NULL, 10);
+        else if (strncmp(argv[i], "out=", 4) == 0)
+            out_file = value;
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (rows < 0 || cols < 1 || cols > MAX_COLS || len < 1 || len > 512)
+    {
+        fprintf(stderr, "Invalid options (rows >= 0, 1 <= cols <= %d, 1 <= len <= 512)\n", MAX_COLS);
+        return 1;
+    }
+
+    FILE *out = out_file ? fopen(out_file, "w") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "ERROR creating file %s\n", out_file);
+        return 1;
+    }
+
+    // a semente 0 deixaria o xorshift sempre a 0
+    rng_state = seed * 0x9E3779B97F4A7C15ull + 1;
+    int first_numeric = cols - (int)(cols * numeric_ratio + 0.5);
+
+    // cabeçalho: uma letra por coluna, como nos comandos do programa
+    for (int j = 0; j < cols; j++)
+        fprintf(out, "%c%c", 'A' + j, j + 1 < cols ? ',' : '\n');
+
+    for (long i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            if (j >= first_numeric)
+                write_numeric_field(out, j == first_numeric);
+            else
+                write_text_field(out, len, quote_ratio);
+            fputc(j + 1 < cols ? ',' : '\n', out);
+        }
+    }
+
+    if (out != stdout && fclose(out) != 0)
+    {
+        fprintf(stderr, "ERROR writing file %s\n", out_file);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+// check.h
+// Funções auxiliares dos testes de regressão (make test): cada teste escreve os seus ficheiros
+// CSV com o prefixo dado na linha de comandos, verifica os resultados com CHECK e termina com 1
+// se alguma verificação falhar
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "table.h"
+
+static int check_failures = 0;
+
+// Verifica uma condição; se falhar, mostra a linha do teste e a mensagem (formato de printf)
+#define CHECK(cond, ...)                                                  \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);          \
+            fprintf(stderr, __VA_ARGS__);                                 \
+            fprintf(stderr, "\n");                                        \
+            check_failures++;                                             \
+        }                                                                 \
+    } while (0)
+
+// Escreve data no ficheiro filename (retorna 0 em sucesso, -1 em erro)
+static inline int write_file(const char *filename, const char *data)
+{
+    FILE *f = fopen(filename, "w");
+    if (!f)
+        return -1;
+
+    int result = fputs(data, f) == EOF ? -1 : 0;
+    if (fclose(f) != 0)
+        result = -1;
+
+    return result;
+}
+
+// Lê o ficheiro filename para uma string terminada em '\0' (a libertar com free; NULL em erro)
+static inline char *read_file(const char *filename)
+{
+    FILE *f = fopen(filename, "rb");
+    if (!f)
+        return NULL;
+
+    size_t size = 0, capacity = 4096;
+    char *data = malloc(capacity);
+    size_t n;
+    while (data && (n = fread(data + size, 1, capacity - size - 1, f)) > 0)
+    {
+        size += n;
+        if (capacity - size - 1 == 0)
+        {
+            char *bigger = realloc(data, capacity * 2);
+            if (!bigger)
+            {
+                free(data);
+                data = NULL;
+                break;
+            }
+            data = bigger;
+            capacity *= 2;
+        }
+    }
+    fclose(f);
+
+    if (data)
+        data[size] = '\0';
+    return data;
+}
+
+// Escreve um CSV de teste determinístico com o cabeçalho e rows linhas:
+// id (o número da linha), fruta (com vírgulas, aspas escapadas, espaços e células vazias),
+// quantidade (inteiros, algumas vazias), origem (algumas com uma quebra de linha entre aspas)
+// e preco (números decimais); de 97 em 97 linhas faltam as duas últimas células (NULL)
+// devolve 0 em sucesso, -1 em erro
+static inline int write_sample_csv(const char *filename, size_t rows)
+{
+    static const char *fruits[] = {"maca", "pera", "\"pera, rocha\"", "uva", "\"kiwi \"\"gold\"\"\"",
+                                   "", "  laranja ", "amora"};
+    static const char *origins[] = {"portugal", "espanha", "\"nova\nzelandia\"", "franca"};
+
+    FILE *f = fopen(filename, "w");
+    if (!f)
+        return -1;
+
+    fprintf(f, "id,fruta,quantidade,origem,preco\n");
+    for (size_t i = 1; i <= rows; i++)
+    {
+        fprintf(f, "%lu,%s,", (unsigned long)i, fruits[(i * 7 + i / 5) % 8]);
+        if (i % 13 != 0)
+            fprintf(f, "%lu", (unsigned long)(i * 37 % 100));
+        if (i % 97 == 0)
+        {
+            fprintf(f, "\n");
+            continue;
+        }
+        fprintf(f, ",%s,%lu.%02lu\n", origins[i % 50 == 0 ? 2 : i % 4 == 2 ? 1 : i % 4 == 3 ? 3 : 0],
+                (unsigned long)(i % 5), (unsigned long)(i * 29 % 100));
+    }
+
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+// Verifica que table tem as mesmas linhas e células que expected
+static inline void check_same_table(const struct table *expected, const struct table *table, const char *what)
+{
+    CHECK(table != NULL, "%s: no table", what);
+    if (!table || !expected)
+        return;
+
+    CHECK(table->num_rows == expected->num_rows && table->num_cols == expected->num_cols,
+          "%s: %lu x %lu, expected %lu x %lu", what, (unsigned long)table->num_rows,
+          (unsigned long)table->num_cols, (unsigned long)expected->num_rows, (unsigned long)expected->num_cols);
+    if (table->num_rows != expected->num_rows || table->num_cols != expected->num_cols)
+        return;
+
+    for (size_t i = 0; i < table->num_rows; i++)
+    {
+        char **row = table_get_row(table, i);
+        char **want = table_get_row(expected, i);
+        for (size_t c = 0; c < table->num_cols; c++)
+        {
+            if ((!want[c] && !row[c]) || (want[c] && row[c] && strcmp(want[c], row[c]) == 0))
+                continue;
+            CHECK(false, "%s: cell %lu,%lu is '%s', expected '%s'", what, (unsigned long)i, (unsigned long)c,
+                  row[c] ? row[c] : "(null)", want[c] ? want[c] : "(null)");
+            return;
+        }
+    }
+}
+
+// Texto da célula col da linha row ("(null)" se a célula não existir)
+static inline const char *cell_text(const struct table *table, size_t row, size_t col)
+{
+    const char *cell = table_get_row(table, row)[col];
+    return cell ? cell : "(null)";
+}
+
+// Mostra o resultado do teste e devolve o código de saída do programa
+static inline int check_result(void)
+{
+    if (check_failures == 0)
+    {
+        printf("OK\n");
+        return 0;
+    }
+
+    printf("FAILED (%d checks)\n", check_failures);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,102 @@
+// ex1a.c
+// Teste de regressão do carregamento com progresso (table_load_csv_progress): a tabela é igual à
+// de table_load_csv, o progresso lido por outra thread nunca recua e no fim tem o tamanho do
+// ficheiro e o número de linhas, e um carregamento cancelado devolve NULL
+#include <pthread.h>
+#include "check.h"
+
+#define SAMPLE_ROWS 200000
+
+// estado partilhado com a thread que acompanha o progresso
+struct monitor
+{
+    struct table_load_progress *progress;
+    int done;
+    int went_back; // o progresso recuou
+};
+
+static void *monitor_task(void *arg)
+{
+    struct monitor *m = arg;
+    size_t last_bytes = 0, last_rows = 0;
+
+    while (!__atomic_load_n(&m->done, __ATOMIC_ACQUIRE))
+    {
+        size_t bytes = __atomic_load_n(&m->progress->bytes_read, __ATOMIC_RELAXED);
+        size_t rows = __atomic_load_n(&m->progress->rows, __ATOMIC_RELAXED);
+        if (bytes < last_bytes || rows < last_rows)
+            m->went_back = 1;
+        last_bytes = bytes;
+        last_rows = rows;
+    }
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *expected = table_load_csv(src_file);
+    if (!expected)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    FILE *f = fopen(src_file, "rb");
+    long size = f && fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (f)
+        fclose(f);
+
+    // carregamento acompanhado por outra thread
+    struct table_load_progress progress = {0};
+    struct monitor m = {&progress, 0, 0};
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, monitor_task, &m) == 0, "could not start the monitor thread");
+    struct table *table = table_load_csv_progress(src_file, &progress);
+    __atomic_store_n(&m.done, 1, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+
+    check_same_table(expected, table, "load with progress");
+    CHECK(!m.went_back, "the progress went back");
+    CHECK(progress.total_bytes == (size_t)size && progress.bytes_read == (size_t)size,
+          "progress has %lu of %lu bytes, the file has %ld", (unsigned long)progress.bytes_read,
+          (unsigned long)progress.total_bytes, size);
+    CHECK(progress.rows == expected->num_rows, "progress has %lu rows, expected %lu", (unsigned long)progress.rows,
+          (unsigned long)expected->num_rows);
+    table_free(table);
+
+    // sem progresso
+    table = table_load_csv_progress(src_file, NULL);
+    check_same_table(expected, table, "load without progress");
+    table_free(table);
+
+    // cancelado antes de começar
+    struct table_load_progress cancelled = {0};
+    cancelled.cancel = 1;
+    CHECK(table_load_csv_progress(src_file, &cancelled) == NULL, "a cancelled load returned a table");
+
+    // ficheiro que não existe
+    struct table_load_progress missing = {0};
+    remove(src_file);
+    CHECK(table_load_csv_progress(src_file, &missing) == NULL, "loaded a missing file");
+
+    table_free(expected);
+
+    return check_result();
+}
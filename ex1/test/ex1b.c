@@ -0,0 +1,165 @@
+// ex1b.c
+// Teste de regressão dos kernels em lote (table_filter_batch e table_transform_batch): o filtro
+// em lote dá as mesmas linhas que table_filter_parallel com o mesmo predicado, com 1 e com 4
+// threads, na tabela, numa tabela mapeada e numa vista; a transformação altera as células
+// (descartando o índice da coluna) e um lote falhado deixa a coluna como estava
+#include <ctype.h>
+#include "check.h"
+
+#define SAMPLE_ROWS (TABLE_BATCH_ROWS * 9 + 77)
+
+static bool fruit_with_a(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return row[1] && strchr(row[1], 'a') != NULL;
+}
+
+static void fruit_with_a_kernel(const struct table *table, size_t first, size_t end, bool *keep,
+                                const void *context)
+{
+    for (size_t i = first; i < end; i++)
+        keep[i - first] = fruit_with_a(table_get_row(table, i), context);
+}
+
+// passa a fruta a maiúsculas (as células sem letras minúsculas ficam como estão)
+static void upper_kernel(const struct table *table, size_t col, size_t first, size_t end,
+                         struct table_batch_output *out, const void *context)
+{
+    char buffer[256];
+    for (size_t i = first; i < end; i++)
+    {
+        const char *cell = table_get_row(table, i)[col];
+        size_t len = cell ? strlen(cell) : 0;
+        if (!cell || len >= sizeof(buffer))
+            continue;
+
+        bool changed = false;
+        for (size_t k = 0; k <= len; k++)
+        {
+            buffer[k] = (char)toupper((unsigned char)cell[k]);
+            changed |= buffer[k] != cell[k];
+        }
+        if (changed && table_batch_set(out, i, buffer, len) != 0)
+            table_batch_fail(out);
+    }
+}
+
+// altera todas as células, mas falha no lote que contém a linha context
+static void failing_kernel(const struct table *table, size_t col, size_t first, size_t end,
+                           struct table_batch_output *out, const void *context)
+{
+    size_t bad_row = *(const size_t *)context;
+    for (size_t i = first; i < end; i++)
+        table_batch_set(out, i, "x", 1);
+    if (bad_row >= first && bad_row < end)
+        table_batch_fail(out);
+}
+
+// função auxiliar para comparar table_filter_batch com table_filter_parallel
+static void check_filter(const struct table *table, const char *what)
+{
+    for (int threads = 1; threads <= 4; threads += 3)
+    {
+        char name[128];
+        snprintf(name, sizeof(name), "%s, %d threads", what, threads);
+        struct table *batch = table_filter_batch(table, fruit_with_a_kernel, NULL, threads);
+        struct table *rows = table_filter_parallel(table, fruit_with_a, NULL, threads);
+        check_same_table(rows, batch, name);
+        CHECK(batch && batch->num_rows > TABLE_BATCH_ROWS, "%s: %ld rows", name, batch ? (long)batch->num_rows : -1L);
+        table_free(batch);
+        table_free(rows);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    struct table *mapped = table_load_csv_mmap(src_file);
+    struct table *plain = table_load_csv(src_file);
+    if (!table || !mapped || !plain)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    check_filter(table, "table");
+    check_filter(mapped, "mapped");
+
+    struct table *view = table_filter_view(table, fruit_with_a, NULL);
+    CHECK(view != NULL, "view failed");
+    if (view)
+        check_filter(view, "view");
+    table_free(view);
+
+    // transformação com 1 e com 4 threads: as células ficam em maiúsculas e o índice é descartado
+    for (int threads = 1; threads <= 4; threads += 3)
+    {
+        struct table *upper = threads == 1 ? table : mapped;
+        CHECK(table_create_index(upper, 1) == 0, "index creation failed");
+        CHECK(table_transform_batch(upper, 1, upper_kernel, NULL, threads) == 0, "%d threads: transform failed",
+              threads);
+        CHECK(!table_has_index(upper, 1), "%d threads: the index was kept", threads);
+
+        for (size_t i = 0; i < plain->num_rows && check_failures == 0; i++)
+        {
+            const char *before = table_get_row(plain, i)[1];
+            const char *after = table_get_row(upper, i)[1];
+            bool same = strlen(before) == strlen(after);
+            for (size_t k = 0; same && before[k]; k++)
+                same = toupper((unsigned char)before[k]) == after[k];
+            CHECK(same, "%d threads: row %lu is '%s', was '%s'", threads, (unsigned long)i, after, before);
+        }
+
+        // as outras colunas não mudam
+        for (size_t i = 0; i < plain->num_rows && check_failures == 0; i++)
+            CHECK(strcmp(cell_text(plain, i, 3), cell_text(upper, i, 3)) == 0, "%d threads: row %lu origin changed",
+                  threads, (unsigned long)i);
+
+        // o filtro por igualdade (sem índice) vê os valores novos
+        struct table *found = table_filter_equals(upper, 1, "MACA", threads);
+        struct table *expected = table_filter_equals(plain, 1, "maca", 1);
+        CHECK(found && expected && found->num_rows == expected->num_rows && found->num_rows > 0,
+              "%d threads: filter after the transform", threads);
+        table_free(found);
+        table_free(expected);
+    }
+
+    // um lote falhado: nenhuma célula muda, nem as dos lotes que correram bem
+    size_t bad_row = TABLE_BATCH_ROWS * 5 + 3;
+    for (int threads = 1; threads <= 4; threads += 3)
+    {
+        struct table *copy = table_load_csv(src_file);
+        CHECK(copy && table_create_index(copy, 2) == 0, "load failed");
+        if (!copy)
+            continue;
+
+        CHECK(table_transform_batch(copy, 2, failing_kernel, &bad_row, threads) == -1,
+              "%d threads: a failed batch did not fail the transform", threads);
+        check_same_table(plain, copy, "after a failed transform");
+        CHECK(table_has_index(copy, 2), "%d threads: the index was dropped by a failed transform", threads);
+        table_free(copy);
+    }
+
+    table_free(plain);
+    table_free(mapped);
+    table_free(table);
+    remove(src_file);
+
+    return check_result();
+}
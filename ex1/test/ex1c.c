@@ -0,0 +1,85 @@
+// ex1c.c
+// Teste de regressão do filtro em streaming (table_filter_csv): o ficheiro escrito é igual, byte
+// a byte, ao de carregar a tabela, filtrá-la com table_filter e guardá-la com table_save_csv
+#include "check.h"
+
+#define SAMPLE_ROWS 100000
+
+static bool price_lower_than_one_euro(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return row[4] && atof(row[4]) < 1.0;
+}
+
+static bool fruit_equals(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return row[1] && strcmp(row[1], (const char *)context) == 0;
+}
+
+// função auxiliar para comparar o filtro em streaming com o filtro da tabela carregada
+static void check_pipeline(const char *src_file, const char *prefix, const struct table *table,
+                           bool (*predicate)(const void *, const void *), const void *context, const char *what)
+{
+    char stream_file[1024], table_file[1024];
+    snprintf(stream_file, sizeof(stream_file), "%s_stream.csv", prefix);
+    snprintf(table_file, sizeof(table_file), "%s_table.csv", prefix);
+
+    long rows = table_filter_csv(src_file, stream_file, predicate, context);
+    CHECK(rows > 1, "%s: %ld rows written", what, rows);
+    struct table *filtered = table_filter(table, predicate, context);
+    CHECK(filtered && table_save_csv(filtered, table_file) >= 0, "%s: could not filter the table", what);
+    CHECK(filtered && rows == (long)filtered->num_rows, "%s: %ld rows written, expected %ld", what, rows,
+          filtered ? (long)filtered->num_rows : -1L);
+    table_free(filtered);
+
+    char *stream_data = read_file(stream_file);
+    char *table_data = read_file(table_file);
+    CHECK(stream_data && table_data && strcmp(stream_data, table_data) == 0, "%s: files differ", what);
+    free(stream_data);
+    free(table_data);
+
+    remove(stream_file);
+    remove(table_file);
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    if (!table)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    // o cabeçalho passa no primeiro filtro ("preco" vale 0) e não passa no segundo
+    check_pipeline(src_file, argv[1], table, price_lower_than_one_euro, NULL, "price < 1");
+    check_pipeline(src_file, argv[1], table, fruit_equals, "pera, rocha", "fruit = 'pera, rocha'");
+
+    char dest_file[1024];
+    snprintf(dest_file, sizeof(dest_file), "%s_missing.csv", argv[1]);
+    CHECK(table_filter_csv("/nonexistent/ex1c.csv", dest_file, fruit_equals, "maca") < 0,
+          "filtered a missing file");
+    remove(dest_file);
+
+    table_free(table);
+    remove(src_file);
+
+    return check_result();
+}
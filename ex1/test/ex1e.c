@@ -0,0 +1,134 @@
+// ex1e.c
+// Teste de regressão das expressões (table_expr_parse e table_filter_expr): o filtro otimizado
+// (operandos reordenados, valores convertidos e códigos dos dicionários, em paralelo) dá as
+// mesmas linhas, pela mesma ordem, que table_filter com table_expr_match linha a linha, com 1 e
+// com 4 threads, e as expressões inválidas não são compiladas
+#include "check.h"
+
+#define SAMPLE_ROWS (FILTER_MIN_PART_ROWS * 8 + 55)
+
+// colunas do CSV de teste: A id, B fruta, C quantidade, D origem, E preco
+static const char *expressions[] = {
+    "A = 10",
+    "C >= 50 and C < 60",
+    "B = maca or B = \"pera, rocha\"",
+    "not D = portugal and E > 2.5",
+    "(B = uva or B = \"\") and not (C < 20 or D = espanha)",
+    "B = \"kiwi \"\"gold\"\"\" or D = \"nova\nzelandia\"",
+    "E <= 0.5 or A > 32000 and C != 7",
+    "B > k and B < p",          // comparação de strings (o valor não é um número)
+    "B = \"  laranja \"",
+    "C = \"\" or E = \"\"",     // células vazias; as células em falta (NULL) não são iguais a nada
+    "A != id and not A = id",   // o cabeçalho
+    "C > 1000 or B = melancia", // nenhuma linha
+};
+
+static const char *invalid[] = {"", "A =", "A = 1 and", "F = 1", "A ~ 1", "(A = 1", "A = 1)", "not", "= 1",
+                                "A = \"maca"};
+
+// função auxiliar para comparar table_filter_expr com a avaliação linha a linha
+static void check_expressions(const struct table *table, const struct table *plain, int num_threads,
+                              const char *what)
+{
+    for (size_t k = 0; k < sizeof(expressions) / sizeof(expressions[0]); k++)
+    {
+        char name[256], error[256];
+        snprintf(name, sizeof(name), "%s, %d threads, '%s'", what, num_threads, expressions[k]);
+
+        struct table_expr *expr = table_expr_parse(expressions[k], table->num_cols, error, sizeof(error));
+        CHECK(expr != NULL, "%s: %s", name, error);
+        if (!expr)
+            continue;
+
+        struct table *expected = table_filter(plain, table_expr_match, expr);
+        struct table *result = table_filter_expr(table, expr, num_threads);
+        check_same_table(expected, result, name);
+        table_free(result);
+
+        // a expressão reordenada continua a dar o mesmo resultado
+        result = table_filter(plain, table_expr_match, expr);
+        check_same_table(expected, result, name);
+        table_free(result);
+        table_free(expected);
+        table_expr_free(expr);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *plain = table_load_csv(src_file);
+    struct table *typed = table_load_csv_parallel(src_file, 4);
+    if (!plain || !typed)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    // sem tipos nem dicionários, numa tabela mapeada com tipos e dicionários e numa vista
+    for (int threads = 1; threads <= 4; threads += 3)
+        check_expressions(plain, plain, threads, "plain");
+
+    CHECK(table_infer_types(typed, 4) == 0 && table_dict_encode(typed, 4) == 0, "types or dictionaries failed");
+    for (int threads = 1; threads <= 4; threads += 3)
+        check_expressions(typed, plain, threads, "typed");
+
+    char error[256];
+    struct table_expr *odd = table_expr_parse("C != \"\" and not E < 1", plain->num_cols, error, sizeof(error));
+    struct table *view = odd ? table_filter_expr(typed, odd, 4) : NULL;
+    struct table *plain_view = odd ? table_filter(plain, table_expr_match, odd) : NULL;
+    CHECK(view && plain_view && view->num_rows > 0, "view failed");
+    if (view && plain_view)
+        check_expressions(view, plain_view, 4, "view");
+    table_free(view);
+    table_free(plain_view);
+    table_expr_free(odd);
+
+    // comparações construídas sem texto, juntas com table_expr_and
+    struct table_expr *a = table_expr_compare(2, ">=", "50");
+    struct table_expr *b = table_expr_compare(3, "=", "franca");
+    struct table_expr *both = a && b ? table_expr_and(a, b) : NULL;
+    struct table_expr *parsed = table_expr_parse("C >= 50 and D = franca", plain->num_cols, error, sizeof(error));
+    CHECK(both && parsed, "table_expr_and failed");
+    if (both && parsed)
+    {
+        struct table *built = table_filter_expr(typed, both, 4);
+        struct table *expected = table_filter_expr(plain, parsed, 1);
+        check_same_table(expected, built, "table_expr_and");
+        table_free(built);
+        table_free(expected);
+    }
+    table_expr_free(both);
+    table_expr_free(parsed);
+    CHECK(table_expr_compare(0, "<>", "1") == NULL, "compiled an invalid operator");
+
+    // expressões inválidas: NULL, com uma mensagem
+    for (size_t k = 0; k < sizeof(invalid) / sizeof(invalid[0]); k++)
+    {
+        error[0] = '\0';
+        struct table_expr *expr = table_expr_parse(invalid[k], plain->num_cols, error, sizeof(error));
+        CHECK(expr == NULL && error[0] != '\0', "compiled the invalid expression '%s'", invalid[k]);
+        table_expr_free(expr);
+    }
+
+    table_free(plain);
+    table_free(typed);
+    remove(src_file);
+
+    return check_result();
+}
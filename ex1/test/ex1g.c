@@ -0,0 +1,211 @@
+// ex1g.c
+// Teste de regressão do agrupamento (table_group_by): o cabeçalho não é agregado (a soma dos
+// count(*) é o número de linhas de dados), count, sum, min, max e avg de cada grupo são iguais aos
+// calculados linha a linha, e o resultado é o mesmo com 1 e com 4 threads, com tipos e
+// dicionários, com duas colunas de chave e numa vista sem o cabeçalho
+#include "check.h"
+
+#define SAMPLE_ROWS (GROUP_MIN_PART_ROWS * 3 + 101)
+#define MAX_GROUPS 64
+
+// colunas do CSV de teste: 1 fruta (chave), 2 quantidade (inteiros, com vazias), 4 preco (decimais,
+// com células em falta)
+static const struct table_aggregate aggs[] = {
+    {AGG_COUNT, TABLE_AGG_ROWS}, {AGG_COUNT, 2}, {AGG_SUM, 2}, {AGG_MIN, 2},
+    {AGG_MAX, 2},                {AGG_COUNT, 4}, {AGG_AVG, 4}, {AGG_SUM, 4}
+};
+#define NUM_AGGS (sizeof(aggs) / sizeof(aggs[0]))
+
+// grupo calculado linha a linha
+struct expected_group
+{
+    const char *key;
+    size_t rows;
+    size_t count[2];         // células não vazias de quantidade e de preco
+    size_t numbers[2];       // células que são números
+    double sum[2], min, max; // min e max só de quantidade
+};
+
+// função auxiliar para ler um número (a célula toda)
+static bool read_number(const char *cell, double *value)
+{
+    char *end;
+    if (!cell || cell[0] == '\0')
+        return false;
+    *value = strtod(cell, &end);
+    return *end == '\0';
+}
+
+// função auxiliar para agrupar as linhas [first, num_rows) de table pela coluna 1, linha a linha
+// devolve o número de grupos
+static size_t expected_groups(const struct table *table, size_t first, struct expected_group *groups)
+{
+    size_t num_groups = 0;
+    for (size_t i = first; i < table->num_rows; i++)
+    {
+        char **row = table_get_row(table, i);
+        size_t g = 0;
+        while (g < num_groups && strcmp(groups[g].key, row[1]) != 0)
+            g++;
+        if (g == num_groups)
+        {
+            memset(&groups[g], 0, sizeof(groups[g]));
+            groups[g].key = row[1];
+            num_groups++;
+        }
+
+        struct expected_group *e = &groups[g];
+        double value;
+        e->rows++;
+        for (int k = 0; k < 2; k++)
+        {
+            const char *cell = row[k == 0 ? 2 : 4];
+            e->count[k] += cell && cell[0] != '\0';
+            if (!read_number(cell, &value))
+                continue;
+
+            e->numbers[k]++;
+            e->sum[k] += value;
+            if (k == 0 && (e->numbers[0] == 1 || value < e->min))
+                e->min = value;
+            if (k == 0 && (e->numbers[0] == 1 || value > e->max))
+                e->max = value;
+        }
+    }
+
+    return num_groups;
+}
+
+// função auxiliar para comparar uma célula do resultado com um número (com tolerância nas somas)
+static bool same_number(const char *cell, double want)
+{
+    double value;
+    if (!read_number(cell, &value))
+        return false;
+
+    double diff = value > want ? value - want : want - value;
+    return diff <= 1e-9 * ((want < 0 ? -want : want) + 1);
+}
+
+// função auxiliar para comparar o resultado do agrupamento de table pela coluna 1 com os grupos
+// calculados linha a linha
+static void check_groups(const struct table *table, int num_threads, const char *what)
+{
+    char name[128];
+    snprintf(name, sizeof(name), "%s, %d threads", what, num_threads);
+
+    size_t key = 1;
+    struct table *result = table_group_by(table, &key, 1, aggs, NUM_AGGS, num_threads);
+    CHECK(result && result->num_cols == 1 + NUM_AGGS, "%s: group by failed", name);
+    if (!result || result->num_cols != 1 + NUM_AGGS)
+    {
+        table_free(result);
+        return;
+    }
+
+    // o cabeçalho do resultado dá o nome das agregações
+    bool header = table_has_header(table);
+    CHECK(strcmp(cell_text(result, 0, 0), header ? "fruta" : "B") == 0 &&
+              strcmp(cell_text(result, 0, 1), "count(*)") == 0 &&
+              strcmp(cell_text(result, 0, 3), header ? "sum(quantidade)" : "sum(C)") == 0,
+          "%s: header '%s', '%s', '%s'", name, cell_text(result, 0, 0), cell_text(result, 0, 1),
+          cell_text(result, 0, 3));
+
+    static struct expected_group groups[MAX_GROUPS];
+    size_t num_groups = expected_groups(table, header ? 1 : 0, groups);
+    CHECK(result->num_rows == num_groups + 1, "%s: %lu groups, expected %lu", name,
+          (unsigned long)result->num_rows - 1, (unsigned long)num_groups);
+
+    // os grupos vêm pela ordem da primeira linha de cada um; o cabeçalho não é um grupo
+    size_t total = 0;
+    for (size_t g = 0; g < num_groups && g + 1 < result->num_rows; g++)
+    {
+        const struct expected_group *e = &groups[g];
+        char **row = table_get_row(result, g + 1);
+        total += atol(row[1]);
+
+        CHECK(strcmp(row[0], e->key) == 0, "%s: group %lu is '%s', expected '%s'", name, (unsigned long)g, row[0],
+              e->key);
+        CHECK(same_number(row[1], e->rows) && same_number(row[2], e->count[0]) && same_number(row[6], e->count[1]),
+              "%s: group '%s' counts %s, %s, %s", name, e->key, row[1], row[2], row[6]);
+        CHECK(same_number(row[3], e->sum[0]) && same_number(row[4], e->min) && same_number(row[5], e->max),
+              "%s: group '%s' sum %s, min %s, max %s", name, e->key, row[3], row[4], row[5]);
+        CHECK(same_number(row[7], e->sum[1] / e->numbers[1]) && same_number(row[8], e->sum[1]),
+              "%s: group '%s' avg %s, sum %s", name, e->key, row[7], row[8]);
+    }
+
+    size_t data_rows = table->num_rows - (header ? 1 : 0);
+    CHECK(total == data_rows, "%s: count(*) adds up to %lu, expected %lu", name, (unsigned long)total,
+          (unsigned long)data_rows);
+    table_free(result);
+}
+
+static bool without_header(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return atoi(row[0]) % 3 != 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *plain = table_load_csv(src_file);
+    struct table *typed = table_load_csv_mmap(src_file);
+    if (!plain || !typed)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    for (int threads = 1; threads <= 4; threads += 3)
+        check_groups(plain, threads, "plain");
+
+    CHECK(table_infer_types(typed, 4) == 0 && table_dict_encode(typed, 4) == 0, "types or dictionaries failed");
+    for (int threads = 1; threads <= 4; threads += 3)
+        check_groups(typed, threads, "typed");
+
+    // uma vista sem o cabeçalho agrega todas as suas linhas ("id" não passa no filtro)
+    struct table *view = table_filter_view(plain, without_header, NULL);
+    CHECK(view && !table_has_header(view), "view failed");
+    if (view)
+        check_groups(view, 4, "view");
+    table_free(view);
+
+    // duas colunas de chave (a origem em falta é um grupo diferente da vazia): os mesmos grupos
+    // com 1 e com 4 threads
+    size_t keys[] = {1, 3};
+    struct table_aggregate rows_agg = {AGG_COUNT, TABLE_AGG_ROWS};
+    struct table *results[2];
+    for (int r = 0; r < 2; r++)
+    {
+        results[r] = table_group_by(typed, keys, 2, &rows_agg, 1, r == 0 ? 1 : 4);
+        size_t total = 0;
+        for (size_t i = 1; results[r] && i < results[r]->num_rows; i++)
+            total += atol(cell_text(results[r], i, 2));
+        CHECK(results[r] && total == SAMPLE_ROWS, "two keys: count(*) adds up to %lu", (unsigned long)total);
+    }
+    check_same_table(results[0], results[1], "two keys, 4 threads");
+    table_free(results[0]);
+    table_free(results[1]);
+
+    table_free(plain);
+    table_free(typed);
+    remove(src_file);
+
+    return check_result();
+}
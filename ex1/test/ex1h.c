@@ -0,0 +1,92 @@
+// ex1h.c
+// Teste de regressão do índice hash (table_create_index): table_filter_equals com índice dá as
+// mesmas linhas, pela mesma ordem, que sem índice, na tabela e numa vista, incluindo valores
+// vazios, valores com vírgulas e aspas e valores que não existem
+#include "check.h"
+
+#define SAMPLE_ROWS 30000
+
+static const char *values[] = {"maca", "", "pera, rocha", "kiwi \"gold\"", "  laranja ", "melancia", "fruta"};
+
+// função auxiliar para comparar os filtros por igualdade de with_index (com índice na coluna col)
+// e de without_index (sem índice), para todos os valores de teste
+static void check_equals(const struct table *with_index, const struct table *without_index, size_t col,
+                         const char *what)
+{
+    CHECK(table_has_index(with_index, col) && !table_has_index(without_index, col), "%s: wrong indexes", what);
+
+    for (size_t k = 0; k < sizeof(values) / sizeof(values[0]); k++)
+    {
+        char name[128];
+        snprintf(name, sizeof(name), "%s, value '%s'", what, values[k]);
+
+        struct table *indexed = table_filter_equals(with_index, col, values[k], 1);
+        struct table *scanned = table_filter_equals(without_index, col, values[k], 4);
+        check_same_table(scanned, indexed, name);
+        table_free(indexed);
+        table_free(scanned);
+    }
+}
+
+static bool small_id(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return atoi(row[0]) % 3 != 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    struct table *plain = table_load_csv(src_file);
+    if (!table || !plain)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    // o valor do cabeçalho também é encontrado ("fruta" só existe na primeira linha)
+    CHECK(table_create_index(table, 1) == 0, "index creation failed");
+    struct table *header = table_filter_equals(table, 1, "fruta", 1);
+    CHECK(header && header->num_rows == 1 && table_has_header(header), "header value not found");
+    table_free(header);
+    check_equals(table, plain, 1, "table");
+
+    // índices sobre vistas: as linhas do índice são as da vista
+    struct table *view = table_filter_view(table, small_id, NULL);
+    struct table *plain_view = table_filter_view(plain, small_id, NULL);
+    CHECK(view && plain_view && table_create_index(view, 1) == 0, "index on a view failed");
+    check_equals(view, plain_view, 1, "view");
+
+    // a coluna com células em falta (NULL) também pode ter índice
+    CHECK(table_create_index(view, 4) == 0, "index on a column with NULL cells failed");
+    struct table *price = table_filter_equals(view, 4, "1.29", 1);
+    struct table *price_scan = table_filter_equals(plain_view, 4, "1.29", 1);
+    check_same_table(price_scan, price, "view, price '1.29'");
+    CHECK(price && price->num_rows > 0, "no rows with price 1.29");
+    table_free(price);
+    table_free(price_scan);
+
+    table_free(view);
+    table_free(plain_view);
+    table_free(table);
+    table_free(plain);
+    remove(src_file);
+
+    return check_result();
+}
@@ -0,0 +1,167 @@
+// ex1j.c
+// Teste de regressão de table_hash_join: as células vazias (ou só com espaços) e as células
+// em falta (NULL) nunca se juntam, de nenhum dos lados, e o resultado não depende do lado
+// escolhido para a tabela de dispersão nem do número de threads (também numa tabela grande o
+// suficiente para ser dividida pelas threads)
+#include "check.h"
+
+#define SAMPLE_ROWS (JOIN_MIN_PART_ROWS * 3 + 17)
+
+static const char *left_csv =
+    "id,fruta\n"
+    "1,maca\n"
+    "2,\n"
+    "3,pera\n"
+    "4\n"
+    "5,  \n"
+    "6,maca\n";
+
+static const char *origins_csv =
+    "origem,continente\n"
+    "portugal,europa\n"
+    "espanha,europa\n"
+    "\"nova\nzelandia\",oceania\n"
+    ",nenhum\n"
+    "franca,europa\n"
+    "franca,europa ocidental\n";
+
+static const char *right_csv =
+    "fruta,preco\n"
+    "maca,0.5\n"
+    ",0.1\n"
+    "pera,0.9\n"
+    "  ,0.2\n"
+    "uva\n";
+
+// função auxiliar para verificar o resultado de left (coluna 1) com right (coluna 0)
+// esperado: o cabeçalho e as linhas 1, 3 e 6 da esquerda, cada uma com o seu preço
+static void check_join(const struct table *join, const char *what)
+{
+    static const char *expected[][4] = {
+        {"1", "maca", "maca", "0.5"},
+        {"3", "pera", "pera", "0.9"},
+        {"6", "maca", "maca", "0.5"}
+    };
+
+    CHECK(join != NULL, "%s: join failed", what);
+    if (!join)
+        return;
+
+    CHECK(join->num_cols == 4, "%s: %lu columns", what, (unsigned long)join->num_cols);
+    CHECK(join->num_rows == 4, "%s: %lu rows (header included), expected 4", what, (unsigned long)join->num_rows);
+    if (join->num_rows != 4 || join->num_cols != 4)
+        return;
+
+    CHECK(strcmp(cell_text(join, 0, 0), "id") == 0 && strcmp(cell_text(join, 0, 3), "preco") == 0,
+          "%s: bad header", what);
+    for (size_t i = 0; i < 3; i++)
+    {
+        for (size_t c = 0; c < 4; c++)
+            CHECK(strcmp(cell_text(join, i + 1, c), expected[i][c]) == 0, "%s: row %lu col %lu is '%s'",
+                  what, (unsigned long)i + 1, (unsigned long)c, cell_text(join, i + 1, c));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char left_file[1024], right_file[1024], sample_file[1024], origins_file[1024];
+    snprintf(left_file, sizeof(left_file), "%s_left.csv", argv[1]);
+    snprintf(right_file, sizeof(right_file), "%s_right.csv", argv[1]);
+    snprintf(sample_file, sizeof(sample_file), "%s_sample.csv", argv[1]);
+    snprintf(origins_file, sizeof(origins_file), "%s_origins.csv", argv[1]);
+    if (write_file(left_file, left_csv) != 0 || write_file(right_file, right_csv) != 0 ||
+        write_sample_csv(sample_file, SAMPLE_ROWS) != 0 || write_file(origins_file, origins_csv) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", argv[1]);
+        return 1;
+    }
+
+    struct table *left = table_load_csv(left_file);
+    struct table *right = table_load_csv(right_file);
+    if (!left || !right)
+    {
+        fprintf(stderr, "ERROR loading the test files\n");
+        return 1;
+    }
+
+    CHECK(table_get_row(left, 4)[1] == NULL, "row 4 should have a missing (NULL) cell");
+
+    // a tabela mais pequena (right) é a de dispersão; com uma thread e com várias
+    struct table *join = table_hash_join(left, 1, right, 0, 1);
+    check_join(join, "left-right");
+    table_free(join);
+
+    join = table_hash_join(left, 1, right, 0, 4);
+    check_join(join, "left-right, 4 threads");
+    table_free(join);
+
+    // com right maior do que left, a tabela de dispersão passa a ser a da esquerda
+    struct table *small = table_filter_range(left, 0, "1", true, "3", true, 1);
+    join = table_hash_join(small, 1, right, 0, 1);
+    CHECK(join && join->num_rows == 3, "small-right: %ld rows, expected 3", join ? (long)join->num_rows : -1L);
+    for (size_t i = 1; join && i < join->num_rows; i++)
+        CHECK(strcmp(cell_text(join, i, 1), cell_text(join, i, 2)) == 0 && !strchr(cell_text(join, i, 1), ' ') &&
+                  cell_text(join, i, 1)[0] != '\0',
+              "small-right: row %lu joins '%s' with '%s'", (unsigned long)i, cell_text(join, i, 1),
+              cell_text(join, i, 2));
+    table_free(join);
+    table_free(small);
+
+    // uma tabela com ela própria: a linha com a célula vazia não se junta consigo mesma
+    join = table_hash_join(left, 1, left, 1, 1);
+    CHECK(join && join->num_rows == 1 + 4 + 1, "self join: %ld rows, expected 6", join ? (long)join->num_rows : -1L);
+    table_free(join);
+
+    // uma tabela grande com uma pequena: cada linha com origem junta-se às linhas da sua origem
+    // (franca com duas), pela ordem da tabela grande, com 1, 2, 4 e 8 threads
+    struct table *sample = table_load_csv(sample_file);
+    struct table *origins = table_load_csv(origins_file);
+    CHECK(sample && origins, "ERROR loading the sample files");
+    if (sample && origins)
+    {
+        size_t expected_rows = 1;
+        for (size_t i = 1; i < sample->num_rows; i++)
+        {
+            const char *origin = table_get_row(sample, i)[3];
+            expected_rows += origin ? (strcmp(origin, "franca") == 0 ? 2 : 1) : 0;
+        }
+
+        struct table *serial = table_hash_join(sample, 3, origins, 0, 1);
+        CHECK(serial && serial->num_rows == expected_rows, "sample: %ld rows, expected %lu",
+              serial ? (long)serial->num_rows : -1L, (unsigned long)expected_rows);
+        for (size_t i = 1; serial && i < serial->num_rows && check_failures == 0; i++)
+            CHECK(strcmp(cell_text(serial, i, 3), cell_text(serial, i, 5)) == 0 &&
+                      atol(cell_text(serial, i, 0)) >= atol(cell_text(serial, i - 1, 0)),
+                  "sample: row %lu joins '%s' with '%s'", (unsigned long)i, cell_text(serial, i, 3),
+                  cell_text(serial, i, 5));
+
+        for (int threads = 2; threads <= 8; threads *= 2)
+        {
+            char name[64];
+            snprintf(name, sizeof(name), "sample, %d threads", threads);
+            join = table_hash_join(sample, 3, origins, 0, threads);
+            check_same_table(serial, join, name);
+            table_free(join);
+        }
+        table_free(serial);
+    }
+    table_free(sample);
+    table_free(origins);
+
+    table_free(left);
+    table_free(right);
+    remove(left_file);
+    remove(right_file);
+    remove(sample_file);
+    remove(origins_file);
+
+    return check_result();
+}
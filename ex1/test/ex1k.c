@@ -0,0 +1,100 @@
+// ex1k.c
+// Teste de regressão dos dicionários (table_dict_encode): só as colunas com poucos valores
+// distintos ficam com dicionário, as células não mudam (nem numa tabela mapeada, cujas strings
+// são copiadas e o ficheiro libertado) e os filtros por igualdade e os índices criados antes
+// continuam a dar as mesmas linhas que numa tabela sem dicionário
+#include "check.h"
+
+#define SAMPLE_ROWS 50000
+
+static const char *values[] = {"maca", "", "pera, rocha", "kiwi \"gold\"", "espanha", "nova\nzelandia", "xpto"};
+
+// função auxiliar para comparar os filtros por igualdade de encoded e de plain nas colunas 1 e 3
+static void check_filters(const struct table *encoded, const struct table *plain, const char *what)
+{
+    for (size_t col = 1; col <= 3; col += 2)
+    {
+        for (size_t k = 0; k < sizeof(values) / sizeof(values[0]); k++)
+        {
+            char name[128];
+            snprintf(name, sizeof(name), "%s, column %lu = '%s'", what, (unsigned long)col, values[k]);
+
+            struct table *fast = table_filter_equals(encoded, col, values[k], 4);
+            struct table *scan = table_filter_equals(plain, col, values[k], 1);
+            check_same_table(scan, fast, name);
+            table_free(fast);
+            table_free(scan);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *plain = table_load_csv(src_file);
+    struct table *table = table_load_csv(src_file);
+    struct table *mapped = table_load_csv_parallel(src_file, 4);
+    if (!plain || !table || !mapped)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    // os índices criados antes são reconstruídos sobre as strings copiadas
+    CHECK(table_create_index(table, 1) == 0 && table_create_ordered_index(table, 3) == 0, "index creation failed");
+    CHECK(table_dict_encode(table, 1) == 0, "dictionary encoding failed");
+
+    // id é a única coluna sem valores repetidos
+    static const bool expected_dict[] = {false, true, true, true, true};
+    for (size_t col = 0; col < table->num_cols; col++)
+        CHECK(table_has_dict(table, col) == expected_dict[col], "column %lu: dictionary %d", (unsigned long)col,
+              (int)table_has_dict(table, col));
+    CHECK(table_has_index(table, 1) && table_has_ordered_index(table, 3), "indexes lost by the encoding");
+
+    check_same_table(plain, table, "cells after encoding");
+    check_filters(table, plain, "encoded");
+
+    struct table *range = table_filter_range(table, 3, "e", true, "g", false, 1);
+    struct table *range_scan = table_filter_range(plain, 3, "e", true, "g", false, 1);
+    check_same_table(range_scan, range, "ordered index after encoding");
+    table_free(range);
+    table_free(range_scan);
+
+    // numa tabela mapeada, com 4 threads: o ficheiro deixa de ser usado
+    CHECK(table_dict_encode(mapped, 4) == 0, "dictionary encoding of the mapped table failed");
+    CHECK(mapped->map_addr == NULL, "the mapped file was not released");
+    check_same_table(plain, mapped, "mapped cells after encoding");
+    check_filters(mapped, plain, "mapped");
+
+    // uma tabela usada por uma vista ganha os dicionários, mas as strings não mudam de sítio
+    struct table *other = table_load_csv(src_file);
+    struct table *view = other ? table_filter_equals(other, 3, "franca", 1) : NULL;
+    const char *before = view ? table_get_row(view, 0)[1] : NULL;
+    CHECK(view && table_dict_encode(other, 1) == 0 && table_has_dict(other, 1), "encoding with a view failed");
+    CHECK(view && table_get_row(view, 0)[1] == before, "strings moved while a view was using them");
+    check_filters(other, plain, "with a view");
+    table_free(view);
+    table_free(other);
+
+    table_free(plain);
+    table_free(table);
+    table_free(mapped);
+    remove(src_file);
+
+    return check_result();
+}
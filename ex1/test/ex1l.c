@@ -0,0 +1,122 @@
+// ex1l.c
+// Teste de regressão das cadeias de filtros adiadas: os filtros juntos com table_expr_and e
+// calculados numa só passagem dão as mesmas linhas que os filtros aplicados um a um, e
+// table_filter_expr_first(max_rows) dá o início desse resultado (numa tabela, numa tabela com
+// tipos e dicionários e numa vista)
+#include "check.h"
+
+#define SAMPLE_ROWS 30000
+
+// passos da cadeia, como os dos comandos filter e where
+static const char *steps[] = {"C >= 10", "not B = maca", "D = portugal or E < 1", "A > 100"};
+
+static const size_t limits[] = {0, 1, 10, 4096, 1000000};
+
+// função auxiliar para comparar os primeiros max_rows resultados com o início de full
+static void check_first(const struct table *table, struct table_expr *expr, const struct table *full,
+                        const char *what)
+{
+    for (size_t k = 0; k < sizeof(limits) / sizeof(limits[0]); k++)
+    {
+        struct table *first = table_filter_expr_first(table, expr, limits[k]);
+        size_t want = limits[k] < full->num_rows ? limits[k] : full->num_rows;
+        CHECK(first && first->num_rows == want, "%s, first %lu: %ld rows, expected %lu", what,
+              (unsigned long)limits[k], first ? (long)first->num_rows : -1L, (unsigned long)want);
+
+        for (size_t i = 0; first && i < first->num_rows && i < want; i++)
+        {
+            CHECK(strcmp(cell_text(first, i, 0), cell_text(full, i, 0)) == 0, "%s, first %lu: row %lu is id %s",
+                  what, (unsigned long)limits[k], (unsigned long)i, cell_text(first, i, 0));
+            if (check_failures > 0)
+                break;
+        }
+        table_free(first);
+    }
+}
+
+// função auxiliar para aplicar os filtros um a um e depois juntos numa só expressão
+static void check_chain(const struct table *table, const char *what)
+{
+    char error[256];
+    const struct table *current = table;
+    struct table *step_result = NULL;
+    struct table_expr *chain = NULL;
+
+    for (size_t k = 0; k < sizeof(steps) / sizeof(steps[0]); k++)
+    {
+        struct table_expr *step = table_expr_parse(steps[k], table->num_cols, error, sizeof(error));
+        CHECK(step != NULL, "%s: %s", steps[k], error);
+        if (!step)
+            break;
+
+        struct table *next = table_filter(current, table_expr_match, step);
+        table_free(step_result);
+        step_result = next;
+        current = next;
+
+        chain = chain ? table_expr_and(chain, step) : step;
+        CHECK(chain != NULL, "table_expr_and failed");
+        if (!chain || !next)
+            break;
+
+        char name[128];
+        snprintf(name, sizeof(name), "%s, %lu steps", what, (unsigned long)k + 1);
+        struct table *fused = table_filter_expr(table, chain, 4);
+        check_same_table(step_result, fused, name);
+        table_free(fused);
+        check_first(table, chain, step_result, name);
+    }
+
+    table_free(step_result);
+    table_expr_free(chain);
+}
+
+static bool odd_id(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return atoi(row[0]) % 2 == 1;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    struct table *typed = table_load_csv_mmap(src_file);
+    if (!table || !typed)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    check_chain(table, "table");
+
+    CHECK(table_infer_types(typed, 4) == 0 && table_dict_encode(typed, 4) == 0, "types or dictionaries failed");
+    check_chain(typed, "typed");
+
+    struct table *view = table_filter_view(table, odd_id, NULL);
+    CHECK(view != NULL, "view failed");
+    if (view)
+        check_chain(view, "view");
+    table_free(view);
+
+    table_free(table);
+    table_free(typed);
+    remove(src_file);
+
+    return check_result();
+}
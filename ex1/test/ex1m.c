@@ -0,0 +1,64 @@
+// ex1m.c
+// Teste de regressão das tabelas carregadas com o ficheiro mapeado (table_load_csv_mmap e
+// table_load_csv_parallel): table_get_row devolve sempre células legíveis, terminadas com '\0',
+// iguais às de table_load_csv, mesmo sem table_materialize e depois de copiar só uma coluna
+#include "check.h"
+
+static const char *csv_data =
+    "nome,fruta,nota\r\n"
+    "ana,\"kiwi \"\"gold\"\"\",1\r\n"
+    "rui,\"pera, rocha\",\r\n"
+    "eva,maca\r\n"
+    ",,\r\n"
+    "\"multi\nlinha\",uva,3\r\n"
+    "ze,  laranja ,4";
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_file(src_file, csv_data) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *expected = table_load_csv(src_file);
+    if (!expected)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    struct table *mapped = table_load_csv_mmap(src_file);
+    check_same_table(expected, mapped, "mmap");
+    table_free(mapped);
+
+    struct table *parallel = table_load_csv_parallel(src_file, 4);
+    check_same_table(expected, parallel, "parallel");
+    table_free(parallel);
+
+    // um filtro copia só a coluna que lê: as outras continuam a ser lidas com table_get_row
+    mapped = table_load_csv_mmap(src_file);
+    struct table *view = mapped ? table_filter_equals(mapped, 1, "maca", 1) : NULL;
+    CHECK(view && view->num_rows == 1, "filter on mmap table: %ld rows", view ? (long)view->num_rows : -1L);
+    if (view && view->num_rows == 1)
+        CHECK(strcmp(cell_text(view, 0, 0), "eva") == 0 && table_get_row(view, 0)[2] == NULL,
+              "filter on mmap table returned '%s'", cell_text(view, 0, 0));
+    table_free(view);
+    check_same_table(expected, mapped, "mmap after filter");
+    table_free(mapped);
+
+    table_free(expected);
+    remove(src_file);
+
+    return check_result();
+}
@@ -0,0 +1,129 @@
+// ex1n.c
+// Teste de regressão dos snapshots (table_save_snapshot e table_load_snapshot): o snapshot
+// carregado (com 1 e com 4 threads) tem as mesmas células que a tabela guardada, seja ela
+// carregada com mapeamento, uma vista ou uma tabela com linhas eliminadas, e um snapshot
+// corrompido ou truncado não é carregado
+#include <unistd.h>
+#include "check.h"
+
+#define SAMPLE_ROWS 40000
+
+static bool quantity_below_50(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return row[2] && row[2][0] != '\0' && atoi(row[2]) < 50;
+}
+
+// função auxiliar para guardar table no snapshot snap_file e comparar o snapshot carregado
+static void check_snapshot(const struct table *table, const char *snap_file, const char *what)
+{
+    CHECK(table_save_snapshot(table, snap_file) > 0, "%s: save failed", what);
+    for (int threads = 1; threads <= 4; threads += 3)
+    {
+        char name[128];
+        snprintf(name, sizeof(name), "%s, %d threads", what, threads);
+        struct table *loaded = table_load_snapshot(snap_file, threads);
+        check_same_table(table, loaded, name);
+        table_free(loaded);
+    }
+}
+
+// função auxiliar para trocar o byte na posição pos do ficheiro filename (retorna 0 em sucesso)
+static int corrupt_byte(const char *filename, long pos)
+{
+    FILE *f = fopen(filename, "r+b");
+    if (!f)
+        return -1;
+
+    int result = -1;
+    int c;
+    if (fseek(f, pos, SEEK_SET) == 0 && (c = fgetc(f)) != EOF && fseek(f, pos, SEEK_SET) == 0)
+        result = fputc(c ^ 0x20, f) == EOF ? -1 : 0;
+    if (fclose(f) != 0)
+        result = -1;
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024], snap_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    snprintf(snap_file, sizeof(snap_file), "%s.snap", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    struct table *mapped = table_load_csv_mmap(src_file);
+    if (!table || !mapped)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    check_snapshot(table, snap_file, "table");
+    check_snapshot(mapped, snap_file, "mapped");
+
+    // um snapshot carregado também pode ser guardado noutro snapshot
+    struct table *loaded = table_load_snapshot(snap_file, 4);
+    char other_file[1024];
+    snprintf(other_file, sizeof(other_file), "%s_2.snap", argv[1]);
+    CHECK(loaded != NULL, "load of the snapshot failed");
+    if (loaded)
+        check_snapshot(loaded, other_file, "snapshot of a snapshot");
+    table_free(loaded);
+    remove(other_file);
+
+    // uma vista guarda só as suas linhas
+    struct table *view = table_filter_view(mapped, quantity_below_50, NULL);
+    CHECK(view != NULL, "view failed");
+    if (view)
+        check_snapshot(view, snap_file, "view");
+    table_free(view);
+
+    // as linhas eliminadas não ficam no snapshot
+    CHECK(table_delete_row(table, 1) == 0 && table_delete_range(table, 100, 5000) == 5000 &&
+              table_delete_where(table, quantity_below_50, NULL) > 0, "deletes failed");
+    check_snapshot(table, snap_file, "after deletes");
+
+    // um byte trocado no cabeçalho, nos offsets ou nas strings invalida o snapshot
+    static const long positions[] = {0, 20, 4096 + 8, -100};
+    for (size_t k = 0; k < sizeof(positions) / sizeof(positions[0]); k++)
+    {
+        CHECK(table_save_snapshot(table, snap_file) > 0, "save failed");
+        FILE *f = fopen(snap_file, "rb");
+        long size = f && fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+        if (f)
+            fclose(f);
+
+        long pos = positions[k] < 0 ? size + positions[k] : positions[k];
+        CHECK(corrupt_byte(snap_file, pos) == 0, "could not change byte %ld", pos);
+        loaded = table_load_snapshot(snap_file, 4);
+        CHECK(loaded == NULL, "loaded a snapshot with byte %ld changed", pos);
+        table_free(loaded);
+    }
+
+    // um snapshot truncado ou que não é um snapshot também não
+    CHECK(table_save_snapshot(table, snap_file) > 0 && truncate(snap_file, 4096 + 16) == 0, "truncate failed");
+    CHECK(table_load_snapshot(snap_file, 1) == NULL, "loaded a truncated snapshot");
+    CHECK(table_load_snapshot(src_file, 1) == NULL, "loaded a CSV file as a snapshot");
+    CHECK(table_load_snapshot(other_file, 1) == NULL, "loaded a missing snapshot");
+
+    table_free(mapped);
+    table_free(table);
+    remove(src_file);
+    remove(snap_file);
+
+    return check_result();
+}
@@ -0,0 +1,112 @@
+// ex1o.c
+// Teste de regressão do índice ordenado (table_create_ordered_index): table_filter_range com
+// índice dá as mesmas linhas, pela mesma ordem, que sem índice, para intervalos numéricos e de
+// strings, com e sem limites inclusivos, com só um limite, na tabela e numa vista
+#include "check.h"
+
+#define SAMPLE_ROWS 30000
+
+// intervalo de teste de table_filter_range
+struct range
+{
+    size_t col;
+    const char *low;
+    bool low_inclusive;
+    const char *high;
+    bool high_inclusive;
+};
+
+static const struct range ranges[] = {
+    {0, "100", true, "200", false},  // id: inteiros, todos diferentes
+    {0, NULL, false, "10", true},
+    {0, "29990", false, NULL, false},
+    {2, "20", true, "40", true},     // quantidade: inteiros, com células vazias
+    {2, "99", false, NULL, false},   // intervalo vazio
+    {4, "1.5", false, "2.25", true}, // preco: decimais, com células em falta
+    {4, NULL, false, "0.1", false},
+    {1, "k", true, "p", false},      // fruta: strings (ordem de strcmp)
+    {1, NULL, false, "b", false},
+    {3, "franca", true, "franca", true}
+};
+
+// função auxiliar para comparar os filtros por intervalo de indexed (com índices ordenados) e de
+// plain (sem índices)
+static void check_ranges(const struct table *indexed, const struct table *plain, const char *what)
+{
+    for (size_t k = 0; k < sizeof(ranges) / sizeof(ranges[0]); k++)
+    {
+        const struct range *r = &ranges[k];
+        char name[128];
+        snprintf(name, sizeof(name), "%s, range %lu", what, (unsigned long)k);
+
+        CHECK(table_has_ordered_index(indexed, r->col), "%s: no ordered index", name);
+        struct table *fast = table_filter_range(indexed, r->col, r->low, r->low_inclusive, r->high,
+                                                r->high_inclusive, 1);
+        struct table *scan = table_filter_range(plain, r->col, r->low, r->low_inclusive, r->high,
+                                                r->high_inclusive, 4);
+        check_same_table(scan, fast, name);
+        table_free(fast);
+        table_free(scan);
+    }
+}
+
+static bool even_id(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return atoi(row[0]) % 2 == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    struct table *plain = table_load_csv(src_file);
+    if (!table || !plain)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    for (size_t col = 0; col < table->num_cols; col++)
+        CHECK(table_create_ordered_index(table, col) == 0, "ordered index on column %lu failed", (unsigned long)col);
+    check_ranges(table, plain, "table");
+
+    // o intervalo de um número é exato: 10 <= id <= 10 é só a linha 10
+    struct table *one = table_filter_range(table, 0, "10", true, "10", true, 1);
+    CHECK(one && one->num_rows == 1 && strcmp(cell_text(one, 0, 0), "10") == 0, "id 10 not found");
+    table_free(one);
+
+    // índices ordenados sobre uma vista
+    struct table *view = table_filter_view(table, even_id, NULL);
+    struct table *plain_view = table_filter_view(plain, even_id, NULL);
+    for (size_t col = 0; view && col < view->num_cols; col++)
+        CHECK(table_create_ordered_index(view, col) == 0, "ordered index on the view failed");
+    check_ranges(view, plain_view, "view");
+
+    // com os tipos inferidos, os intervalos numéricos usam os valores convertidos
+    CHECK(table_infer_types(plain, 1) == 0, "type inference failed");
+    check_ranges(table, plain, "typed");
+
+    table_free(view);
+    table_free(plain_view);
+    table_free(table);
+    table_free(plain);
+    remove(src_file);
+
+    return check_result();
+}
@@ -0,0 +1,56 @@
+// ex1p.c
+// Versão em streaming de ex1f: filtra o ficheiro diretamente para o destino,
+// sem carregar a tabela em memória (leitura, filtragem e escrita em threads diferentes)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "table.h"
+
+#define PRICE_COL 4
+
+bool price_lower_than_one_euro(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    int price_col_index = *(int *)context;
+
+    if (!row[price_col_index])
+        return false;
+
+    double price = atof(row[price_col_index]);
+
+    return price < 1.0;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: ficheiro destino (a criar)
+    // argv[2]: ficheiro fonte (a ler)
+    // argv[3]: índice da coluna do preço (opcional)
+    if (argc != 3 && argc != 4)
+    {
+        fprintf(stderr, "Please do: %s <dest_file> <src_file> [price_col]\n", argv[0]);
+        return 1;
+    }
+
+    const char *dest_file = argv[1];
+    const char *src_file = argv[2];
+    int price_col = argc == 4 ? atoi(argv[3]) : PRICE_COL;
+
+    if (price_col < 0 || price_col >= MAX_COLS)
+    {
+        fprintf(stderr, "Invalid price column %d\n", price_col);
+        return 1;
+    }
+
+    long rows = table_filter_csv(src_file, dest_file, price_lower_than_one_euro, &price_col);
+    if (rows < 0)
+    {
+        fprintf(stderr, "ERROR filtering %s into %s\n", src_file, dest_file);
+        return 1;
+    }
+
+    printf("%ld rows written to %s\n", rows, dest_file);
+
+    return 0;
+}
\ No newline at end of file
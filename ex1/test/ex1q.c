@@ -0,0 +1,83 @@
+// ex1q.c
+// Teste de regressão do gerador dos benchmarks (bench/csvgen): a mesma semente dá o mesmo
+// ficheiro e outra semente dá outro, o ficheiro tem as linhas e colunas pedidas, com campos entre
+// aspas e colunas numéricas no fim, e guardá-lo depois de o carregar dá o mesmo ficheiro
+// (tem de ser executado na pasta ex1, onde está bench/csvgen)
+#include "check.h"
+
+#define GEN_ROWS 30000
+#define GEN_COLS 6
+
+// função auxiliar para gerar filename com o csvgen e a semente seed (retorna 0 em sucesso)
+static int generate(const char *filename, int seed)
+{
+    char command[2048];
+    snprintf(command, sizeof(command), "./bench/csvgen rows=%d cols=%d quote=0.2 numeric=0.5 seed=%d out=%s",
+             GEN_ROWS, GEN_COLS, seed, filename);
+    return system(command) == 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char first_file[1024], second_file[1024];
+    snprintf(first_file, sizeof(first_file), "%s.csv", argv[1]);
+    snprintf(second_file, sizeof(second_file), "%s_2.csv", argv[1]);
+    if (generate(first_file, 7) != 0)
+    {
+        fprintf(stderr, "ERROR generating %s\n", first_file);
+        return 1;
+    }
+
+    char *first = read_file(first_file);
+    char *second = generate(second_file, 7) == 0 ? read_file(second_file) : NULL;
+    CHECK(first && second && strcmp(first, second) == 0, "the same seed gave different files");
+    free(second);
+    second = generate(second_file, 8) == 0 ? read_file(second_file) : NULL;
+    CHECK(first && second && strcmp(first, second) != 0, "another seed gave the same file");
+    free(second);
+
+    struct table *table = table_load_csv(first_file);
+    if (!first || !table)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", first_file);
+        return 1;
+    }
+
+    CHECK(table->num_rows == GEN_ROWS + 1 && table->num_cols == GEN_COLS, "table is %lu x %lu",
+          (unsigned long)table->num_rows, (unsigned long)table->num_cols);
+
+    // metade das colunas são de texto (algumas com vírgulas ou aspas), as outras numéricas
+    size_t quoted = 0;
+    for (size_t i = 1; i < table->num_rows; i++)
+        for (size_t c = 0; c < GEN_COLS / 2; c++)
+            quoted += strpbrk(cell_text(table, i, c), ",\"") != NULL;
+    CHECK(quoted > 0, "no quoted fields");
+
+    static const enum column_type expected_types[GEN_COLS] = {COLUMN_STRING, COLUMN_STRING, COLUMN_STRING,
+                                                              COLUMN_INT64, COLUMN_DOUBLE, COLUMN_DOUBLE};
+    CHECK(table_infer_types(table, 4) == 0, "type inference failed");
+    for (size_t c = 0; c < GEN_COLS; c++)
+        CHECK(table_column_type(table, c) == expected_types[c], "column %lu has type %d", (unsigned long)c,
+              (int)table_column_type(table, c));
+
+    // o ficheiro gerado já está na forma que table_save_csv escreve
+    CHECK(table_save_csv(table, second_file) == (long)strlen(first), "save failed");
+    second = read_file(second_file);
+    CHECK(second && strcmp(first, second) == 0, "the saved file differs from the generated one");
+
+    free(first);
+    free(second);
+    table_free(table);
+    remove(first_file);
+    remove(second_file);
+
+    return check_result();
+}
@@ -0,0 +1,70 @@
+// ex1r.c
+// Teste de regressão do leitor em streaming (table_reader): as linhas lidas uma a uma são iguais
+// às da tabela carregada com table_load_csv, incluindo as que atravessam o fim do buffer de
+// leitura, os campos entre aspas com quebras de linha e as linhas com células em falta
+#include "check.h"
+
+#define SAMPLE_ROWS 100000
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    struct table_reader *reader = table_reader_open(src_file);
+    if (!table || !reader)
+    {
+        fprintf(stderr, "ERROR opening %s\n", src_file);
+        return 1;
+    }
+
+    CHECK(table->num_rows == SAMPLE_ROWS + 1, "table has %lu rows", (unsigned long)table->num_rows);
+    CHECK(table_reader_num_cols(reader) == 0, "columns known before the first row");
+
+    size_t count = 0;
+    char **row;
+    while ((row = table_reader_next(reader)) != NULL && count < table->num_rows)
+    {
+        char **want = table_get_row(table, count);
+        for (size_t c = 0; c < table->num_cols; c++)
+        {
+            bool same = (!want[c] && !row[c]) || (want[c] && row[c] && strcmp(want[c], row[c]) == 0);
+            CHECK(same, "row %lu col %lu is '%s', expected '%s'", (unsigned long)count, (unsigned long)c,
+                  row[c] ? row[c] : "(null)", want[c] ? want[c] : "(null)");
+            if (!same)
+                break;
+        }
+        count++;
+    }
+
+    CHECK(row == NULL, "reader returned more rows than the table");
+    CHECK(!table_reader_error(reader), "reader stopped with an error");
+    CHECK(count == table->num_rows, "reader read %lu rows, expected %lu", (unsigned long)count,
+          (unsigned long)table->num_rows);
+    CHECK(table_reader_num_cols(reader) == table->num_cols, "reader has %lu columns",
+          (unsigned long)table_reader_num_cols(reader));
+
+    table_reader_close(reader);
+    table_free(table);
+
+    // um ficheiro que não existe não abre
+    CHECK(table_reader_open("/nonexistent/ex1r.csv") == NULL, "opened a missing file");
+
+    remove(src_file);
+
+    return check_result();
+}
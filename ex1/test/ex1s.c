@@ -0,0 +1,116 @@
+// ex1s.c
+// Teste de regressão da ordenação de uma vista com índices: depois de table_sort, os índices
+// criados sobre a vista têm de continuar a dar as linhas certas a table_filter_equals e a
+// table_filter_range (termina com 1 se algum resultado estiver errado)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "table.h"
+
+static const char *csv_data =
+    "fornecedor,fruta,quantidade\n"
+    "joaquim,maca,20\n"
+    "manuel,melancia,100\n"
+    "humberto,amora,10\n"
+    "joaquim,pera,35\n"
+    "ana,uva,12\n"
+    "manuel,maca,40\n"
+    "rita,pera,1\n"
+    "bruno,maca,7\n";
+
+// função auxiliar para verificar que todas as linhas da vista têm value na coluna col
+// e que são count
+static int check_equals(const struct table *view, size_t col, const char *value, size_t count)
+{
+    if (!view || view->num_rows != count)
+    {
+        fprintf(stderr, "FAIL: filter %s expected %lu rows, got %ld\n", value, (unsigned long)count,
+                view ? (long)view->num_rows : -1L);
+        return -1;
+    }
+
+    for (size_t i = 0; i < view->num_rows; i++)
+    {
+        const char *cell = table_get_row(view, i)[col];
+        if (!cell || strcmp(cell, value) != 0)
+        {
+            fprintf(stderr, "FAIL: filter %s returned row with '%s'\n", value, cell ? cell : "");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: ficheiro temporário (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_file>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(argv[1], "w");
+    if (!f || fputs(csv_data, f) == EOF || fclose(f) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", argv[1]);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(argv[1]);
+    if (!table)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", argv[1]);
+        return 1;
+    }
+
+    // vista com quantidade > 1 (tira o cabeçalho e a linha da rita), com índices sobre a vista
+    struct table *view = table_filter_range(table, 2, "1", false, NULL, false, 1);
+    if (!view || table_create_index(view, 1) != 0 || table_create_ordered_index(view, 2) != 0)
+    {
+        fprintf(stderr, "ERROR creating the view and its indexes\n");
+        return 1;
+    }
+
+    struct table_sort_key key = {0, true, SORT_STRING};
+    if (table_sort(view, &key, 1, 1) != 0)
+    {
+        fprintf(stderr, "ERROR sorting the view\n");
+        return 1;
+    }
+
+    int result = 0;
+
+    struct table *maca = table_filter_equals(view, 1, "maca", 1);
+    if (check_equals(maca, 1, "maca", 3) != 0)
+        result = 1;
+    table_free(maca);
+
+    struct table *pera = table_filter_equals(view, 1, "pera", 1);
+    if (check_equals(pera, 1, "pera", 1) != 0)
+        result = 1;
+    table_free(pera);
+
+    // quantidade >= 35: só 100, 35 e 40
+    struct table *big = table_filter_range(view, 2, "35", true, NULL, false, 1);
+    if (!big || big->num_rows != 3)
+        result = 1;
+    for (size_t i = 0; big && i < big->num_rows; i++)
+    {
+        if (atoi(table_get_row(big, i)[2]) < 35)
+        {
+            fprintf(stderr, "FAIL: range returned quantity %s\n", table_get_row(big, i)[2]);
+            result = 1;
+        }
+    }
+    table_free(big);
+
+    table_free(view);
+    table_free(table);
+    remove(argv[1]);
+
+    printf(result == 0 ? "OK\n" : "FAILED\n");
+    return result;
+}
@@ -0,0 +1,74 @@
+// ex1t.c
+// Teste de regressão do filtro paralelo (table_filter_parallel): com 1, 2, 4 e 7 threads, o
+// resultado tem as mesmas linhas, pela mesma ordem, que o filtro numa só thread
+// (a tabela tem várias partes de FILTER_MIN_PART_ROWS linhas, para as threads dividirem o trabalho)
+#include "check.h"
+
+#define SAMPLE_ROWS (FILTER_MIN_PART_ROWS * 12 + 123)
+
+static bool odd_quantity_or_empty_fruit(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return (row[2] && atoi(row[2]) % 2 == 1) || (row[1] && row[1][0] == '\0');
+}
+
+static bool empty_fruit(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return row[1] && row[1][0] == '\0';
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    if (!table)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    struct table *serial = table_filter_view(table, odd_quantity_or_empty_fruit, NULL);
+    struct table *serial_empty = serial ? table_filter_view(serial, empty_fruit, NULL) : NULL;
+    CHECK(serial && serial->num_rows > SAMPLE_ROWS / 4, "serial filter kept %ld rows",
+          serial ? (long)serial->num_rows : -1L);
+    CHECK(serial_empty && serial_empty->num_rows > 0, "serial filter of the view kept no rows");
+
+    static const int threads[] = {1, 2, 4, 7};
+    for (size_t k = 0; k < sizeof(threads) / sizeof(threads[0]); k++)
+    {
+        char what[64];
+        snprintf(what, sizeof(what), "%d threads", threads[k]);
+
+        struct table *parallel = table_filter_parallel(table, odd_quantity_or_empty_fruit, NULL, threads[k]);
+        check_same_table(serial, parallel, what);
+        table_free(parallel);
+
+        // o filtro paralelo de uma vista também mantém a ordem das linhas
+        parallel = table_filter_parallel(serial, empty_fruit, NULL, threads[k]);
+        check_same_table(serial_empty, parallel, what);
+        table_free(parallel);
+    }
+
+    table_free(serial_empty);
+    table_free(serial);
+    table_free(table);
+    remove(src_file);
+
+    return check_result();
+}
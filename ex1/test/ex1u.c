@@ -0,0 +1,119 @@
+// ex1u.c
+// Teste de regressão da contagem de memória (table_memory_usage): as strings e a matriz de
+// células correspondem ao conteúdo da tabela, os índices, os tipos e as linhas eliminadas contam
+// como metadados (até compactar), e uma vista conta a tabela de origem, a sua seleção e os seus
+// próprios índices
+#include "check.h"
+
+#define SAMPLE_ROWS 30000
+
+static bool even_id(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return atoi(row[0]) % 2 == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    struct table *mapped = table_load_csv_mmap(src_file);
+    if (!table || !mapped)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    // as strings das células (com o '\0') cabem nos blocos da arena
+    size_t text = 0;
+    for (size_t i = 0; i < table->num_rows; i++)
+        for (size_t c = 0; c < table->num_cols; c++)
+            text += table_get_row(table, i)[c] ? strlen(table_get_row(table, i)[c]) + 1 : 0;
+
+    struct table_memory mem;
+    table_memory_usage(table, &mem);
+    CHECK(mem.cell_strings >= text && mem.cell_strings < text * 2, "cell strings: %lu bytes for %lu of text",
+          (unsigned long)mem.cell_strings, (unsigned long)text);
+    CHECK(mem.row_pointers == table->num_rows * table->num_cols * sizeof(char *), "row pointers: %lu bytes",
+          (unsigned long)mem.row_pointers);
+    CHECK(mem.selection == 0 && mem.metadata == 0, "a plain table has selection or metadata");
+
+    // numa tabela mapeada, o ficheiro conta nas strings
+    struct table_memory mapped_mem;
+    table_memory_usage(mapped, &mapped_mem);
+    CHECK(mapped_mem.cell_strings >= mapped->map_size && mapped->map_size > 0, "mapped strings: %lu bytes",
+          (unsigned long)mapped_mem.cell_strings);
+
+    // cada índice ou tipo acrescenta metadados, e só metadados
+    struct table_memory before = mem;
+    CHECK(table_create_index(table, 1) == 0, "index creation failed");
+    table_memory_usage(table, &mem);
+    CHECK(mem.metadata > before.metadata && mem.cell_strings == before.cell_strings &&
+              mem.row_pointers == before.row_pointers, "hash index: metadata %lu", (unsigned long)mem.metadata);
+
+    before = mem;
+    CHECK(table_create_ordered_index(table, 2) == 0, "ordered index creation failed");
+    table_memory_usage(table, &mem);
+    CHECK(mem.metadata >= before.metadata + (SAMPLE_ROWS + 1) * sizeof(uint32_t), "ordered index: metadata %lu",
+          (unsigned long)mem.metadata);
+
+    before = mem;
+    CHECK(table_infer_types(table, 1) == 0, "type inference failed");
+    table_memory_usage(table, &mem);
+    CHECK(mem.metadata > before.metadata, "types: metadata %lu", (unsigned long)mem.metadata);
+
+    // uma vista conta a tabela de origem, a seleção e os seus próprios índices
+    struct table_memory base_mem = mem;
+    struct table *view = table_filter_view(table, even_id, NULL);
+    CHECK(view != NULL, "view failed");
+    if (view)
+    {
+        table_memory_usage(view, &mem);
+        CHECK(mem.cell_strings == base_mem.cell_strings && mem.row_pointers == base_mem.row_pointers &&
+                  mem.metadata == base_mem.metadata, "view: the source table is not counted");
+        CHECK(mem.selection == view->num_rows * sizeof(uint32_t), "view: selection %lu bytes for %lu rows",
+              (unsigned long)mem.selection, (unsigned long)view->num_rows);
+
+        CHECK(table_create_index(view, 3) == 0, "index on the view failed");
+        table_memory_usage(view, &mem);
+        CHECK(mem.metadata > base_mem.metadata, "view index: metadata %lu", (unsigned long)mem.metadata);
+        table_memory_usage(table, &mem);
+        CHECK(mem.metadata == base_mem.metadata, "the view index was counted in the source table");
+    }
+    table_free(view);
+
+    // as linhas eliminadas contam até a tabela ser compactada
+    CHECK(table_delete_range(table, 1, 1000) == 1000, "delete failed");
+    table_memory_usage(table, &mem);
+    CHECK(mem.metadata > base_mem.metadata, "deletes: metadata %lu", (unsigned long)mem.metadata);
+
+    CHECK(table_compact(table) == 0, "compaction failed");
+    table_memory_usage(table, &mem);
+    CHECK(mem.metadata < base_mem.metadata && mem.row_pointers < base_mem.row_pointers,
+          "after compaction: metadata %lu, row pointers %lu", (unsigned long)mem.metadata,
+          (unsigned long)mem.row_pointers);
+    // a matriz não encolhe: as linhas removidas passam a espaço reservado
+    CHECK(mem.row_pointers == table->num_rows * table->num_cols * sizeof(char *) &&
+              mem.row_pointers + mem.pointer_slack >= base_mem.row_pointers, "row pointers after compaction");
+
+    table_free(mapped);
+    table_free(table);
+    remove(src_file);
+
+    return check_result();
+}
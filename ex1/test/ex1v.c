@@ -0,0 +1,89 @@
+// ex1v.c
+// Teste de regressão das vistas (table_filter_view): uma vista tem as mesmas linhas que a cópia
+// de table_filter, mantém a tabela de origem viva, pode ser filtrada de novo e guardada, e
+// eliminar uma linha da vista não a tira da tabela de origem
+#include "check.h"
+
+#define SAMPLE_ROWS 20000
+
+static bool fruit_equals(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return row[1] && strcmp(row[1], (const char *)context) == 0;
+}
+
+static bool quantity_above(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return row[2] && row[2][0] != '\0' && atoi(row[2]) > *(const int *)context;
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024], view_file[1024], copy_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    snprintf(view_file, sizeof(view_file), "%s_view.csv", argv[1]);
+    snprintf(copy_file, sizeof(copy_file), "%s_copy.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    if (!table)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    struct table *copy = table_filter(table, fruit_equals, "maca");
+    struct table *view = table_filter_view(table, fruit_equals, "maca");
+    CHECK(copy && copy->num_rows > 0, "the filter returned no rows");
+    CHECK(view && view->source == table, "the view does not point to its source");
+    check_same_table(copy, view, "view vs copy");
+
+    // a tabela de origem usada por vistas não pode ser ordenada
+    struct table_sort_key key = {0, true, SORT_NUMERIC};
+    CHECK(table_sort(table, &key, 1, 1) != 0, "sorted a table used by a view");
+
+    // a vista guarda o mesmo ficheiro que a cópia
+    CHECK(table_save_csv(view, view_file) >= 0 && table_save_csv(copy, copy_file) >= 0, "save failed");
+    char *view_data = read_file(view_file);
+    char *copy_data = read_file(copy_file);
+    CHECK(view_data && copy_data && strcmp(view_data, copy_data) == 0, "saved view differs from the copy");
+    free(view_data);
+    free(copy_data);
+
+    // a vista continua válida depois de a tabela ser libertada, e pode ser filtrada de novo
+    size_t total_rows = table->num_rows;
+    table_free(table);
+    int limit = 50;
+    struct table *narrow = table_filter_view(view, quantity_above, &limit);
+    struct table *narrow_copy = table_filter(copy, quantity_above, &limit);
+    check_same_table(narrow_copy, narrow, "view of a view");
+    CHECK(narrow && narrow->source == view->source, "a view of a view should point to the base table");
+
+    // eliminar uma linha da vista só a tira da vista
+    table_free(narrow);
+    size_t view_rows = view->num_rows;
+    CHECK(table_delete_row(view, 0) == 0 && view->num_rows == view_rows - 1, "delete on the view failed");
+    CHECK(view->source->num_rows == total_rows, "delete on the view changed the source table");
+
+    table_free(narrow_copy);
+    table_free(view);
+    table_free(copy);
+    remove(src_file);
+    remove(view_file);
+    remove(copy_file);
+
+    return check_result();
+}
@@ -0,0 +1,115 @@
+// ex1w.c
+// Teste de regressão da escrita do CSV (table_save_csv e table_save_csv_parallel): carregar o
+// ficheiro guardado e voltar a guardá-lo dá o mesmo ficheiro, byte a byte, com e sem mapeamento e
+// com qualquer número de threads, e o ficheiro de uma vista é igual ao da vista copiada
+#include "check.h"
+
+#define SAMPLE_ROWS (SAVE_CHUNK_ROWS * 5 + 321)
+
+static bool odd_quantity(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return row[2] && atoi(row[2]) % 2 == 1;
+}
+
+// função auxiliar para guardar table em dest_file com num_threads threads (0: table_save_csv) e
+// comparar o ficheiro com expected
+static void check_save(const struct table *table, int num_threads, const char *dest_file, const char *expected,
+                       const char *what)
+{
+    long bytes = num_threads == 0 ? table_save_csv(table, dest_file)
+                                  : table_save_csv_parallel(table, dest_file, num_threads);
+    char *saved = read_file(dest_file);
+    CHECK(saved && bytes == (long)strlen(expected) && strcmp(saved, expected) == 0,
+          "%s, %d threads: %ld bytes differ from the %lu expected", what, num_threads, bytes,
+          (unsigned long)strlen(expected));
+    free(saved);
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024], dest_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    snprintf(dest_file, sizeof(dest_file), "%s_out.csv", argv[1]);
+    char *original = write_sample_csv(src_file, SAMPLE_ROWS) == 0 ? read_file(src_file) : NULL;
+    if (!original)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *table = table_load_csv(src_file);
+    struct table *mapped = table_load_csv_mmap(src_file);
+    if (!table || !mapped)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    // a escrita de referência: as células em falta das linhas curtas ficam vazias, o resto fica
+    // como no ficheiro (só os campos com vírgulas, aspas ou quebras de linha vão entre aspas)
+    char *canonical = table_save_csv(table, dest_file) > 0 ? read_file(dest_file) : NULL;
+    struct table *reloaded = canonical ? table_load_csv(dest_file) : NULL;
+    CHECK(reloaded && strlen(canonical) == strlen(original) + 2 * (SAMPLE_ROWS / 97),
+          "save of the table failed");
+    if (!reloaded)
+        return check_result();
+
+    for (size_t i = 0; i < table->num_rows && check_failures == 0; i++)
+        for (size_t c = 0; c < table->num_cols; c++)
+        {
+            const char *want = table_get_row(table, i)[c];
+            CHECK(strcmp(cell_text(reloaded, i, c), want ? want : "") == 0, "cell %lu,%lu is '%s'",
+                  (unsigned long)i, (unsigned long)c, cell_text(reloaded, i, c));
+        }
+
+    // guardar o que foi carregado dá o mesmo ficheiro, byte a byte, com qualquer número de threads
+    static const int threads[] = {0, 1, 2, 4, 7};
+    for (size_t k = 0; k < sizeof(threads) / sizeof(threads[0]); k++)
+    {
+        check_save(table, threads[k], dest_file, canonical, "table");
+        check_save(mapped, threads[k], dest_file, canonical, "mapped");
+        check_save(reloaded, threads[k], dest_file, canonical, "reloaded");
+    }
+    table_free(reloaded);
+
+    // uma vista guarda as mesmas linhas que a sua cópia (com células do ficheiro mapeado)
+    struct table *copy = table_filter(table, odd_quantity, NULL);
+    struct table *view = table_filter_view(mapped, odd_quantity, NULL);
+    CHECK(copy && view && copy->num_rows > SAVE_CHUNK_ROWS, "filters failed");
+    long bytes = copy ? table_save_csv(copy, dest_file) : -1;
+    char *expected = bytes >= 0 ? read_file(dest_file) : NULL;
+    CHECK(expected != NULL, "save of the copy failed");
+    if (expected)
+    {
+        for (size_t k = 0; k < sizeof(threads) / sizeof(threads[0]); k++)
+            check_save(view, threads[k], dest_file, expected, "view");
+
+        // e o ficheiro guardado volta a dar o mesmo ficheiro
+        reloaded = table_load_csv(dest_file);
+        CHECK(reloaded != NULL, "load of the saved view failed");
+        if (reloaded)
+            check_save(reloaded, 4, dest_file, expected, "reloaded view");
+        table_free(reloaded);
+    }
+
+    free(expected);
+    free(canonical);
+    free(original);
+    table_free(view);
+    table_free(copy);
+    table_free(mapped);
+    table_free(table);
+    remove(src_file);
+    remove(dest_file);
+
+    return check_result();
+}
@@ -0,0 +1,124 @@
+// ex1x.c
+// Teste de regressão das eliminações (table_delete_row, table_delete_range, table_delete_where e
+// table_compact): depois de eliminar linhas, a tabela e os filtros com índice hash e índice
+// ordenado dão as mesmas linhas que uma tabela sem essas linhas, antes e depois de compactar
+#include "check.h"
+
+#define SAMPLE_ROWS 20000
+
+static bool deleted[SAMPLE_ROWS + 1]; // linhas eliminadas, pelo id
+
+static bool not_deleted(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    int id = atoi(row[0]);
+    return id == 0 || !deleted[id];
+}
+
+static bool id_multiple_of_seven(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    return atoi(row[0]) % 7 == 0 && atoi(row[0]) > 0;
+}
+
+// função auxiliar para marcar como eliminadas as count linhas a partir da linha first da tabela
+static void mark_deleted(const struct table *table, size_t first, size_t count)
+{
+    for (size_t i = first; i < first + count && i < table->num_rows; i++)
+        deleted[atoi(table_get_row(table, i)[0])] = true;
+}
+
+// função auxiliar para comparar a tabela com eliminações e os seus filtros com os da tabela
+// expected, sem as linhas eliminadas
+static void check_deletes(const struct table *table, const struct table *expected, const char *what)
+{
+    char name[128];
+    check_same_table(expected, table, what);
+
+    static const char *fruits[] = {"maca", "", "pera, rocha", "uva"};
+    for (size_t k = 0; k < sizeof(fruits) / sizeof(fruits[0]); k++)
+    {
+        snprintf(name, sizeof(name), "%s, fruit = '%s'", what, fruits[k]);
+        struct table *fast = table_filter_equals(table, 1, fruits[k], 1);
+        struct table *scan = table_filter_equals(expected, 1, fruits[k], 1);
+        check_same_table(scan, fast, name);
+        table_free(fast);
+        table_free(scan);
+    }
+
+    snprintf(name, sizeof(name), "%s, 10 <= quantity < 30", what);
+    struct table *fast = table_filter_range(table, 2, "10", true, "30", false, 1);
+    struct table *scan = table_filter_range(expected, 2, "10", true, "30", false, 1);
+    check_same_table(scan, fast, name);
+    table_free(fast);
+    table_free(scan);
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *plain = table_load_csv(src_file);
+    struct table *table = table_load_csv(src_file);
+    if (!plain || !table)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    CHECK(table_create_index(table, 1) == 0 && table_create_ordered_index(table, 2) == 0, "index creation failed");
+
+    // linhas soltas (a última, a primeira de dados e do meio), um intervalo e as que satisfazem
+    // um predicado; as posições seguintes já contam com as linhas eliminadas antes
+    size_t singles[] = {SAMPLE_ROWS, 1, 500, 500, 7777};
+    for (size_t k = 0; k < sizeof(singles) / sizeof(singles[0]); k++)
+    {
+        mark_deleted(table, singles[k], 1);
+        CHECK(table_delete_row(table, singles[k]) == 0, "delete of row %lu failed", (unsigned long)singles[k]);
+    }
+
+    mark_deleted(table, 1000, 2500);
+    CHECK(table_delete_range(table, 1000, 2500) == 2500, "delete of a range failed");
+
+    for (size_t id = 7; id <= SAMPLE_ROWS; id += 7)
+        deleted[id] = true;
+    long count = table_delete_where(table, id_multiple_of_seven, NULL);
+    CHECK(count > 0, "delete where deleted %ld rows", count);
+
+    struct table *expected = table_filter(plain, not_deleted, NULL);
+    CHECK(expected && table->num_rows == expected->num_rows, "table has %lu rows, expected %ld",
+          (unsigned long)table->num_rows, expected ? (long)expected->num_rows : -1L);
+    CHECK(table_delete_row(table, table->num_rows) != 0, "deleted a row past the end");
+
+    check_deletes(table, expected, "before compaction");
+    CHECK(table_compact(table) == 0, "compaction failed");
+    check_deletes(table, expected, "after compaction");
+
+    // o índice continua a ser mantido depois de compactar
+    mark_deleted(table, 2, 3);
+    CHECK(table_delete_range(table, 2, 3) == 3, "delete after compaction failed");
+    table_free(expected);
+    expected = table_filter(plain, not_deleted, NULL);
+    check_deletes(table, expected, "second round");
+
+    table_free(expected);
+    table_free(plain);
+    table_free(table);
+    remove(src_file);
+
+    return check_result();
+}
@@ -0,0 +1,91 @@
+// ex1y.c
+// Teste de regressão da inferência de tipos (table_infer_types): cada coluna fica com o tipo
+// certo, com 1 e com 4 threads, e os valores convertidos de cada célula são iguais aos do texto
+// (as células vazias, em falta e o cabeçalho não têm valor)
+#include "check.h"
+
+#define SAMPLE_ROWS 50000
+
+static const enum column_type expected_types[] = {COLUMN_INT64, COLUMN_STRING, COLUMN_INT64, COLUMN_STRING,
+                                                   COLUMN_DOUBLE};
+
+// função auxiliar para verificar os tipos e os valores de uma tabela com os tipos inferidos
+static void check_types(const struct table *table, const char *what)
+{
+    for (size_t col = 0; col < table->num_cols; col++)
+        CHECK(table_column_type(table, col) == expected_types[col], "%s: column %lu has type %d", what,
+              (unsigned long)col, (int)table_column_type(table, col));
+
+    for (size_t i = 0; i < table->num_rows; i++)
+    {
+        char **row = table_get_row(table, i);
+        int64_t integer;
+        double number;
+
+        // id: inteiro em todas as linhas menos no cabeçalho
+        bool has_id = table_get_int64(table, i, 0, &integer);
+        CHECK(has_id == (i > 0) && (!has_id || integer == atoll(row[0])), "%s: row %lu id", what, (unsigned long)i);
+
+        // quantidade: sem valor nas células vazias
+        bool has_quantity = table_get_int64(table, i, 2, &integer);
+        bool quantity_text = i > 0 && row[2] && row[2][0] != '\0';
+        CHECK(has_quantity == quantity_text && (!has_quantity || integer == atoll(row[2])),
+              "%s: row %lu quantity '%s'", what, (unsigned long)i, cell_text(table, i, 2));
+
+        // preco: sem valor nas células em falta; table_get_int64 não lê colunas double
+        bool has_price = table_get_double(table, i, 4, &number);
+        bool price_text = i > 0 && row[4];
+        CHECK(has_price == price_text && (!has_price || number == strtod(row[4], NULL)),
+              "%s: row %lu price '%s'", what, (unsigned long)i, cell_text(table, i, 4));
+        CHECK(!table_get_int64(table, i, 4, &integer), "%s: row %lu read a double as int64", what,
+              (unsigned long)i);
+
+        // fruta: coluna de strings, sem valores
+        CHECK(!table_get_double(table, i, 1, &number), "%s: row %lu read a string as a number", what,
+              (unsigned long)i);
+        if (check_failures > 0)
+            return;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // argv[0]: nome do programa
+    // argv[1]: prefixo dos ficheiros temporários (a criar)
+    if (argc != 2)
+    {
+        fprintf(stderr, "Please do: %s <tmp_prefix>\n", argv[0]);
+        return 1;
+    }
+
+    char src_file[1024];
+    snprintf(src_file, sizeof(src_file), "%s.csv", argv[1]);
+    if (write_sample_csv(src_file, SAMPLE_ROWS) != 0)
+    {
+        fprintf(stderr, "ERROR writing %s\n", src_file);
+        return 1;
+    }
+
+    struct table *serial = table_load_csv(src_file);
+    struct table *parallel = table_load_csv_parallel(src_file, 4);
+    if (!serial || !parallel)
+    {
+        fprintf(stderr, "ERROR loading file %s\n", src_file);
+        return 1;
+    }
+
+    // antes da inferência, todas as colunas são strings
+    CHECK(table_column_type(serial, 0) == COLUMN_STRING, "types before inference");
+
+    CHECK(table_infer_types(serial, 1) == 0, "type inference with 1 thread failed");
+    check_types(serial, "1 thread");
+
+    CHECK(table_infer_types(parallel, 4) == 0, "type inference with 4 threads failed");
+    check_types(parallel, "4 threads");
+
+    table_free(serial);
+    table_free(parallel);
+    remove(src_file);
+
+    return check_result();
+}
@@ -1,34 +1,26 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <sys/stat.h>
 #include <ctype.h>
 #include "../table/table.h"
 #include <stdbool.h>
 
 struct table *current_table = NULL;
 
-#define MAX_CMD_LEN 1024
+// Filtro pendente sobre a tabela atual: filter e where só juntam condições (com and) a esta
+// expressão, que é avaliada numa só passagem quando as linhas são precisas (apply_pending_filter)
+struct table_expr *pending_filter = NULL;
+int pending_conditions = 0;
 
-// Estrutura para passar dados ao filtro
-struct filter_ctx
-{
-    int col_idx;       // Índice da coluna a verificar
-    char *search_term; // Texto que queremos encontrar
-};
+// Número de threads usado pelos comandos (alterado com o comando threads)
+int num_threads = 1;
 
-// Função Predicado: Retorna true se a linha deve ser mantida
-bool filter_equals(const void *row_ptr, const void *context)
-{
-    char **row = (char **)row_ptr;
-    const struct filter_ctx *ctx = (const struct filter_ctx *)context;
-
-    if (!row[ctx->col_idx])
-        return false;
+#define MAX_CMD_LEN 1024
 
-    // Compara o conteúdo da célula com o termo de pesquisa
-    // strcmp retorna 0 se forem iguais
-    return strcmp(row[ctx->col_idx], ctx->search_term) == 0;
-}
+// Número máximo de colunas do comando sort
+#define MAX_SORT_KEYS 16
 
 int get_col_index(char c)
 {
@@ -46,6 +38,194 @@ void clear_current_table()
         table_free(current_table);
         current_table = NULL;
     }
+
+    // o filtro pendente é sobre a tabela que saiu
+    table_expr_free(pending_filter);
+    pending_filter = NULL;
+    pending_conditions = 0;
+}
+
+// Junta uma condição ao filtro pendente (que fica com expr)
+void add_pending_filter(struct table_expr *expr)
+{
+    struct table_expr *combined = pending_filter ? table_expr_and(pending_filter, expr) : expr;
+    if (!combined)
+    {
+        printf("Error: Filter failed (memory or internal error).\n");
+        table_expr_free(expr);
+        return;
+    }
+
+    pending_filter = combined;
+    pending_conditions++;
+    printf("Filter added (%d pending). Rows are filtered in one scan when needed.\n", pending_conditions);
+}
+
+// Aplica o filtro pendente à tabela atual, numa só passagem por todas as condições
+// (antes dos comandos que precisam das linhas todas); retorna false em erro
+bool apply_pending_filter()
+{
+    if (!pending_filter)
+        return true;
+
+    struct table *new_table = table_filter_expr(current_table, pending_filter, num_threads);
+    if (!new_table)
+    {
+        printf("Error: Filter failed (memory or internal error).\n");
+        return false;
+    }
+
+    printf("Filter applied (%d condition%s in one scan). Rows reduced from %lu to %lu.\n", pending_conditions,
+           pending_conditions > 1 ? "s" : "", (unsigned long)current_table->num_rows,
+           (unsigned long)new_table->num_rows);
+
+    clear_current_table();
+    current_table = new_table;
+    return true;
+}
+
+// Área de trabalho: tabelas com nome (load <nome> = <ficheiro>, use <nome>)
+// a tabela atual é a da entrada ativa e, enquanto está ativa, vive em current_table (com o seu
+// filtro pendente em pending_filter), por isso os comandos só usam current_table; as outras
+// entradas guardam a sua tabela e o seu filtro pendente
+struct named_table
+{
+    char *name;
+    struct table *table;               // NULL na entrada ativa (e nas que não têm tabela)
+    struct table_expr *pending_filter;
+    int pending_conditions;
+};
+
+struct named_table *workspace = NULL;
+size_t workspace_size = 0;
+size_t workspace_capacity = 0;
+size_t active_table = 0; // entrada da tabela atual (a entrada 0, "main", existe sempre)
+
+#define DEFAULT_TABLE_NAME "main"
+
+// Procura a entrada com o nome (-1 se não existir)
+long find_named_table(const char *name)
+{
+    for (size_t i = 0; i < workspace_size; i++)
+    {
+        if (strcmp(workspace[i].name, name) == 0)
+            return (long)i;
+    }
+    return -1;
+}
+
+// Procura a entrada com o nome e cria-a (sem tabela) se não existir; retorna -1 em erro
+long get_named_table(const char *name)
+{
+    long index = find_named_table(name);
+    if (index >= 0)
+        return index;
+
+    if (workspace_size == workspace_capacity)
+    {
+        size_t new_capacity = workspace_capacity ? workspace_capacity * 2 : 8;
+        struct named_table *entries = realloc(workspace, new_capacity * sizeof(struct named_table));
+        if (!entries)
+            return -1;
+        workspace = entries;
+        workspace_capacity = new_capacity;
+    }
+
+    struct named_table *entry = &workspace[workspace_size];
+    entry->name = strdup(name);
+    if (!entry->name)
+        return -1;
+    entry->table = NULL;
+    entry->pending_filter = NULL;
+    entry->pending_conditions = 0;
+    return (long)workspace_size++;
+}
+
+// Torna a entrada index a tabela atual (a tabela atual e o seu filtro voltam para a sua entrada)
+void switch_table(size_t index)
+{
+    if (index == active_table)
+        return;
+
+    struct named_table *old = &workspace[active_table];
+    old->table = current_table;
+    old->pending_filter = pending_filter;
+    old->pending_conditions = pending_conditions;
+
+    struct named_table *entry = &workspace[index];
+    current_table = entry->table;
+    pending_filter = entry->pending_filter;
+    pending_conditions = entry->pending_conditions;
+    entry->table = NULL;
+    entry->pending_filter = NULL;
+    entry->pending_conditions = 0;
+    active_table = index;
+}
+
+// Substitui a tabela da entrada index (que pode não ser a atual) por table
+void set_named_table(size_t index, struct table *table)
+{
+    if (index == active_table)
+    {
+        clear_current_table();
+        current_table = table;
+        return;
+    }
+
+    struct named_table *entry = &workspace[index];
+    table_free(entry->table);
+    table_expr_free(entry->pending_filter);
+    entry->table = table;
+    entry->pending_filter = NULL;
+    entry->pending_conditions = 0;
+}
+
+// Tabela da entrada index já com o filtro pendente aplicado (NULL se não tiver tabela ou em erro)
+struct table *named_table_rows(size_t index)
+{
+    if (index == active_table)
+        return current_table && apply_pending_filter() ? current_table : NULL;
+
+    struct named_table *entry = &workspace[index];
+    if (entry->table && entry->pending_filter)
+    {
+        struct table *filtered = table_filter_expr(entry->table, entry->pending_filter, num_threads);
+        if (!filtered)
+        {
+            printf("Error: Filter failed (memory or internal error).\n");
+            return NULL;
+        }
+        set_named_table(index, filtered);
+    }
+    return entry->table;
+}
+
+// Liberta todas as tabelas da área de trabalho (a atual é libertada por clear_current_table)
+void free_workspace()
+{
+    for (size_t i = 0; i < workspace_size; i++)
+    {
+        table_free(workspace[i].table);
+        table_expr_free(workspace[i].pending_filter);
+        free(workspace[i].name);
+    }
+    free(workspace);
+    workspace = NULL;
+    workspace_size = workspace_capacity = 0;
+}
+
+// Lê o nome de "load <nome> = <ficheiro> ...": devolve o nome (terminado em '\0' dentro de
+// args) e avança *args para o ficheiro, ou NULL se o comando não tiver nome
+char *parse_table_name(char **args)
+{
+    char *eq = strstr(*args, " = ");
+    if (!eq || eq == *args || memchr(*args, ' ', eq - *args))
+        return NULL;
+
+    char *name = *args;
+    *eq = '\0';
+    *args = eq + strlen(" = ");
+    return name;
 }
 
 int get_command(const char *cmd)
@@ -62,17 +242,250 @@ int get_command(const char *cmd)
         return 5;
     if (strcmp(cmd, "filter") == 0)
         return 6;
+    if (strcmp(cmd, "threads") == 0)
+        return 7;
+    if (strcmp(cmd, "index") == 0)
+        return 8;
+    if (strcmp(cmd, "save_snapshot") == 0)
+        return 9;
+    if (strcmp(cmd, "load_snapshot") == 0)
+        return 10;
+    if (strcmp(cmd, "stats") == 0)
+        return 11;
+    if (strcmp(cmd, "where") == 0)
+        return 12;
+    if (strcmp(cmd, "sort") == 0)
+        return 13;
+    if (strcmp(cmd, "groupby") == 0)
+        return 14;
+    if (strcmp(cmd, "use") == 0)
+        return 15;
+    if (strcmp(cmd, "join") == 0)
+        return 16;
+    return 0;
+}
+
+// Nomes dos comandos, pelo número devolvido por get_command (0: plugins e comandos desconhecidos)
+#define NUM_COMMANDS 17
+const char *command_names[NUM_COMMANDS] = {"other", "help", "exit", "load", "save", "show", "filter", "threads", "index", "save_snapshot", "load_snapshot", "stats", "where", "sort", "groupby", "use", "join"};
+
+// Tempo atual em segundos (para medir a duração dos comandos)
+double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Estatísticas da sessão (comando stats)
+// a latência de cada comando vai para um histograma com escala logarítmica (8 divisões por
+// cada potência de 2 de nanossegundos): registar custa O(1) e a memória é fixa, por isso a
+// recolha está sempre ligada; os percentis têm um erro máximo de 12,5%
+#define LATENCY_BUCKETS (64 * 8)
+#define IO_HISTORY 8
+
+struct command_stats
+{
+    unsigned long count;
+    double total;
+    double max;
+    unsigned int buckets[LATENCY_BUCKETS];
+};
+
+struct command_stats command_stats[NUM_COMMANDS];
+
+// Últimos carregamentos e gravações (para o débito)
+struct io_record
+{
+    const char *operation;
+    char filename[256];
+    long bytes;
+    size_t rows;
+    double seconds;
+};
+
+struct io_record io_history[IO_HISTORY];
+int io_count = 0;
+
+int latency_bucket(double seconds)
+{
+    unsigned long long ns = seconds > 0 ? (unsigned long long)(seconds * 1e9) : 0;
+    if (ns < 8)
+        return (int)ns;
+
+    int exponent = 63 - __builtin_clzll(ns);
+    return (exponent - 2) * 8 + (int)((ns >> (exponent - 3)) & 7);
+}
+
+// Valor do meio de uma divisão do histograma, em segundos
+double bucket_value(int bucket)
+{
+    if (bucket < 8)
+        return bucket / 1e9;
+
+    int exponent = bucket / 8 + 2;
+    double width = (double)(1ull << (exponent - 3));
+    return ((8 + bucket % 8) * width + width / 2) / 1e9;
+}
+
+void record_command(int command, double seconds)
+{
+    struct command_stats *stats = &command_stats[command];
+    stats->count++;
+    stats->total += seconds;
+    if (seconds > stats->max)
+        stats->max = seconds;
+    stats->buckets[latency_bucket(seconds)]++;
+}
+
+void record_io(const char *operation, const char *filename, long bytes, size_t rows, double seconds)
+{
+    struct io_record *record = &io_history[io_count % IO_HISTORY];
+    record->operation = operation;
+    snprintf(record->filename, sizeof(record->filename), "%s", filename);
+    record->bytes = bytes;
+    record->rows = rows;
+    record->seconds = seconds;
+    io_count++;
+}
+
+// Percentil p (entre 0 e 1) da latência de um comando (nunca maior que a latência máxima)
+double latency_percentile(const struct command_stats *stats, double p)
+{
+    unsigned long rank = (unsigned long)(p * stats->count + 0.999999);
+    unsigned long seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        seen += stats->buckets[b];
+        if (seen >= rank && seen > 0)
+            return bucket_value(b) < stats->max ? bucket_value(b) : stats->max;
+    }
     return 0;
 }
 
+// Mostra uma duração com a unidade adequada
+void print_duration(double seconds)
+{
+    if (seconds < 1e-3)
+        printf(" %8.1f us", seconds * 1e6);
+    else if (seconds < 1)
+        printf(" %8.1f ms", seconds * 1e3);
+    else
+        printf(" %8.2f s ", seconds);
+}
+
+void print_memory_line(const char *name, size_t bytes)
+{
+    if (bytes < 1000000)
+        printf("  %-22s %10.1f KB\n", name, bytes / 1e3);
+    else
+        printf("  %-22s %10.2f MB\n", name, bytes / 1e6);
+}
+
+void show_stats()
+{
+    printf("Command latency:\n");
+    printf("  %-14s %8s %11s %11s %11s\n", "command", "count", "p50", "p99", "total");
+    for (int c = 0; c < NUM_COMMANDS; c++)
+    {
+        const struct command_stats *stats = &command_stats[c];
+        if (stats->count == 0)
+            continue;
+
+        printf("  %-14s %8lu", command_names[c], stats->count);
+        print_duration(latency_percentile(stats, 0.50));
+        print_duration(latency_percentile(stats, 0.99));
+        print_duration(stats->total);
+        printf("\n");
+    }
+
+    if (current_table)
+    {
+        struct table_memory mem;
+        table_memory_usage(current_table, &mem);
+
+        printf("Memory of the current table (%lu rows x %lu columns%s):\n",
+               (unsigned long)current_table->num_rows, (unsigned long)current_table->num_cols,
+               current_table->source ? ", view" : "");
+        if (pending_filter)
+            printf("  (%d filter conditions pending, not applied yet)\n", pending_conditions);
+        print_memory_line("cell strings", mem.cell_strings);
+        print_memory_line("arena slack", mem.arena_slack);
+        print_memory_line("row pointers", mem.row_pointers);
+        print_memory_line("row pointer slack", mem.pointer_slack);
+        if (current_table->source)
+            print_memory_line("view selection", mem.selection);
+        print_memory_line("indexes/types/dicts", mem.metadata);
+        print_memory_line("total", mem.cell_strings + mem.arena_slack + mem.row_pointers +
+                                       mem.pointer_slack + mem.selection + mem.metadata);
+    }
+    else
+        printf("No table is currently loaded.\n");
+
+    if (io_count > 0)
+    {
+        printf("Recent loads and saves:\n");
+        int first = io_count > IO_HISTORY ? io_count - IO_HISTORY : 0;
+        for (int k = first; k < io_count; k++)
+        {
+            const struct io_record *record = &io_history[k % IO_HISTORY];
+            printf("  %-14s %s: %.2f MB, %lu rows in %.3f s (%.1f MB/s)\n", record->operation,
+                   record->filename, record->bytes / 1e6, (unsigned long)record->rows, record->seconds,
+                   record->seconds > 0 ? record->bytes / record->seconds / 1e6 : 0.0);
+        }
+    }
+}
+
+// Tamanho de um ficheiro em bytes (0 se não existir)
+long file_size(const char *filename)
+{
+    struct stat st;
+    return stat(filename, &st) == 0 ? (long)st.st_size : 0;
+}
+
 void list_commands()
 {
     printf("List of available commands:\n");
     printf("exit                        -exits the program\n");
-    printf("load <filename>             -loads the content of the file <filename> to the table\n");
+    printf("load <filename> [options]   -loads the content of the file <filename> to the table (options: threads=N, types, dict)\n");
+    printf("load <name> = <filename>    -loads the file into the table <name>, which becomes the current table\n");
+    printf("use [<name>]                -makes <name> the current table (without <name>, lists the tables)\n");
+    printf("join <left> <right> on <colL>=<colR> -hash joins two tables into the new current table <left>_<right>\n");
     printf("save <filename>             -saves the table on the file <filename>\n");
     printf("show <col><row>:<col><row>  -shows the content of the table defined by the given coordinates\n");
     printf("filter <column><data>       -eliminates the lines of the table with the content in <column> different from <data>\n");
+    printf("filter <column> <op> <data> -keeps the lines with <column> <op> <data> (<, <=, >, >=, between <low> <high>)\n");
+    printf("where <expression>          -keeps the lines matching <expression> in one scan (ex: A = joaquim and E < 1.0 or not B = maca)\n");
+    printf("sort <col> [asc|desc] [num|str] -sorts the rows by <col> (more columns break ties; num/str forces numeric or text order)\n");
+    printf("groupby <cols> <agg>(<col>) -replaces the table by one row per distinct <cols> with count/sum/min/max/avg of <col> (ex: groupby B sum(C) count(*))\n");
+    printf("threads <n>                 -sets the number of threads used by load, filter and save\n");
+    printf("index <column> [ordered]    -builds a hash (or ordered) index on <column> to speed up filter\n");
+    printf("save_snapshot <filename>    -saves the table in a binary snapshot (fast to reload)\n");
+    printf("load_snapshot <filename>    -loads a table saved with save_snapshot (no parsing)\n");
+    printf("stats                       -shows per-command latency, memory of the current table and load/save throughput\n");
+}
+
+// Mostra o tipo de cada coluna da tabela atual
+void print_column_types()
+{
+    const char *names[] = {"string", "int64", "double"};
+
+    printf("Column types:");
+    for (size_t j = 0; j < current_table->num_cols; j++)
+        printf(" %c=%s", (char)('A' + j), names[table_column_type(current_table, j)]);
+    printf("\n");
+}
+
+// Mostra as colunas da tabela atual com dicionário
+void print_dict_columns()
+{
+    printf("Dictionary-encoded columns:");
+    for (size_t j = 0; j < current_table->num_cols; j++)
+    {
+        if (table_has_dict(current_table, j))
+            printf(" %c", (char)('A' + j));
+    }
+    printf("\n");
 }
 
 void load_table(char *args)
@@ -80,16 +493,70 @@ void load_table(char *args)
     if (!args)
     {
         printf("Error: you need to intruduce the file name you want to load a table from");
+        return;
     }
 
     args[strcspn(args, "\n")] = 0;
 
+    // load <nome> = <ficheiro>: a tabela fica com o nome (e passa a ser a atual)
+    char *name = parse_table_name(&args);
+    if (name)
+    {
+        long index = get_named_table(name);
+        if (index < 0)
+        {
+            printf("Error: Out of memory.\n");
+            return;
+        }
+        switch_table(index);
+    }
+
+    // opções no fim da linha, em qualquer ordem:
+    //   threads=N  carregamento paralelo com N threads (sem a opção, usamos o número de
+    //              threads definido com o comando threads)
+    //   types      inferir os tipos das colunas
+    //   dict       criar dicionários para as colunas com poucos valores distintos
+    int load_threads = num_threads;
+    bool infer_types = false;
+    bool dict_encode = false;
+    char *last_space;
+    while ((last_space = strrchr(args, ' ')) != NULL)
+    {
+        char *opt = last_space + 1;
+        if (strncmp(opt, "threads=", strlen("threads=")) == 0)
+            load_threads = atoi(opt + strlen("threads="));
+        else if (strcmp(opt, "types") == 0)
+            infer_types = true;
+        else if (strcmp(opt, "dict") == 0)
+            dict_encode = true;
+        else
+            break;
+        *last_space = '\0';
+    }
+
     clear_current_table();
-    current_table = table_load_csv(args);
+    double start = now_seconds();
+    if (load_threads > 1)
+        current_table = table_load_csv_parallel(args, load_threads);
+    else
+        current_table = table_load_csv(args);
+
+    if (current_table)
+        record_io("load", args, file_size(args), current_table->num_rows, now_seconds() - start);
+
+    if (current_table && infer_types && table_infer_types(current_table, load_threads) != 0)
+        printf("Error: Could not infer the column types.\n");
+
+    if (current_table && dict_encode && table_dict_encode(current_table, load_threads) != 0)
+        printf("Error: Could not build the column dictionaries.\n");
 
     if (current_table)
     {
-        printf("Table loaded successfuly.\n");
+        if (infer_types)
+            print_column_types();
+        if (dict_encode)
+            print_dict_columns();
+        printf("Table '%s' loaded successfuly.\n", workspace[active_table].name);
     }
     else
     {
@@ -102,15 +569,96 @@ void save_table(char *args)
     if (!current_table)
     {
         printf("Error: No table is currently loaded\n");
+        return;
     }
     if (!args)
     {
-        printf("Error: You need to intruduce the file name you want to save the table to\n");
+        printf("Error: You need to introduce the file name you want to save the table to\n");
+        return;
     }
 
+    // as linhas têm de estar todas filtradas
+    if (!apply_pending_filter())
+        return;
+
     args[strcspn(args, "\n")] = 0;
-    table_save_csv(current_table, args);
-    printf("Table loaded to %s\n", args);
+
+    // com mais de uma thread, as linhas são formatadas em paralelo
+    double start = now_seconds();
+    long bytes = num_threads > 1 ? table_save_csv_parallel(current_table, args, num_threads)
+                                 : table_save_csv(current_table, args);
+    double elapsed = now_seconds() - start;
+
+    if (bytes < 0)
+    {
+        printf("Error: Could not save the table to %s\n", args);
+        return;
+    }
+
+    record_io("save", args, bytes, current_table->num_rows, elapsed);
+    printf("Table saved to %s (%ld bytes in %.3f s, %.1f MB/s)\n", args, bytes, elapsed,
+           elapsed > 0 ? bytes / elapsed / 1e6 : 0.0);
+}
+
+// Guarda a tabela atual num snapshot binário
+void save_snapshot(char *args)
+{
+    if (!current_table)
+    {
+        printf("Error: No table is currently loaded\n");
+        return;
+    }
+    if (!args)
+    {
+        printf("Error: Usage: save_snapshot <filename>\n");
+        return;
+    }
+
+    // as linhas têm de estar todas filtradas
+    if (!apply_pending_filter())
+        return;
+
+    args[strcspn(args, "\n")] = 0;
+
+    double start = now_seconds();
+    long bytes = table_save_snapshot(current_table, args);
+    double elapsed = now_seconds() - start;
+
+    if (bytes < 0)
+    {
+        printf("Error: Could not save the snapshot to %s\n", args);
+        return;
+    }
+
+    record_io("save_snapshot", args, bytes, current_table->num_rows, elapsed);
+    printf("Snapshot saved to %s (%ld bytes in %.3f s)\n", args, bytes, elapsed);
+}
+
+// Carrega uma tabela de um snapshot binário (substitui a tabela atual)
+void load_snapshot(char *args)
+{
+    if (!args)
+    {
+        printf("Error: Usage: load_snapshot <filename>\n");
+        return;
+    }
+
+    args[strcspn(args, "\n")] = 0;
+
+    double start = now_seconds();
+    struct table *table = table_load_snapshot(args, num_threads);
+    double elapsed = now_seconds() - start;
+
+    if (!table)
+    {
+        printf("Error: %s is not a valid snapshot (or could not be read)\n", args);
+        return;
+    }
+
+    clear_current_table();
+    current_table = table;
+    record_io("load_snapshot", args, file_size(args), table->num_rows, elapsed);
+    printf("Snapshot loaded (%lu rows in %.3f s).\n", (unsigned long)table->num_rows, elapsed);
 }
 
 void show_sub_table(char *args)
@@ -137,29 +685,129 @@ void show_sub_table(char *args)
         return;
     }
 
-    int col_start = get_col_index(c1);
-    int col_end = get_col_index(c2);
-    int row_start = r1 - 1;
-    int row_end = r2 - 1;
+    // as colunas e as linhas têm de existir e o intervalo não pode estar ao contrário
+    int first_col = get_col_index(c1);
+    int last_col = get_col_index(c2);
+    if (first_col < 0 || last_col < first_col || (size_t)last_col >= current_table->num_cols || r1 < 1 || r2 < r1)
+    {
+        printf("Coordinates out of bounds.\n");
+        return;
+    }
+
+    size_t col_start = (size_t)first_col;
+    size_t col_end = (size_t)last_col;
+    size_t row_start = (size_t)r1 - 1;
+    size_t row_end = (size_t)r2 - 1;
+
+    // com um filtro pendente só são procuradas as primeiras row_end + 1 linhas que passam:
+    // a passagem pela tabela pára aí e a tabela atual não muda
+    struct table *table = current_table;
+    if (pending_filter)
+    {
+        table = table_filter_expr_first(current_table, pending_filter, row_end + 1);
+        if (!table)
+        {
+            printf("Error: Filter failed (memory or internal error).\n");
+            return;
+        }
+    }
 
     // Validação de limites
-    if (col_start < 0 || col_end >= current_table->num_cols ||
-        row_start < 0 || row_end >= current_table->num_rows)
+    if (row_end >= table->num_rows)
     {
         printf("Coordinates out of bounds.\n");
+        if (table != current_table)
+            table_free(table);
+        return;
+    }
+
+    // as células das linhas mostradas são copiadas do ficheiro mapeado (table_load_csv_parallel)
+    if (table_materialize(table, row_start, row_end + 1) != 0)
+    {
+        printf("Error: Out of memory.\n");
+        if (table != current_table)
+            table_free(table);
         return;
     }
 
     // Imprimir subtabela
-    for (int i = row_start; i <= row_end; i++)
+    for (size_t i = row_start; i <= row_end; i++)
     {
-        for (int j = col_start; j <= col_end; j++)
+        for (size_t j = col_start; j <= col_end; j++)
         {
-            char *val = current_table->data[i][j];
+            char *val = table_get_row(table, i)[j];
             printf("%s\t", val ? val : "");
         }
         printf("\n");
     }
+
+    if (table != current_table)
+        table_free(table);
+}
+
+// Lê uma condição de intervalo do comando filter: "<op> <valor>" (<, <=, >, >=) ou
+// "between <min> <max>"; o operador tem de ser uma palavra à parte ("filter A <x" procura o
+// valor "<x"); o valor (ou o mínimo) fica em low e o máximo em high
+// devolve o operador, ou NULL se a condição for uma igualdade
+const char *parse_range_condition(const char *condition, char *low, char *high)
+{
+    static const char *ops[] = {"<", "<=", ">", ">="};
+    char op[MAX_CMD_LEN];
+
+    int n = sscanf(condition, "%s %s %s", op, low, high);
+    if (n == 3 && strcmp(op, "between") == 0)
+        return "between";
+    for (size_t k = 0; n >= 2 && k < sizeof(ops) / sizeof(ops[0]); k++)
+    {
+        if (strcmp(op, ops[k]) == 0)
+            return ops[k];
+    }
+    return NULL;
+}
+
+// Filtra a coluna col_idx da tabela atual pela condição do comando filter:
+// "<value>", "< <value>", "<= <value>", "> <value>", ">= <value>" ou "between <low> <high>"
+struct table *filter_condition(int col_idx, char *condition)
+{
+    char low[MAX_CMD_LEN], high[MAX_CMD_LEN];
+    const char *op = parse_range_condition(condition, low, high);
+
+    if (!op)
+        return table_filter_equals(current_table, col_idx, condition, num_threads);
+    if (strcmp(op, "between") == 0)
+        return table_filter_range(current_table, col_idx, low, true, high, true, num_threads);
+    if (op[0] == '<')
+        return table_filter_range(current_table, col_idx, NULL, false, low, op[1] == '=', num_threads);
+    return table_filter_range(current_table, col_idx, low, op[1] == '=', NULL, false, num_threads);
+}
+
+// Condição do comando filter como expressão (as mesmas formas de filter_condition)
+struct table_expr *filter_expr(int col_idx, char *condition)
+{
+    char low[MAX_CMD_LEN], high[MAX_CMD_LEN];
+    const char *op = parse_range_condition(condition, low, high);
+
+    if (!op)
+        return table_expr_compare(col_idx, "=", condition);
+    if (strcmp(op, "between") != 0)
+        return table_expr_compare(col_idx, op, low);
+
+    struct table_expr *a = table_expr_compare(col_idx, ">=", low);
+    struct table_expr *b = table_expr_compare(col_idx, "<=", high);
+    struct table_expr *e = a && b ? table_expr_and(a, b) : NULL;
+    if (!e)
+    {
+        table_expr_free(a);
+        table_expr_free(b);
+    }
+    return e;
+}
+
+// Indica se a condição do comando filter é um intervalo (<, <=, >, >= ou between)
+bool is_range_condition(const char *condition)
+{
+    char low[MAX_CMD_LEN], high[MAX_CMD_LEN];
+    return parse_range_condition(condition, low, high) != NULL;
 }
 
 void filter_table(char *args)
@@ -196,13 +844,23 @@ void filter_table(char *args)
         return;
     }
 
-    // Preparar o contexto para o filtro
-    struct filter_ctx ctx;
-    ctx.col_idx = col_idx;
-    ctx.search_term = val_str;
+    // sem índice na coluna a condição fica pendente, para ser avaliada com as outras numa só
+    // passagem quando as linhas forem precisas; com índice o filtro é imediato (só visita as
+    // linhas do valor) e as condições pendentes continuam por cima do resultado
+    bool indexed = is_range_condition(val_str) ? table_has_ordered_index(current_table, col_idx)
+                                               : table_has_index(current_table, col_idx);
+    if (!indexed)
+    {
+        struct table_expr *expr = filter_expr(col_idx, val_str);
+        if (expr)
+            add_pending_filter(expr);
+        else
+            printf("Error: Filter failed (memory or internal error).\n");
+        return;
+    }
 
-    // Chamar a função da biblioteca
-    struct table *new_table = table_filter(current_table, filter_equals, &ctx);
+    // Chamar a função da biblioteca (usa o índice da coluna, se existir)
+    struct table *new_table = filter_condition(col_idx, val_str);
 
     if (new_table)
     {
@@ -211,7 +869,7 @@ void filter_table(char *args)
                (unsigned long)new_table->num_rows);
 
         // Substituir a tabela antiga pela nova
-        clear_current_table();     // Liberta a memória da antiga
+        table_free(current_table); // Larga a antiga (a vista mantém as linhas; o filtro pendente fica)
         current_table = new_table; // Aponta para a nova
     }
     else
@@ -220,11 +878,366 @@ void filter_table(char *args)
     }
 }
 
+void where_table(char *args)
+{
+    if (!current_table)
+    {
+        printf("Error: No table is currently loaded.\n");
+        return;
+    }
+    if (!args)
+    {
+        printf("Error: Usage: where <expression> (ex: where A = joaquim and E < 1.0)\n");
+        return;
+    }
+
+    // a expressão é compilada uma vez e avaliada (com as outras condições pendentes) numa só
+    // passagem pela tabela, quando as linhas forem precisas
+    args[strcspn(args, "\n")] = 0;
+    char error[128];
+    struct table_expr *expr = table_expr_parse(args, current_table->num_cols, error, sizeof(error));
+    if (!expr)
+    {
+        printf("Error: %s.\n", error);
+        return;
+    }
+
+    add_pending_filter(expr);
+}
+
+void sort_table(char *args)
+{
+    if (!current_table)
+    {
+        printf("Error: No table is currently loaded.\n");
+        return;
+    }
+    if (!args)
+    {
+        printf("Error: Usage: sort <col> [asc|desc] [num|str] [<col> ...]\n");
+        return;
+    }
+
+    // cada coluna pode ser seguida da direção e da forma de comparar; as colunas seguintes
+    // só desempatam as anteriores
+    struct table_sort_key keys[MAX_SORT_KEYS];
+    size_t num_keys = 0;
+    for (char *token = strtok(args, " \n"); token; token = strtok(NULL, " \n"))
+    {
+        if (num_keys > 0 && (strcmp(token, "asc") == 0 || strcmp(token, "desc") == 0))
+        {
+            keys[num_keys - 1].descending = token[0] == 'd';
+            continue;
+        }
+        if (num_keys > 0 && (strcmp(token, "num") == 0 || strcmp(token, "str") == 0))
+        {
+            keys[num_keys - 1].type = token[0] == 'n' ? SORT_NUMERIC : SORT_STRING;
+            continue;
+        }
+
+        int col_idx = token[1] == '\0' ? get_col_index(token[0]) : -1;
+        if (col_idx < 0 || col_idx >= current_table->num_cols)
+        {
+            printf("Error: Invalid column '%s'.\n", token);
+            return;
+        }
+        if (num_keys == MAX_SORT_KEYS)
+        {
+            printf("Error: At most %d sort columns.\n", MAX_SORT_KEYS);
+            return;
+        }
+
+        keys[num_keys].col = col_idx;
+        keys[num_keys].descending = false;
+        keys[num_keys].type = SORT_AUTO;
+        num_keys++;
+    }
+    if (num_keys == 0)
+    {
+        printf("Error: Usage: sort <col> [asc|desc] [num|str] [<col> ...]\n");
+        return;
+    }
+
+    // só se ordenam as linhas que passam no filtro
+    if (!apply_pending_filter())
+        return;
+
+    double start = now_seconds();
+    if (table_sort(current_table, keys, num_keys, num_threads) == 0)
+        printf("Table sorted (%lu rows in %.3f s).\n", (unsigned long)current_table->num_rows, now_seconds() - start);
+    else
+        printf("Error: Could not sort the table.\n");
+}
+
+// função auxiliar para ler uma agregação do comando groupby, como "sum(C)" ou "count(*)"
+bool parse_aggregate(const char *token, struct table_aggregate *agg)
+{
+    static const char *op_names[] = {"count", "sum", "min", "max", "avg"};
+    char op[16], col[16];
+
+    if (sscanf(token, "%15[a-z](%15[^)])", op, col) != 2 || token[strlen(token) - 1] != ')')
+        return false;
+
+    int op_idx = -1;
+    for (int i = 0; i < 5; i++)
+    {
+        if (strcmp(op, op_names[i]) == 0)
+            op_idx = i;
+    }
+    if (op_idx < 0)
+        return false;
+
+    agg->op = (enum table_agg_op)op_idx;
+    if (op_idx == AGG_COUNT && strcmp(col, "*") == 0)
+    {
+        agg->col = TABLE_AGG_ROWS;
+        return true;
+    }
+
+    int col_idx = col[1] == '\0' ? get_col_index(col[0]) : -1;
+    if (col_idx < 0 || col_idx >= current_table->num_cols)
+        return false;
+    agg->col = col_idx;
+    return true;
+}
+
+void group_table(char *args)
+{
+    if (!current_table)
+    {
+        printf("Error: No table is currently loaded.\n");
+        return;
+    }
+    if (!args)
+    {
+        printf("Error: Usage: groupby <col>[,<col>...] <agg>(<col>) ... (agg: count, sum, min, max, avg)\n");
+        return;
+    }
+
+    // as colunas de chave são letras (separadas por espaços ou vírgulas); as agregações têm parênteses
+    size_t key_cols[MAX_COLS];
+    struct table_aggregate aggs[MAX_COLS];
+    size_t num_keys = 0, num_aggs = 0;
+    for (char *token = strtok(args, " ,\n"); token; token = strtok(NULL, " ,\n"))
+    {
+        if (strchr(token, '('))
+        {
+            if (num_keys + num_aggs == MAX_COLS || !parse_aggregate(token, &aggs[num_aggs]))
+            {
+                printf("Error: Invalid aggregate '%s'.\n", token);
+                return;
+            }
+            num_aggs++;
+            continue;
+        }
+
+        int col_idx = token[1] == '\0' ? get_col_index(token[0]) : -1;
+        if (col_idx < 0 || col_idx >= current_table->num_cols || num_keys + num_aggs == MAX_COLS)
+        {
+            printf("Error: Invalid column '%s'.\n", token);
+            return;
+        }
+        key_cols[num_keys++] = col_idx;
+    }
+    if (num_keys == 0)
+    {
+        printf("Error: Usage: groupby <col>[,<col>...] <agg>(<col>) ... (agg: count, sum, min, max, avg)\n");
+        return;
+    }
+
+    // só se agrupam as linhas que passam no filtro
+    if (!apply_pending_filter())
+        return;
+
+    double start = now_seconds();
+    struct table *new_table = table_group_by(current_table, key_cols, num_keys, aggs, num_aggs, num_threads);
+    if (!new_table)
+    {
+        printf("Error: Group by failed (memory or internal error).\n");
+        return;
+    }
+
+    // o cabeçalho não é uma das linhas agrupadas
+    size_t grouped = current_table->num_rows - (table_has_header(current_table) ? 1 : 0);
+    printf("Grouped %lu rows into %lu groups in %.3f s.\n", (unsigned long)grouped,
+           (unsigned long)(new_table->num_rows - 1), now_seconds() - start);
+
+    // Substituir a tabela antiga pelo resultado
+    clear_current_table();
+    current_table = new_table;
+}
+
+void use_table(char *args)
+{
+    char *name = args ? strtok(args, " \n") : NULL;
+
+    // sem nome: listar as tabelas
+    if (!name)
+    {
+        for (size_t i = 0; i < workspace_size; i++)
+        {
+            struct table *table = i == active_table ? current_table : workspace[i].table;
+            int pending = i == active_table ? pending_conditions : workspace[i].pending_conditions;
+            if (table)
+                printf("%c %-16s %lu rows, %lu columns%s%s\n", i == active_table ? '*' : ' ', workspace[i].name,
+                       (unsigned long)table->num_rows, (unsigned long)table->num_cols,
+                       table->source ? ", view" : "", pending ? ", filter pending" : "");
+            else
+                printf("%c %-16s (no table)\n", i == active_table ? '*' : ' ', workspace[i].name);
+        }
+        return;
+    }
+
+    long index = find_named_table(name);
+    if (index < 0)
+    {
+        printf("Error: No table named '%s' (use without arguments lists the tables).\n", name);
+        return;
+    }
+
+    switch_table(index);
+    if (current_table)
+        printf("Using table '%s' (%lu rows).\n", name, (unsigned long)current_table->num_rows);
+    else
+        printf("Using table '%s' (no table loaded).\n", name);
+}
+
+void join_tables(char *args)
+{
+    char *left_name = args ? strtok(args, " \n") : NULL;
+    char *right_name = strtok(NULL, " \n");
+    char *on = strtok(NULL, " \n");
+    char *cols = strtok(NULL, " \n");
+
+    // colunas: <colL>=<colR>, uma letra de cada lado
+    if (!left_name || !right_name || !on || strcmp(on, "on") != 0 || !cols || strlen(cols) != 3 || cols[1] != '=')
+    {
+        printf("Error: Usage: join <left> <right> on <colL>=<colR> (ex: join precos entregas on B=A)\n");
+        return;
+    }
+
+    long left = find_named_table(left_name);
+    long right = find_named_table(right_name);
+    if (left < 0 || right < 0)
+    {
+        printf("Error: No table named '%s' (use without arguments lists the tables).\n", left < 0 ? left_name : right_name);
+        return;
+    }
+
+    // as duas tabelas com os filtros pendentes aplicados
+    struct table *left_table = named_table_rows(left);
+    struct table *right_table = left_table ? named_table_rows(right) : NULL;
+    if (!left_table || !right_table)
+    {
+        printf("Error: Table '%s' has no rows loaded.\n", left_table ? right_name : left_name);
+        return;
+    }
+
+    int left_col = get_col_index(cols[0]);
+    int right_col = get_col_index(cols[2]);
+    if (left_col < 0 || left_col >= left_table->num_cols || right_col < 0 || right_col >= right_table->num_cols)
+    {
+        printf("Error: Invalid columns '%s'.\n", cols);
+        return;
+    }
+    if (left_table->num_cols + right_table->num_cols > MAX_COLS)
+    {
+        printf("Error: The joined table would have more than %d columns.\n", MAX_COLS);
+        return;
+    }
+
+    double start = now_seconds();
+    struct table *result = table_hash_join(left_table, left_col, right_table, right_col, num_threads);
+    double elapsed = now_seconds() - start;
+    if (!result)
+    {
+        printf("Error: Join failed (memory or internal error).\n");
+        return;
+    }
+
+    // o resultado fica numa tabela nova, <esquerda>_<direita>, que passa a ser a atual
+    char name[MAX_CMD_LEN];
+    snprintf(name, sizeof(name), "%s_%s", left_name, right_name);
+    long index = get_named_table(name);
+    if (index < 0)
+    {
+        printf("Error: Out of memory.\n");
+        table_free(result);
+        return;
+    }
+
+    switch_table(index);
+    set_named_table(index, result);
+    printf("Joined '%s' and '%s' into %lu rows in %.3f s; table '%s' is now the current table.\n", left_name,
+           right_name, (unsigned long)(result->num_rows - 1), elapsed, name);
+}
+
+void index_column(char *args)
+{
+    if (!current_table)
+    {
+        printf("Error: No table is currently loaded.\n");
+        return;
+    }
+    if (!args)
+    {
+        printf("Error: Usage: index <col> [ordered]\n");
+        return;
+    }
+
+    // as linhas têm de estar todas filtradas
+    if (!apply_pending_filter())
+        return;
+
+    int col_idx = get_col_index(args[0]);
+    if (col_idx < 0 || col_idx >= current_table->num_cols)
+    {
+        printf("Error: Invalid column '%c'.\n", args[0]);
+        return;
+    }
+
+    // "index <col> ordered" cria um índice ordenado (para os filtros com <, >, between)
+    bool ordered = strstr(args + 1, "ordered") != NULL;
+    int result = ordered ? table_create_ordered_index(current_table, col_idx)
+                         : table_create_index(current_table, col_idx);
+
+    if (result == 0)
+        printf("%s index created on column %c.\n", ordered ? "Ordered" : "Hash", 'A' + col_idx);
+    else
+        printf("Error: Could not create the index.\n");
+}
+
+void set_threads(char *args)
+{
+    if (!args)
+    {
+        printf("Threads: %d\n", num_threads);
+        return;
+    }
+
+    int n = atoi(args);
+    if (n < 1 || n > TABLE_MAX_THREADS)
+    {
+        printf("Error: Number of threads must be between 1 and %d\n", TABLE_MAX_THREADS);
+        return;
+    }
+
+    num_threads = n;
+    printf("Using %d threads.\n", num_threads);
+}
+
 int main()
 {
     char input[MAX_CMD_LEN];
     int is_running = 1;
 
+    // a tabela sem nome (load <ficheiro>) é a tabela "main" da área de trabalho
+    if (get_named_table(DEFAULT_TABLE_NAME) < 0)
+    {
+        printf("Error: Out of memory.\n");
+        return 1;
+    }
+
     while (is_running)
     {
         printf("> ");
@@ -242,7 +1255,11 @@ int main()
             continue;
         }
 
-        switch (get_command(cmd))
+        // a duração de cada comando fica nas estatísticas (comando stats)
+        int command = get_command(cmd);
+        double start = now_seconds();
+
+        switch (command)
         {
         case 1:
             list_commands();
@@ -263,10 +1280,43 @@ int main()
         case 6:
             filter_table(args);
             break;
+        case 7:
+            set_threads(args);
+            break;
+        case 8:
+            index_column(args);
+            break;
+        case 9:
+            save_snapshot(args);
+            break;
+        case 10:
+            load_snapshot(args);
+            break;
+        case 11:
+            show_stats();
+            break;
+        case 12:
+            where_table(args);
+            break;
+        case 13:
+            sort_table(args);
+            break;
+        case 14:
+            group_table(args);
+            break;
+        case 15:
+            use_table(args);
+            break;
+        case 16:
+            join_tables(args);
+            break;
         default:
             printf("Unkown command: %s\n", cmd);
         }
+
+        record_command(command, now_seconds() - start);
     }
     clear_current_table();
+    free_workspace();
     return 0;
 }
\ No newline at end of file
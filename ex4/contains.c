@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../table/table.h"
+#include "plugin.h"
+
+// Argumentos do comando contains <col> <texto>
+struct contains_args
+{
+    size_t col;
+    char *text;
+};
+
+// Kernel de predicado: fica cada linha do lote cuja célula da coluna contém o texto
+static void contains_kernel(const struct table *table, size_t first, size_t end, bool *keep, const void *context)
+{
+    const struct contains_args *ca = (const struct contains_args *)context;
+
+    for (size_t i = first; i < end; i++)
+    {
+        const char *cell = table_get_row(table, i)[ca->col];
+        keep[i - first] = cell && strstr(cell, ca->text) != NULL;
+    }
+}
+
+static int contains_prepare(const struct table *table, char *args, struct plugin_kernel_args *out)
+{
+    char *col_str = args ? strtok(args, " ") : NULL;
+    char *text = col_str ? strtok(NULL, "\n") : NULL;
+    if (!col_str || !text)
+    {
+        printf("Error: Usage: contains <col> <text>\n");
+        return -1;
+    }
+
+    int col = col_str[0] >= 'a' ? col_str[0] - 'a' : col_str[0] - 'A';
+    if (col_str[1] != '\0' || col < 0 || (size_t)col >= table->num_cols)
+    {
+        printf("Error: Invalid column '%s'.\n", col_str);
+        return -1;
+    }
+
+    struct contains_args *ca = malloc(sizeof(struct contains_args));
+    if (!ca)
+    {
+        printf("Error: Out of memory.\n");
+        return -1;
+    }
+    ca->col = col;
+    ca->text = text;
+
+    out->context = ca;
+    return 0;
+}
+
+static void contains_release(struct plugin_kernel_args *args)
+{
+    free(args->context);
+}
+
+// Estrutura do plugin (versão 2: o programa chama o kernel em paralelo, um lote de cada vez)
+static struct command_plugin_v2 contains_plugin = {
+    .abi_version = PLUGIN_ABI_VERSION,
+    .name = "contains",
+    .description = "keeps the rows whose <col> contains <text> (batch kernel, uses all threads)",
+    .predicate = contains_kernel,
+    .prepare = contains_prepare,
+    .release = contains_release
+};
+
+// Função de inicialização que o main irá chamar
+struct command_plugin_v2 *plugin_init_v2(void)
+{
+    return &contains_plugin;
+}
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../table/table.h"
+#include "plugin.h"
+
+// Intervalo de linhas [first, last] (1-indexed) do comando delete_rows
+struct row_range
+{
+    size_t first;
+    size_t last;
+};
+
+// Condição do comando delete_rows <col> <op> <value>
+struct delete_condition
+{
+    int col;
+    char op[3];
+    const char *value;
+    bool numeric;
+    double number;
+};
+
+static int compare_ranges(const void *a, const void *b)
+{
+    const struct row_range *ra = (const struct row_range *)a;
+    const struct row_range *rb = (const struct row_range *)b;
+    return (ra->first > rb->first) - (ra->first < rb->first);
+}
+
+// função auxiliar para avaliar a condição numa linha (células vazias nunca são eliminadas)
+static bool condition_matches(const void *row, const void *context)
+{
+    const struct delete_condition *cond = (const struct delete_condition *)context;
+    const char *cell = ((char **)row)[cond->col];
+    if (!cell)
+        return false;
+
+    int cmp;
+    if (cond->numeric)
+    {
+        char *end;
+        double value = strtod(cell, &end);
+        if (end == cell || *end != '\0')
+            return false;
+        cmp = (value > cond->number) - (value < cond->number);
+    }
+    else
+        cmp = strcmp(cell, cond->value);
+
+    if (strcmp(cond->op, "=") == 0)
+        return cmp == 0;
+    if (strcmp(cond->op, "!=") == 0)
+        return cmp != 0;
+    if (strcmp(cond->op, "<") == 0)
+        return cmp < 0;
+    if (strcmp(cond->op, "<=") == 0)
+        return cmp <= 0;
+    if (strcmp(cond->op, ">") == 0)
+        return cmp > 0;
+    return cmp >= 0;
+}
+
+// função auxiliar para ler uma lista de intervalos "2-10,15,20-25"
+// devolve o número de intervalos (ordenados e sem sobreposições), -1 se a lista for inválida
+static long parse_ranges(char *args, struct row_range **ranges_out)
+{
+    size_t capacity = 16, count = 0;
+    struct row_range *ranges = malloc(capacity * sizeof(struct row_range));
+    if (!ranges)
+        return -1;
+
+    for (char *item = strtok(args, ","); item; item = strtok(NULL, ","))
+    {
+        char *end;
+        long first = strtol(item, &end, 10);
+        long last = first;
+        if (*end == '-')
+            last = strtol(end + 1, &end, 10);
+
+        if (end == item || *end != '\0' || first < 1 || last < first)
+        {
+            free(ranges);
+            return -1;
+        }
+
+        if (count == capacity)
+        {
+            capacity *= 2;
+            struct row_range *tmp = realloc(ranges, capacity * sizeof(struct row_range));
+            if (!tmp)
+            {
+                free(ranges);
+                return -1;
+            }
+            ranges = tmp;
+        }
+        ranges[count].first = (size_t)first;
+        ranges[count].last = (size_t)last;
+        count++;
+    }
+
+    // juntar os intervalos que se sobrepõem ou se tocam
+    qsort(ranges, count, sizeof(struct row_range), compare_ranges);
+    size_t merged = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (merged > 0 && ranges[i].first <= ranges[merged - 1].last + 1)
+        {
+            if (ranges[i].last > ranges[merged - 1].last)
+                ranges[merged - 1].last = ranges[i].last;
+        }
+        else
+            ranges[merged++] = ranges[i];
+    }
+
+    *ranges_out = ranges;
+    return (long)merged;
+}
+
+// função auxiliar para delete_rows <ranges>
+static void delete_ranges(struct table *table, char *args)
+{
+    struct row_range *ranges;
+    long count = parse_ranges(args, &ranges);
+    if (count < 0)
+    {
+        printf("Error: Invalid row ranges '%s'. Example: delete_rows 2-10,15\n", args);
+        return;
+    }
+
+    // do fim para o início, para os números das linhas ainda por eliminar não mudarem
+    size_t num_rows = table->num_rows;
+    long deleted = 0;
+    for (long i = count - 1; i >= 0; i--)
+    {
+        if (ranges[i].first > num_rows)
+            continue;
+
+        long n = table_delete_range(table, ranges[i].first - 1, ranges[i].last - ranges[i].first + 1);
+        if (n < 0)
+        {
+            printf("Error: Failed to delete rows %lu-%lu.\n",
+                   (unsigned long)ranges[i].first, (unsigned long)ranges[i].last);
+            break;
+        }
+        deleted += n;
+    }
+    free(ranges);
+
+    printf("%ld rows deleted. Table now has %lu rows.\n", deleted, (unsigned long)table->num_rows);
+}
+
+// função auxiliar para delete_rows <col> <op> <value>
+static void delete_matching(struct table *table, char *col_str, char *op, char *value)
+{
+    struct delete_condition cond;
+    cond.col = -1;
+    if (col_str[1] == '\0')
+    {
+        if (col_str[0] >= 'A' && col_str[0] <= 'Z')
+            cond.col = col_str[0] - 'A';
+        else if (col_str[0] >= 'a' && col_str[0] <= 'z')
+            cond.col = col_str[0] - 'a';
+    }
+    if (cond.col < 0 || (size_t)cond.col >= table->num_cols)
+    {
+        printf("Error: Invalid column '%s'.\n", col_str);
+        return;
+    }
+
+    const char *ops[] = {"=", "!=", "<", "<=", ">", ">="};
+    bool valid_op = false;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+        valid_op = valid_op || strcmp(op, ops[i]) == 0;
+    if (!valid_op)
+    {
+        printf("Error: Invalid operator '%s' (use =, !=, <, <=, >, >=).\n", op);
+        return;
+    }
+    strcpy(cond.op, op);
+
+    // a comparação é numérica se o valor for um número, senão é por strcmp
+    char *end;
+    cond.value = value;
+    cond.number = strtod(value, &end);
+    cond.numeric = end != value && *end == '\0';
+
+    long deleted = table_delete_where(table, condition_matches, &cond);
+    if (deleted < 0)
+    {
+        printf("Error: Failed to delete rows.\n");
+        return;
+    }
+
+    printf("%ld rows deleted. Table now has %lu rows.\n", deleted, (unsigned long)table->num_rows);
+}
+
+// Handler do comando delete_rows
+void delete_rows_handler(struct table **current_table, char *args)
+{
+    if (!*current_table)
+    {
+        printf("Error: No table is currently loaded.\n");
+        return;
+    }
+
+    if (!args)
+    {
+        printf("Error: Usage: delete_rows <ranges> | delete_rows <col> <op> <value>\n");
+        return;
+    }
+
+    // Remover newline se existir
+    args[strcspn(args, "\n")] = 0;
+
+    char *first = strtok(args, " ");
+    char *op = strtok(NULL, " ");
+    char *value = strtok(NULL, "");
+
+    if (first && !op)
+        delete_ranges(*current_table, first);
+    else if (first && op && value)
+        delete_matching(*current_table, first, op, value);
+    else
+        printf("Error: Usage: delete_rows <ranges> | delete_rows <col> <op> <value>\n");
+}
+
+// Estrutura do plugin
+static struct command_plugin delete_rows_plugin = {
+    .name = "delete_rows",
+    .description = "deletes row ranges (2-10,15) or the rows where <col> <op> <value>",
+    .handler = delete_rows_handler
+};
+
+// Função de inicialização que o main irá chamar
+struct command_plugin *plugin_init(void)
+{
+    return &delete_rows_plugin;
+}
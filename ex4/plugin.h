@@ -15,4 +15,39 @@ struct command_plugin
 // Retorna um ponteiro para a estrutura do plugin
 typedef struct command_plugin *(*plugin_init_func)(void);
 
+// Versão 2 da interface: os plugins podem, em vez de um handler, dar kernels que processam um
+// lote de linhas de cada vez (ver table_filter_batch e table_transform_batch); o programa divide
+// a tabela em lotes e distribui-os pelas threads (comando threads)
+// os plugins da versão 1 (plugin_init) continuam a ser carregados como antes
+#define PLUGIN_ABI_VERSION 2
+
+// Argumentos dos kernels, preparados a partir dos argumentos do comando
+struct plugin_kernel_args
+{
+    void *context; // passado aos kernels (que o podem usar em paralelo, só para leitura)
+    size_t col;    // coluna alterada pelo kernel de transformação
+};
+
+struct command_plugin_v2
+{
+    int abi_version;         // PLUGIN_ABI_VERSION
+    const char *name;        // Nome do comando
+    const char *description; // Descrição do comando
+
+    // Função que executa o comando (opcional: se existir, os kernels não são usados)
+    void (*handler)(struct table **current_table, char *args);
+
+    // Kernels (um dos dois): o predicado filtra a tabela, a transformação altera uma coluna
+    table_batch_predicate predicate;
+    table_batch_transform transform;
+
+    // Prepara os argumentos dos kernels a partir de args (retorna 0 em sucesso, -1 em erro,
+    // depois de mostrar a mensagem de erro); release liberta-os no fim (ambos opcionais)
+    int (*prepare)(const struct table *table, char *args, struct plugin_kernel_args *out);
+    void (*release)(struct plugin_kernel_args *args);
+};
+
+// Função que os plugins da versão 2 devem exportar (plugin_init_v2)
+typedef struct command_plugin_v2 *(*plugin_init_v2_func)(void);
+
 #endif
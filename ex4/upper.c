@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "../table/table.h"
+#include "plugin.h"
+
+// Kernel de transformação: passa para maiúsculas as células do lote com letras minúsculas
+// (as outras células não mudam)
+static void upper_kernel(const struct table *table, size_t col, size_t first, size_t end,
+                         struct table_batch_output *out, const void *context)
+{
+    char *buffer = NULL;
+    size_t capacity = 0;
+
+    for (size_t i = first; i < end; i++)
+    {
+        const char *cell = table_get_row(table, i)[col];
+        if (!cell)
+            continue;
+
+        size_t len = strlen(cell);
+        size_t k = 0;
+        while (k < len && !islower((unsigned char)cell[k]))
+            k++;
+        if (k == len)
+            continue;
+
+        if (len > capacity)
+        {
+            char *bigger = realloc(buffer, len);
+            if (!bigger)
+            {
+                table_batch_fail(out);
+                break;
+            }
+            buffer = bigger;
+            capacity = len;
+        }
+
+        for (k = 0; k < len; k++)
+            buffer[k] = toupper((unsigned char)cell[k]);
+
+        if (table_batch_set(out, i, buffer, len) != 0)
+            break;
+    }
+
+    free(buffer);
+}
+
+static int upper_prepare(const struct table *table, char *args, struct plugin_kernel_args *out)
+{
+    if (!args || args[0] == '\0' || (args[1] != '\0' && args[1] != '\n'))
+    {
+        printf("Error: Usage: upper <col>\n");
+        return -1;
+    }
+
+    int col = args[0] >= 'a' ? args[0] - 'a' : args[0] - 'A';
+    if (col < 0 || (size_t)col >= table->num_cols)
+    {
+        printf("Error: Invalid column '%c'.\n", args[0]);
+        return -1;
+    }
+
+    out->col = col;
+    return 0;
+}
+
+// Estrutura do plugin (versão 2: o programa chama o kernel em paralelo, um lote de cada vez)
+static struct command_plugin_v2 upper_plugin = {
+    .abi_version = PLUGIN_ABI_VERSION,
+    .name = "upper",
+    .description = "converts the cells of <col> to upper case (batch kernel, uses all threads)",
+    .transform = upper_kernel,
+    .prepare = upper_prepare
+};
+
+// Função de inicialização que o main irá chamar
+struct command_plugin_v2 *plugin_init_v2(void)
+{
+    return &upper_plugin;
+}
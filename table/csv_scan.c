@@ -0,0 +1,307 @@
+#include <stdint.h>
+#include <string.h>
+#include "csv_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CSV_SCAN_X86
+#endif
+
+#define BLOCK_SIZE 64
+
+// função auxiliar para testar se um caractere é estrutural
+static inline int is_structural(char c)
+{
+    return c == ',' || c == '"' || c == '\n' || c == '\r';
+}
+
+// máscara de um bloco com menos de 64 bytes (fim do buffer)
+// não podemos ler para além do fim: o buffer pode ser um ficheiro mapeado
+static uint64_t structural_mask_tail(const char *p, size_t n)
+{
+    uint64_t mask = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (is_structural(p[i]))
+            mask |= (uint64_t)1 << i;
+    }
+    return mask;
+}
+
+// versão escalar (para arquiteturas sem SSE2)
+static uint64_t structural_mask_scalar(const char *p)
+{
+    return structural_mask_tail(p, BLOCK_SIZE);
+}
+
+#ifdef CSV_SCAN_X86
+// versão SSE2: 4 blocos de 16 bytes, cada um comparado com os 4 caracteres estruturais
+__attribute__((target("sse2"))) static uint64_t structural_mask_sse2(const char *p)
+{
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    uint64_t mask = 0;
+
+    for (int i = 0; i < BLOCK_SIZE / 16; i++)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, quote)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+        mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(m) << (16 * i);
+    }
+
+    return mask;
+}
+
+// versão AVX2: 2 blocos de 32 bytes
+__attribute__((target("avx2"))) static uint64_t structural_mask_avx2(const char *p)
+{
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    uint64_t mask = 0;
+
+    for (int i = 0; i < BLOCK_SIZE / 32; i++)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + 32 * i));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, comma), _mm256_cmpeq_epi8(v, quote)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(m) << (32 * i);
+    }
+
+    return mask;
+}
+#endif
+
+// versão escalar de csv_cell_length
+static size_t cell_length_scalar(const char *s, bool *needs_quotes)
+{
+    const char *p = s;
+    while (*p && !is_structural(*p))
+        p++;
+
+    *needs_quotes = *p != '\0';
+    if (*needs_quotes)
+        p += strlen(p);
+
+    return p - s;
+}
+
+#ifdef CSV_SCAN_X86
+// versão SSE2 de csv_cell_length: blocos de 16 bytes alinhados, comparados com '\0' e com os
+// 4 caracteres estruturais; um bloco alinhado nunca atravessa o fim de uma página, por isso
+// podemos ler para além do '\0' (tal como o strlen da libc, o que o ASan não sabe)
+__attribute__((target("sse2"), no_sanitize_address)) static size_t cell_length_sse2(const char *s, bool *needs_quotes)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+
+    const char *block = (const char *)((uintptr_t)s & ~(uintptr_t)15);
+    unsigned skip = (unsigned)(s - block);
+    bool special = false;
+
+    for (;;)
+    {
+        __m128i v = _mm_load_si128((const __m128i *)block);
+        unsigned end_mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, quote)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+        unsigned special_mask = (unsigned)_mm_movemask_epi8(m);
+
+        // descartar os bytes antes do início da string (só no primeiro bloco)
+        end_mask = end_mask >> skip << skip;
+        special_mask = special_mask >> skip << skip;
+        skip = 0;
+
+        if (end_mask)
+        {
+            // só contam os caracteres estruturais antes do '\0'
+            unsigned end = __builtin_ctz(end_mask);
+            *needs_quotes = special || (special_mask & ((1u << end) - 1)) != 0;
+            return block + end - s;
+        }
+
+        special = special || special_mask != 0;
+        block += 16;
+    }
+}
+#endif
+
+// implementação escolhida em runtime
+static uint64_t (*structural_mask)(const char *p) = structural_mask_scalar;
+static size_t (*cell_length)(const char *s, bool *needs_quotes) = cell_length_scalar;
+static const char *structural_mask_name = "scalar";
+
+// escolher a melhor implementação suportada pelo processador (corre ao carregar a biblioteca)
+__attribute__((constructor)) static void csv_scan_select(void)
+{
+#ifdef CSV_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        structural_mask = structural_mask_avx2;
+        structural_mask_name = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        structural_mask = structural_mask_sse2;
+        structural_mask_name = "sse2";
+    }
+
+    // as células são quase sempre curtas: blocos de 16 bytes chegam
+    if (__builtin_cpu_supports("sse2"))
+        cell_length = cell_length_sse2;
+#endif
+}
+
+size_t csv_cell_length(const char *s, bool *needs_quotes)
+{
+    return cell_length(s, needs_quotes);
+}
+
+const char *csv_scan_impl(void)
+{
+    return structural_mask_name;
+}
+
+// função auxiliar para calcular a máscara do bloco que começa em block
+static inline uint64_t block_mask(const char *block, const char *end)
+{
+    if (end - block >= BLOCK_SIZE)
+        return structural_mask(block);
+    return structural_mask_tail(block, end - block);
+}
+
+void csv_scanner_init(struct csv_scanner *sc, const char *begin, const char *end)
+{
+    sc->block = begin;
+    sc->end = end;
+    sc->mask = block_mask(begin, end);
+}
+
+// função auxiliar para obter o próximo caractere estrutural em [from, end) (ou end se não houver)
+// os bits das posições anteriores a from são descartados
+static const char *scan_next(struct csv_scanner *sc, const char *from)
+{
+    // saltar diretamente para o bloco de from
+    if (from - sc->block >= BLOCK_SIZE)
+    {
+        if (from >= sc->end)
+            return sc->end;
+        sc->block += (from - sc->block) & ~(size_t)(BLOCK_SIZE - 1);
+        sc->mask = block_mask(sc->block, sc->end);
+    }
+
+    for (;;)
+    {
+        while (sc->mask)
+        {
+            const char *pos = sc->block + __builtin_ctzll(sc->mask);
+            sc->mask &= sc->mask - 1;
+            if (pos >= from)
+                return pos;
+        }
+
+        if (sc->end - sc->block <= BLOCK_SIZE)
+            return sc->end;
+
+        sc->block += BLOCK_SIZE;
+        sc->mask = block_mask(sc->block, sc->end);
+    }
+}
+
+char *csv_next_field(struct csv_scanner *sc, char *p, struct csv_field *field)
+{
+    const char *end = sc->end;
+    const char *s;
+
+    field->escaped = false;
+
+    if (p < end && *p == '"')
+    {
+        // campo entre aspas: procurar a aspa final, saltando os separadores dentro das aspas
+        field->begin = p + 1;
+        s = scan_next(sc, p + 1);
+        for (;;)
+        {
+            while (s < end && *s != '"')
+                s = scan_next(sc, s + 1);
+
+            if (s < end && s + 1 < end && s[1] == '"')
+            {
+                // aspa escapada ("")
+                field->escaped = true;
+                s = scan_next(sc, s + 2);
+                continue;
+            }
+            break;
+        }
+        field->len = s - field->begin;
+
+        if (s < end)
+        {
+            // campo mal formado: os caracteres entre a aspa final e o separador fazem parte do campo
+            const char *closing = s;
+            s = scan_next(sc, s + 1);
+            while (s < end && *s == '"')
+                s = scan_next(sc, s + 1);
+            if (s != closing + 1)
+                field->escaped = true;
+        }
+    }
+    else
+    {
+        // campo sem aspas: as aspas a meio do campo são caracteres normais
+        field->begin = p;
+        s = scan_next(sc, p);
+        while (s < end && *s == '"')
+            s = scan_next(sc, s + 1);
+        field->len = s - p;
+    }
+
+    field->raw_end = (char *)s;
+
+    if (s == end)
+    {
+        field->sep = 0;
+        return (char *)end;
+    }
+
+    field->sep = *s;
+    return (char *)s + 1;
+}
+
+size_t csv_unquote(char *dst, const char *src, size_t len)
+{
+    size_t r = 0;
+    size_t w = 0;
+
+    while (r < len)
+    {
+        if (src[r] == '"')
+        {
+            if (r + 1 < len && src[r + 1] == '"')
+            {
+                dst[w++] = '"';
+                r += 2;
+                continue;
+            }
+
+            // aspa final: o resto do campo é copiado tal como está
+            r++;
+            memmove(dst + w, src + r, len - r);
+            w += len - r;
+            break;
+        }
+
+        dst[w++] = src[r++];
+    }
+
+    return w;
+}
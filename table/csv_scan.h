@@ -0,0 +1,46 @@
+#ifndef CSV_SCAN_H
+#define CSV_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Scanner de caracteres estruturais do CSV (',', '"', '\n' e '\r')
+// o buffer é percorrido em blocos de 64 bytes; para cada bloco é calculada uma máscara de bits
+// com as posições dos caracteres estruturais (SSE2/AVX2 quando disponível, escolhido em runtime)
+struct csv_scanner
+{
+    const char *block; // início do bloco de 64 bytes atual
+    const char *end;   // fim do buffer
+    uint64_t mask;     // caracteres estruturais do bloco ainda por consumir
+};
+
+// Campo do CSV encontrado pelo scanner
+struct csv_field
+{
+    char *begin;   // início do conteúdo (a seguir à aspa inicial, se o campo tiver aspas)
+    size_t len;    // comprimento do conteúdo (válido se escaped for falso)
+    char *raw_end; // posição do separador que termina o campo (ou fim do buffer)
+    bool escaped;  // o conteúdo [begin, raw_end) tem de passar por csv_unquote
+    int sep;       // ',', '\n', '\r' ou 0 se o campo chegou ao fim do buffer
+};
+
+// Inicializa o scanner para o buffer [begin, end)
+void csv_scanner_init(struct csv_scanner *sc, const char *begin, const char *end);
+
+// Lê o campo que começa em p e devolve a posição a seguir ao separador
+// os espaços nunca são removidos (tal como com is_not_space na libcsv)
+char *csv_next_field(struct csv_scanner *sc, char *p, struct csv_field *field);
+
+// Resolve as aspas de um campo escaped ("" torna-se ") de src para dst (podem ser o mesmo buffer)
+// devolve o comprimento do resultado, que nunca é maior que len
+size_t csv_unquote(char *dst, const char *src, size_t len);
+
+// Comprimento da célula s (como strlen) numa só passagem, que indica também se a célula tem
+// caracteres estruturais e por isso tem de ser escrita entre aspas
+size_t csv_cell_length(const char *s, bool *needs_quotes);
+
+// Nome da implementação escolhida em runtime ("avx2", "sse2" ou "scalar")
+const char *csv_scan_impl(void);
+
+#endif
@@ -1,56 +1,294 @@
 #include <stdio.h>
 #include <stddef.h>
-#include <csv.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "table.h"
+#include "table_internal.h"
+#include "csv_scan.h"
+#include "thread_pool.h"
 
-struct load_context
+// bloco de memória da arena de strings
+// as strings são alocadas sequencialmente dentro do bloco (bump pointer)
+struct arena_block
 {
-    struct table *table;
-    size_t current_row;
-    size_t current_col;
-    char **temp_row;
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+    char data[];
 };
 
-// função auxiliar para impedir que espaços sejam removidos
-int is_not_space(unsigned char c)
+// função auxiliar para reservar size bytes na arena da tabela
+// em vez de um malloc por célula, reservamos blocos grandes e vamos avançando dentro deles
+// todos os blocos são libertados de uma só vez em table_free
+char *arena_alloc(struct table *t, size_t size)
 {
+    struct arena_block *block = t->arena;
+
+    if (!block || block->size - block->used < size)
+    {
+        // o novo bloco tem o dobro do anterior (até ARENA_MAX_BLOCK_SIZE)
+        // deste modo tabelas pequenas gastam pouco e tabelas grandes têm poucos blocos
+        size_t block_size = block ? block->size * 2 : ARENA_MIN_BLOCK_SIZE;
+        if (block_size > ARENA_MAX_BLOCK_SIZE)
+            block_size = ARENA_MAX_BLOCK_SIZE;
+        if (block_size < size)
+            block_size = size;
+
+        struct arena_block *new_block = malloc(sizeof(struct arena_block) + block_size);
+        if (!new_block)
+            return NULL;
+
+        new_block->size = block_size;
+        new_block->used = 0;
+        new_block->next = block;
+        t->arena = new_block;
+        block = new_block;
+    }
+
+    char *ptr = block->data + block->used;
+    block->used += size;
+
+    return ptr;
+}
+
+// função auxiliar para copiar uma string para a arena da tabela
+char *arena_strndup(struct table *t, const char *s, size_t len)
+{
+    char *str = arena_alloc(t, len + 1);
+    if (!str)
+        return NULL;
+
+    memcpy(str, s, len);
+    str[len] = '\0';
+
+    return str;
+}
+
+// função auxiliar para retirar a arena à tabela (que fica com uma arena vazia)
+struct arena_block *arena_detach(struct table *t)
+{
+    struct arena_block *blocks = t->arena;
+    t->arena = NULL;
+    return blocks;
+}
+
+// função auxiliar para devolver à tabela os blocos de uma arena retirada com arena_detach
+// os blocos ficam no fim da lista: a alocação continua no bloco atual
+void arena_attach(struct table *t, struct arena_block *blocks)
+{
+    struct arena_block **tail = &t->arena;
+    while (*tail)
+        tail = &(*tail)->next;
+    *tail = blocks;
+}
+
+// função auxiliar para libertar todos os blocos de uma arena
+void arena_release(struct arena_block *blocks)
+{
+    while (blocks)
+    {
+        struct arena_block *next = blocks->next;
+        free(blocks);
+        blocks = next;
+    }
+}
+
+// função auxiliar para criar uma tabela vazia com num_cols colunas
+struct table *table_create(size_t num_cols)
+{
+    struct table *t = malloc(sizeof(struct table));
+    if (!t)
+        return NULL;
+
+    t->num_cols = num_cols;
+    t->num_rows = 0;
+    t->pointer_array_capacity = 0;
+    t->cells = NULL;
+    t->arena = NULL;
+    t->map_addr = NULL;
+    t->map_size = 0;
+    t->lazy_cols = 0;
+    t->source = NULL;
+    t->selection = NULL;
+    t->refcount = 1;
+    t->columns = NULL;
+    t->deleted = NULL;
+
+    return t;
+}
+
+// função auxiliar para garantir que a matriz de células tem espaço para mais uma linha
+// duplicamos a capacidade sempre que necessário
+int table_reserve_row(struct table *t)
+{
+    if (t->num_rows < t->pointer_array_capacity)
+        return 0;
+
+    size_t new_capacity = t->pointer_array_capacity * 2;
+    if (new_capacity == 0)
+        new_capacity = INITIAL_POINTER_ARR_CAPACITY;
+
+    // a matriz é plana: cada linha ocupa num_cols ponteiros consecutivos
+    char **new_cells = realloc(t->cells, new_capacity * t->num_cols * sizeof(char *));
+    if (!new_cells)
+        return -1;
+
+    t->cells = new_cells;
+    t->pointer_array_capacity = new_capacity;
+
     return 0;
 }
 
-// função auxiliar para processar cada célula lida
-// quando uma célula é lida, esta função é chamada
-void process_cell(void *s, size_t len, void *data)
+// função para obter a linha row_index da tabela
+// as células que ainda são vistas sobre o ficheiro mapeado são copiadas antes
+char **table_get_row(const struct table *table, size_t row_index)
+{
+    const struct table *base = table->source ? table->source : table;
+    if (base->lazy_cols && table_materialize(table, row_index, row_index + 1) != 0)
+        return NULL;
+
+    return table_row(table, row_index);
+}
+
+// função para saber se a primeira linha da tabela é o cabeçalho da tabela carregada
+bool table_has_header(const struct table *table)
+{
+    return table->num_rows > 0 && table_physical_row(table, 0) == 0;
+}
+
+// função auxiliar para obter o comprimento do campo de uma célula vista
+// um campo entre aspas (sem aspas escapadas, que são sempre copiadas) acaba na aspa final;
+// os outros acabam no separador seguinte ou no fim do ficheiro
+size_t cell_view_length(const struct table *base, const char *cell)
 {
-    struct load_context *ctx = (struct load_context *)data;
+    const char *begin = cell;
+    const char *map = base->map_addr;
+    const char *end = map + base->map_size;
 
-    // se estivermos a ler a primeira linha, ainda não sabemos o número de colunas
-    // vamos alocando memória até sabermos o número de colunas correto
-    if (ctx->current_row == 0)
+    if (begin > map && begin[-1] == '"')
     {
-        if (ctx->current_col >= MAX_COLS)
-            return;
+        const char *quote = memchr(begin, '"', end - begin);
+        return (quote ? quote : end) - begin;
+    }
+
+    const char *p = begin;
+    while (p < end && *p != ',' && *p != '\n' && *p != '\r')
+        p++;
+    return p - begin;
+}
 
-        // realoca o array temporário para aceitar mais 1 coluna
-        // deste modo não desperdiçamos memória. vamos alocando memória até ao  número de colunas correto
-        char **new_row = realloc(ctx->temp_row, (ctx->current_col + 1) * sizeof(char *));
-        ctx->temp_row = new_row;
+// função auxiliar para copiar para a arena da tabela base a célula vista em *slot
+static int materialize_cell(struct table *base, char **slot)
+{
+    char *copy = arena_strndup(base, *slot, cell_view_length(base, *slot));
+    if (!copy)
+        return -1;
+
+    *slot = copy;
+    return 0;
+}
+
+// função para copiar para a arena as células vistas das colunas cols da tabela base
+int table_materialize_columns(const struct table *table, uint32_t cols)
+{
+    struct table *base = (struct table *)(table->source ? table->source : table);
+    cols &= base->lazy_cols;
+    if (!cols)
+        return 0;
+
+    // as posições eliminadas ainda por compactar também são copiadas
+    size_t num_slots = base->deleted ? base->deleted->num_slots : base->num_rows;
+    for (size_t i = 0; i < num_slots; i++)
+    {
+        char **row = base->cells + i * base->num_cols;
+        for (size_t col = 0; col < base->num_cols; col++)
+        {
+            if ((cols >> col & 1) && cell_is_view(base, row[col]) && materialize_cell(base, &row[col]) != 0)
+                return -1;
+        }
     }
 
-    // alocar memória exata para o tamanho da string da cel (+1 para o terminador de string '\0')
-    char *cell_content = malloc(len + 1);
-    if (cell_content)
+    base->lazy_cols &= ~cols;
+    return 0;
+}
+
+// função para copiar para a arena as células vistas das linhas [first, end) da tabela
+int table_materialize(const struct table *table, size_t first, size_t end)
+{
+    struct table *base = (struct table *)(table->source ? table->source : table);
+    if (!base->lazy_cols)
+        return 0;
+
+    // a tabela base inteira: as colunas deixam de ter vistas
+    if (end > table->num_rows)
+        end = table->num_rows;
+    if (!table->source && first == 0 && end == table->num_rows)
+        return table_materialize_columns(table, ALL_COLUMNS);
+
+    for (size_t i = first; i < end; i++)
     {
-        // copiar o conteúdo da célula para a nova string
-        memcpy(cell_content, s, len);
-        cell_content[len] = '\0';
-        // guardar o conteúdo da célula na linha temporária
-        ctx->temp_row[ctx->current_col] = cell_content;
+        char **row = table_row(table, i);
+        for (size_t col = 0; col < table->num_cols; col++)
+        {
+            if (cell_is_view(base, row[col]) && materialize_cell(base, &row[col]) != 0)
+                return -1;
+        }
     }
 
-    ctx->current_col++;
+    return 0;
+}
+
+// função auxiliar para somar a memória de uma tabela base (sem a seleção de uma vista)
+static void base_memory_usage(const struct table *t, struct table_memory *mem)
+{
+    for (const struct arena_block *block = t->arena; block; block = block->next)
+    {
+        mem->cell_strings += sizeof(struct arena_block) + block->used;
+        mem->arena_slack += block->size - block->used;
+    }
+    mem->cell_strings += t->map_size;
+
+    size_t row_bytes = t->num_cols * sizeof(char *);
+    size_t num_slots = t->deleted ? t->deleted->num_slots : t->num_rows;
+    mem->row_pointers += num_slots * row_bytes;
+    if (t->pointer_array_capacity > num_slots)
+        mem->pointer_slack += (t->pointer_array_capacity - num_slots) * row_bytes;
+
+    mem->metadata += table_columns_memory(t, num_slots);
+}
+
+// função auxiliar para somar a memória das marcas de eliminação de uma tabela
+static size_t deletes_memory(const struct table *t)
+{
+    if (!t->deleted)
+        return 0;
+
+    size_t n = t->deleted->num_slots;
+    return sizeof(struct tombstones) + ((n + 63) / 64 + 1) * sizeof(uint64_t) + (n + 1) * sizeof(uint32_t);
+}
+
+// função para calcular a memória usada por uma tabela (numa vista, inclui a tabela de origem)
+void table_memory_usage(const struct table *table, struct table_memory *mem)
+{
+    memset(mem, 0, sizeof(*mem));
+
+    const struct table *base = table->source ? table->source : table;
+    base_memory_usage(base, mem);
+    mem->metadata += deletes_memory(base);
+
+    if (table->source)
+    {
+        size_t num_slots = table->deleted ? table->deleted->num_slots : table->num_rows;
+        mem->selection = num_slots * sizeof(uint32_t);
+        // os índices e tipos criados sobre a vista são da própria vista
+        mem->metadata += deletes_memory(table) + table_columns_memory(table, num_slots);
+    }
 }
 
 // função auxiliar para libertar a memória associada a uma tabela
@@ -59,247 +297,677 @@ void table_free(struct table *t)
     if (t == NULL)
         return;
 
-    // Percorrer todas as linhas
-    for (size_t i = 0; i < t->num_rows; i++)
+    // Enquanto houver vistas a usar a tabela, só largamos a nossa referência
+    if (--t->refcount > 0)
+        return;
+
+    table_free_columns(t);
+    table_free_deletes(t);
+
+    // Uma vista liberta a seleção e larga a referência à tabela de origem
+    if (t->source)
     {
-        // Se a linha existe
-        if (t->data[i] != NULL)
-        {
-            // Percorrer todas as colunas dessa linha e libertar as strings
-            for (size_t j = 0; j < t->num_cols; j++)
-            {
-                free(t->data[i][j]);
-            }
-            // Libertar o array de ponteiros da linha
-            free(t->data[i]);
-        }
+        free(t->selection);
+        table_free(t->source);
+        free(t);
+        return;
     }
 
-    // Libertar a matriz principal (array de linhas)
-    free(t->data);
+    // Libertar todos os blocos da arena (as strings de todas as células)
+    arena_release(t->arena);
+
+    // Libertar a matriz de células
+    free(t->cells);
+
+    // Desmapear o ficheiro (se a tabela foi carregada com table_load_csv_mmap)
+    if (t->map_addr)
+        munmap(t->map_addr, t->map_size);
 
     // Libertar a estrutura
     free(t);
 }
 
-// função auxiliar para duplicar uma linha da tabela
-// utilizada na função table_filter
-// como precisamos de retornar uma nova tabela na função table_filter precisamos de duplicar as linhas que satisfazem o predicado
-static char **duplicate_row(size_t num_cols, char **src_row)
+// função auxiliar para ler uma linha do CSV a partir de p
+// as células (no máximo limit) ficam em row; o número de campos lidos fica em num_fields
+// in_place: o buffer é o ficheiro mapeado e as células ficam como vistas sobre ele (o buffer
+// nunca é alterado); só os campos com aspas escapadas são copiados para a arena
+// caso contrário (e para o último campo do buffer, que não tem separador) são copiadas para a arena
+// devolve a posição a seguir à linha (NULL em erro); em sep fica o separador do último campo
+static char *parse_row(struct table *t, struct csv_scanner *sc, char *p, bool in_place,
+                       char **row, size_t limit, size_t *num_fields, int *sep)
 {
-    char **new_row = malloc(num_cols * sizeof(char *));
-    if (!new_row)
-        return NULL;
+    struct csv_field field;
+    size_t col = 0;
 
-    for (size_t i = 0; i < num_cols; i++)
+    do
     {
-        // Aloca e copia a string de cada célula
-        // Se src_row[i] for NULL (célula vazia), mantemos NULL ou string vazia
-        if (src_row[i])
+        p = csv_next_field(sc, p, &field);
+
+        char *cell;
+        if (in_place && field.sep != 0 && !field.escaped)
+            cell = (char *)field.begin;
+        else if (field.escaped)
         {
-            new_row[i] = strdup(src_row[i]); // strdup aloca e copia
-            if (!new_row[i])
-            {
-                // Em caso de falha a meio, limpar o que já foi feito
-                for (size_t k = 0; k < i; k++)
-                    free(new_row[k]);
-                free(new_row);
+            size_t raw_len = field.raw_end - field.begin;
+            cell = arena_alloc(t, raw_len + 1);
+            if (!cell)
                 return NULL;
-            }
+            cell[csv_unquote(cell, field.begin, raw_len)] = '\0';
         }
         else
         {
-            new_row[i] = NULL;
+            cell = arena_strndup(t, field.begin, field.len);
+            if (!cell)
+                return NULL;
         }
+
+        // células para além do número de colunas da tabela são ignoradas
+        if (col < limit)
+            row[col] = cell;
+        col++;
+    } while (field.sep == ',');
+
+    *num_fields = col;
+    *sep = field.sep;
+
+    return p;
+}
+
+// função auxiliar para ler as linhas do buffer [buf, end) para a tabela
+// se a tabela ainda não tiver colunas, a primeira linha define o número de colunas (cabeçalho)
+// last: o buffer acaba no fim do ficheiro; se não for o caso, uma linha cortada no fim do buffer
+// não é adicionada e fica para a próxima leitura
+// devolve o número de bytes consumidos (-1 em erro); em last_sep (se não for NULL) fica o
+// separador do último campo lido (0 se acabou no fim do buffer)
+ssize_t load_rows(struct table *t, char *buf, char *end, bool in_place, bool last, int *last_sep)
+{
+    char *header[MAX_COLS];
+    struct csv_scanner sc;
+    char *p = buf;
+    int sep = '\n';
+
+    csv_scanner_init(&sc, buf, end);
+
+    while (p < end)
+    {
+        // linhas vazias são ignoradas (tal como na libcsv)
+        if (*p == '\n' || *p == '\r')
+        {
+            p++;
+            continue;
+        }
+
+        bool is_header = (t->num_cols == 0);
+        char **row = header;
+        size_t limit = MAX_COLS;
+
+        if (!is_header)
+        {
+            if (table_reserve_row(t) != 0)
+                return -1;
+            row = table_row(t, t->num_rows);
+            memset(row, 0, t->num_cols * sizeof(char *));
+            limit = t->num_cols;
+        }
+
+        char *row_start = p;
+        size_t num_fields;
+        p = parse_row(t, &sc, p, in_place, row, limit, &num_fields, &sep);
+        if (!p)
+            return -1;
+
+        // linha cortada pelo fim do buffer: volta a ser lida quando houver mais dados
+        if (sep == 0 && !last)
+            return row_start - buf;
+
+        if (is_header)
+        {
+            t->num_cols = num_fields < MAX_COLS ? num_fields : MAX_COLS;
+            if (table_reserve_row(t) != 0)
+                return -1;
+            memcpy(t->cells, header, t->num_cols * sizeof(char *));
+        }
+
+        t->num_rows++;
     }
-    return new_row;
+
+    if (last_sep)
+        *last_sep = sep;
+
+    return end - buf;
 }
 
-// quando uma linha termina, esta função é chamada
-void process_row(int c, void *data)
+// função para carregar uma tabela a partir de um ficheiro CSV
+// o ficheiro é lido em blocos de LOAD_BUFFER_SIZE bytes e as células são copiadas para a arena
+struct table *table_load_csv(const char *filename)
+{
+    return table_load_csv_progress(filename, NULL);
+}
+
+// função para carregar uma tabela a partir de um ficheiro CSV, com progresso e cancelamento
+// (progress pode ser NULL); o progresso é atualizado depois de cada bloco lido
+struct table *table_load_csv_progress(const char *filename, struct table_load_progress *progress)
 {
-    struct load_context *ctx = (struct load_context *)data;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
 
-    // se acabamos de ler a primeira linha, definimos o número de colunas da tabela
-    if (ctx->current_row == 0)
+    struct stat st;
+    if (progress && fstat(fd, &st) == 0)
+        __atomic_store_n(&progress->total_bytes, (size_t)st.st_size, __ATOMIC_RELAXED);
+
+    // alocar a estrutura da tabela
+    // a matriz de células só é alocada quando soubermos o número de colunas
+    struct table *t = table_create(0);
+    size_t capacity = LOAD_BUFFER_SIZE;
+    char *buf = malloc(capacity);
+    if (!t || !buf)
     {
-        ctx->table->num_cols = ctx->current_col;
+        table_free(t);
+        free(buf);
+        close(fd);
+        return NULL;
     }
 
-    // verificar se precisamos de aumentar a capacidade do array de ponteiros para linhas
-    if (ctx->table->num_rows >= ctx->table->pointer_array_capacity)
+    size_t valid = 0; // bytes do buffer ainda por ler (o início de uma linha cortada)
+
+    for (;;)
     {
-        // duplicamos a capacidade do array de ponteiros caso seja necessário
-        size_t new_capacity = ctx->table->pointer_array_capacity * 2;
-        if (new_capacity == 0)
-            new_capacity = INITIAL_POINTER_ARR_CAPACITY;
+        // uma linha maior que o buffer: duplicar o buffer
+        if (valid == capacity)
+        {
+            char *new_buf = realloc(buf, capacity * 2);
+            if (!new_buf)
+                break;
+            buf = new_buf;
+            capacity *= 2;
+        }
+
+        ssize_t bytes_read = read(fd, buf + valid, capacity - valid);
+        if (bytes_read < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        bool eof = (bytes_read == 0);
+        valid += bytes_read;
+
+        // ler as linhas completas; o resto passa para o início do buffer
+        ssize_t used = load_rows(t, buf, buf + valid, false, eof, NULL);
+        if (used < 0)
+            break;
+
+        memmove(buf, buf + used, valid - used);
+        valid -= used;
 
-        // realocar a memória de data para a nova capacidade
-        // char ** porque é um array de ponteiros para linhas
-        char ***new_data = realloc(ctx->table->data, new_capacity * sizeof(char **));
+        if (progress)
+        {
+            __atomic_fetch_add(&progress->bytes_read, (size_t)bytes_read, __ATOMIC_RELAXED);
+            __atomic_store_n(&progress->rows, t->num_rows, __ATOMIC_RELAXED);
+        }
+
+        if (eof)
+        {
+            free(buf);
+            close(fd);
+            return t;
+        }
 
-        // atualizar o ponteiro da tabela para a nova área de memória e a capacidade
-        ctx->table->data = new_data;
-        ctx->table->pointer_array_capacity = new_capacity;
+        // cancelado por outra thread: a tabela parcial é descartada
+        if (progress && __atomic_load_n(&progress->cancel, __ATOMIC_RELAXED))
+        {
+            free(buf);
+            table_free(t);
+            close(fd);
+            return NULL;
+        }
     }
 
-    // adicionar a linha temporária à tabela
-    ctx->table->data[ctx->table->num_rows] = ctx->temp_row;
-    // incrementar o número de linhas na tabela
-    ctx->table->num_rows++;
-    // preparar para a próxima linha
-    ctx->current_row++;
-    // meter a coluna atual a zero para a próxima linha
-    ctx->current_col = 0;
+    // erro de leitura ou de memória
+    fprintf(stderr, "erro ao processar csv: %s\n", filename);
+    free(buf);
+    table_free(t);
+    close(fd);
+    return NULL;
+}
+
+// leitor de CSV em streaming: só uma linha de cada vez está em memória
+struct table_reader
+{
+    int fd;
+    char *buf;              // buffer de leitura do ficheiro
+    size_t capacity;
+    size_t valid;           // bytes válidos no buffer
+    size_t pos;             // início da próxima linha no buffer
+    bool eof;
+    bool error;
+    struct csv_scanner sc;
+    struct table *scratch;  // arena reutilizada para as células da linha atual
+    char *row[MAX_COLS];    // linha atual (reutilizada em todas as chamadas)
+    size_t num_cols;        // 0 até ser lida a primeira linha
+};
 
-    // alocar uma nova linha temporária para a próxima linha
-    if (ctx->table->num_cols > 0)
+// função auxiliar para esvaziar a arena de uma tabela sem devolver a memória
+// fica só o bloco mais recente (o maior), para ser reutilizado
+void arena_reset(struct table *t)
+{
+    struct arena_block *block = t->arena;
+    if (!block)
+        return;
+
+    struct arena_block *next = block->next;
+    while (next)
     {
-        // como já sabemos o tamanho exato de colunas da tabela
-        // alocamos linha temporária com o tamanho correto
-        ctx->temp_row = malloc(ctx->table->num_cols * sizeof(char *));
-        if (ctx->temp_row)
-            // inicializar a linha temporária a zero
-            memset(ctx->temp_row, 0, ctx->table->num_cols * sizeof(char *));
+        struct arena_block *tmp = next->next;
+        free(next);
+        next = tmp;
     }
-    else
+
+    block->next = NULL;
+    block->used = 0;
+}
+
+// função auxiliar para voltar a encher o buffer do leitor
+// o que falta ler (uma linha cortada a meio) passa para o início do buffer
+static int reader_fill(struct table_reader *reader)
+{
+    memmove(reader->buf, reader->buf + reader->pos, reader->valid - reader->pos);
+    reader->valid -= reader->pos;
+    reader->pos = 0;
+
+    // uma linha maior que o buffer: duplicar o buffer
+    if (reader->valid == reader->capacity)
     {
-        ctx->temp_row = NULL;
+        char *new_buf = realloc(reader->buf, reader->capacity * 2);
+        if (!new_buf)
+            return -1;
+        reader->buf = new_buf;
+        reader->capacity *= 2;
     }
+
+    ssize_t bytes_read;
+    do
+    {
+        bytes_read = read(reader->fd, reader->buf + reader->valid, reader->capacity - reader->valid);
+    } while (bytes_read < 0 && errno == EINTR);
+
+    if (bytes_read < 0)
+        return -1;
+
+    reader->eof = (bytes_read == 0);
+    reader->valid += bytes_read;
+    csv_scanner_init(&reader->sc, reader->buf, reader->buf + reader->valid);
+
+    return 0;
 }
 
-// função para carregar uma tabela a partir de um ficheiro CSV
-struct table *table_load_csv(const char *filename)
+// função para abrir um ficheiro CSV para leitura linha a linha
+struct table_reader *table_reader_open(const char *filename)
 {
-    FILE *fp = fopen(filename, "rb");
-    if (!fp)
+    struct table_reader *reader = calloc(1, sizeof(struct table_reader));
+    if (!reader)
         return NULL;
 
-    // alocar a estrutura da tabela
-    struct table *t = malloc(sizeof(struct table));
-    if (!t)
+    reader->fd = open(filename, O_RDONLY);
+    reader->capacity = LOAD_BUFFER_SIZE;
+    reader->buf = malloc(reader->capacity);
+    reader->scratch = table_create(0);
+
+    if (reader->fd < 0 || !reader->buf || !reader->scratch)
     {
-        fclose(fp);
+        table_reader_close(reader);
         return NULL;
     }
 
-    // inicializar a estrutura da tabela
-    t->num_rows = 0;
-    t->num_cols = 0;
-    t->pointer_array_capacity = INITIAL_POINTER_ARR_CAPACITY;
-    t->data = malloc(t->pointer_array_capacity * sizeof(char **));
+    csv_scanner_init(&reader->sc, reader->buf, reader->buf);
+
+    return reader;
+}
 
-    if (!t->data)
+// função para ler a próxima linha do ficheiro
+// a primeira linha (cabeçalho) define o número de colunas, tal como em table_load_csv
+char **table_reader_next(struct table_reader *reader)
+{
+    if (reader->error)
+        return NULL;
+
+    for (;;)
     {
-        free(t);
-        fclose(fp);
+        char *p = reader->buf + reader->pos;
+        char *end = reader->buf + reader->valid;
+
+        // linhas vazias são ignoradas
+        while (p < end && (*p == '\n' || *p == '\r'))
+            p++;
+        reader->pos = p - reader->buf;
+
+        if (p == end)
+        {
+            if (reader->eof)
+                return NULL;
+            if (reader_fill(reader) != 0)
+                break;
+            continue;
+        }
+
+        // as células da linha anterior deixam de ser precisas
+        arena_reset(reader->scratch);
+        memset(reader->row, 0, sizeof(reader->row));
+
+        size_t limit = reader->num_cols ? reader->num_cols : MAX_COLS;
+        size_t num_fields;
+        int sep;
+        char *next = parse_row(reader->scratch, &reader->sc, p, false, reader->row, limit, &num_fields, &sep);
+        if (!next)
+            break;
+
+        // linha cortada pelo fim do buffer: ler mais e voltar a tentar
+        if (sep == 0 && !reader->eof)
+        {
+            if (reader_fill(reader) != 0)
+                break;
+            continue;
+        }
+
+        reader->pos = next - reader->buf;
+        if (reader->num_cols == 0)
+            reader->num_cols = num_fields < MAX_COLS ? num_fields : MAX_COLS;
+
+        return reader->row;
+    }
+
+    reader->error = true;
+    return NULL;
+}
+
+// função para obter o número de colunas (0 antes de ser lida a primeira linha)
+size_t table_reader_num_cols(const struct table_reader *reader)
+{
+    return reader->num_cols;
+}
+
+// função para saber se a leitura parou por um erro (e não por ter chegado ao fim do ficheiro)
+bool table_reader_error(const struct table_reader *reader)
+{
+    return reader->error;
+}
+
+// função para fechar o leitor e libertar a memória
+void table_reader_close(struct table_reader *reader)
+{
+    if (!reader)
+        return;
+
+    if (reader->fd >= 0)
+        close(reader->fd);
+    free(reader->buf);
+    table_free(reader->scratch);
+    free(reader);
+}
+
+// função auxiliar para mapear um ficheiro em memória numa tabela vazia
+// a tabela fica dona do mapeamento (map_addr fica a NULL se o ficheiro estiver vazio)
+static struct table *table_map_file(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
         return NULL;
     }
 
-    // inicializar o parser CSV
-    struct csv_parser p;
-    if (csv_init(&p, 0) != 0)
+    struct table *t = table_create(0);
+    if (!t)
     {
-        free(t->data);
-        free(t);
-        fclose(fp);
+        close(fd);
         return NULL;
     }
 
-    // configurar o parser para não remover espaços em branco
-    csv_set_space_func(&p, is_not_space);
+    // um ficheiro vazio dá uma tabela vazia (não é possível mapear 0 bytes)
+    if (st.st_size > 0)
+    {
+        // só para leitura: as páginas do ficheiro são partilhadas com a cache e nunca copiadas
+        char *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED)
+        {
+            table_free(t);
+            close(fd);
+            return NULL;
+        }
+
+        t->map_addr = base;
+        t->map_size = st.st_size;
+        t->lazy_cols = ALL_COLUMNS;
+    }
+
+    close(fd);
+
+    return t;
+}
+
+// função para carregar uma tabela a partir de um ficheiro CSV mapeado em memória
+// as células ficam como vistas sobre o mapeamento, em vez de serem copiadas
+struct table *table_load_csv_mmap(const char *filename)
+{
+    struct table *t = table_map_file(filename);
+    if (!t || !t->map_addr)
+        return t;
 
-    // inicializar o contexto de carregamento
-    // aponta para a tabela que estamos a preencher
-    struct load_context ctx;
-    ctx.table = t;
-    ctx.current_col = 0;
-    ctx.current_row = 0;
-    ctx.temp_row = NULL;
+    char *base = t->map_addr;
 
-    char buf[1024];
-    size_t bytes_read;
+    // o ficheiro é lido uma única vez, do início ao fim
+    madvise(base, t->map_size, MADV_SEQUENTIAL);
 
-    // ler o ficheiro em blocos e processar o CSV
-    // cada célula e linha lida invoca as funções de callback definidas (process_cell e process_row)
-    while ((bytes_read = fread(buf, 1, 1024, fp)) > 0)
+    if (load_rows(t, base, base + t->map_size, true, true, NULL) < 0)
     {
-        if (csv_parse(&p, buf, bytes_read, process_cell, process_row, &ctx) != bytes_read)
-        {
-            fprintf(stderr, "erro ao processar csv: %s\n", csv_strerror(csv_error(&p)));
-            break;
-        }
+        table_free(t);
+        return NULL;
     }
 
-    csv_fini(&p, process_cell, process_row, &ctx);
+    return t;
+}
+
+// intervalo do ficheiro analisado no carregamento paralelo
+struct parse_chunk
+{
+    char *begin;
+    char *end;
+    size_t num_quotes;   // número de aspas no intervalo (primeira passagem)
+    struct table *table; // linhas lidas do intervalo (segunda passagem)
+    int status;
+    int last_sep;
+};
+
+// primeira passagem: contar as aspas do intervalo
+// a paridade das aspas antes de uma posição diz se essa posição está dentro de aspas
+static void count_quotes_task(void *arg, size_t index)
+{
+    struct parse_chunk *chunk = (struct parse_chunk *)arg + index;
+    size_t count = 0;
+    char *p = chunk->begin;
 
-    // aqui estamos a libertar memória alocada porque na função process_row é alocada sempre memória para a próxima row
-    // quando chegamos ao fim do ficheiro e não temos mais rows para ler, ele aloca à mesma memória para a próxima row
-    if (ctx.temp_row != NULL)
+    while (p < chunk->end && (p = memchr(p, '"', chunk->end - p)) != NULL)
     {
-        free(ctx.temp_row);
+        count++;
+        p++;
     }
 
-    csv_free(&p);
-    fclose(fp);
+    chunk->num_quotes = count;
+}
+
+// segunda passagem: analisar as linhas do intervalo para a tabela do intervalo
+static void parse_chunk_task(void *arg, size_t index)
+{
+    struct parse_chunk *chunk = (struct parse_chunk *)arg + index;
 
-    return t;
+    chunk->status = load_rows(chunk->table, chunk->begin, chunk->end, true, true, &chunk->last_sep) < 0 ? -1 : 0;
 }
 
-// função para salvar uma tabela num ficheiro CSV
-void table_save_csv(const struct table *table, const char *filename)
+// função auxiliar para encontrar o fim da primeira linha a partir de p
+// quote_parity indica se p está dentro de aspas
+static char *find_row_end(char *p, char *end, int quote_parity)
 {
-    FILE *fp = fopen(filename, "wb");
-    if (!fp)
-        return;
+    while (p < end)
+    {
+        if (*p == '"')
+            quote_parity ^= 1;
+        else if ((*p == '\n' || *p == '\r') && !quote_parity)
+            return p + 1;
+        p++;
+    }
 
-    for (size_t i = 0; i < table->num_rows; i++)
+    return end;
+}
+
+// função para carregar uma tabela com várias threads
+// o ficheiro é dividido em intervalos de bytes, as fronteiras são acertadas para o início de uma linha
+// (fora de aspas) e cada intervalo é analisado por uma thread; no fim as linhas são juntas por ordem
+struct table *table_load_csv_parallel(const char *filename, int num_threads)
+{
+    if (num_threads <= 1)
+        return table_load_csv_mmap(filename);
+
+    struct table *t = table_map_file(filename);
+    if (!t || !t->map_addr)
+        return t;
+
+    char *base = t->map_addr;
+    char *end = base + t->map_size;
+
+    // o cabeçalho é lido primeiro, para sabermos o número de colunas
+    char *data = base;
+    while (data < end && (*data == '\n' || *data == '\r'))
+        data++;
+    data = find_row_end(data, end, 0);
+
+    if (load_rows(t, base, data, true, true, NULL) < 0)
+    {
+        table_free(t);
+        return NULL;
+    }
+
+    // intervalos demasiado pequenos não compensam o custo das threads
+    size_t data_size = end - data;
+    size_t num_chunks = data_size / PARALLEL_MIN_CHUNK_SIZE;
+    if (num_chunks > (size_t)num_threads)
+        num_chunks = num_threads;
+
+    if (num_chunks <= 1 || t->num_cols == 0)
     {
-        for (size_t j = 0; j < table->num_cols; j++)
+        if (load_rows(t, data, end, true, true, NULL) < 0)
         {
-            char *str = table->data[i][j];
-            int needs_quotes = 0;
-            size_t len = strlen(str);
+            table_free(t);
+            return NULL;
+        }
+        return t;
+    }
 
-            // Verificar se a célula precisa de aspas
-            // (Se tiver virgulas, aspas, ou quebras de linha)
-            for (size_t k = 0; k < len; k++)
-            {
-                if (str[k] == ',' || str[k] == '"' || str[k] == '\n' || str[k] == '\r')
-                {
-                    needs_quotes = 1;
-                    break;
-                }
-            }
+    struct parse_chunk *chunks = calloc(num_chunks, sizeof(struct parse_chunk));
+    if (!chunks)
+    {
+        table_free(t);
+        return NULL;
+    }
 
-            if (needs_quotes)
-            {
-                fputc('"', fp); // Abre aspas
-                for (size_t k = 0; k < len; k++)
-                {
-                    if (str[k] == '"')
-                    {
-                        fputc('"', fp); // Escapa aspa dupla (" torna-se "")
-                    }
-                    fputc(str[k], fp);
-                }
-                fputc('"', fp); // Fecha aspas
-            }
-            else
-            {
-                // Se não tiver caracteres especiais, escreve normalmente
-                fprintf(fp, "%s", str);
-            }
+    // primeira passagem: contar as aspas de cada intervalo (com fronteiras nominais)
+    for (size_t k = 0; k < num_chunks; k++)
+    {
+        chunks[k].begin = data + k * (data_size / num_chunks);
+        chunks[k].end = (k == num_chunks - 1) ? end : data + (k + 1) * (data_size / num_chunks);
+    }
+    thread_pool_run(num_threads, count_quotes_task, chunks, num_chunks);
+
+    // acertar as fronteiras: cada intervalo começa a seguir ao primeiro fim de linha fora de aspas
+    // (a paridade é dada pelo número de aspas antes da fronteira nominal)
+    size_t quotes_before = 0;
+    char *prev = data;
+    for (size_t k = 1; k < num_chunks; k++)
+    {
+        quotes_before += chunks[k - 1].num_quotes;
+        char *start = find_row_end(chunks[k].begin, end, quotes_before & 1);
+        if (start < prev)
+            start = prev;
+        chunks[k - 1].end = start;
+        chunks[k].begin = start;
+        prev = start;
+    }
+    chunks[0].begin = data;
+    chunks[num_chunks - 1].end = end;
+
+    // segunda passagem: as linhas de cada intervalo são lidas para uma tabela própria
+    int ok = 1;
+    for (size_t k = 0; k < num_chunks; k++)
+    {
+        chunks[k].table = table_create(t->num_cols);
+        if (!chunks[k].table)
+            ok = 0;
+    }
+
+    if (ok)
+        thread_pool_run(num_threads, parse_chunk_task, chunks, num_chunks);
+
+    // validar as fronteiras: cada intervalo (exceto o último) tem de acabar num fim de linha
+    // se não acabar (aspas soltas a meio de um campo trocam a paridade), a fronteira estava
+    // dentro de um campo e voltamos ao carregamento sequencial
+    size_t total_rows = t->num_rows;
+    for (size_t k = 0; ok && k < num_chunks; k++)
+    {
+        if (chunks[k].status != 0 || (k < num_chunks - 1 && chunks[k].last_sep == 0))
+            ok = 0;
+        else
+            total_rows += chunks[k].table->num_rows;
+    }
 
-            // Adicionar separador se não for a última coluna
-            if (j < table->num_cols - 1)
-                fprintf(fp, ",");
+    char **cells = NULL;
+    if (ok)
+    {
+        cells = realloc(t->cells, total_rows * t->num_cols * sizeof(char *));
+        if (!cells)
+            ok = 0;
+    }
+
+    if (!ok)
+    {
+        for (size_t k = 0; k < num_chunks; k++)
+            table_free(chunks[k].table);
+        free(chunks);
+        table_free(t);
+        return table_load_csv_mmap(filename);
+    }
+
+    // juntar as linhas de cada intervalo, por ordem, e passar as arenas para a tabela final
+    t->cells = cells;
+    t->pointer_array_capacity = total_rows;
+    for (size_t k = 0; k < num_chunks; k++)
+    {
+        struct table *part = chunks[k].table;
+
+        memcpy(table_row(t, t->num_rows), part->cells,
+               part->num_rows * t->num_cols * sizeof(char *));
+        t->num_rows += part->num_rows;
+
+        if (part->arena)
+        {
+            struct arena_block *last = part->arena;
+            while (last->next)
+                last = last->next;
+            last->next = t->arena;
+            t->arena = part->arena;
+            part->arena = NULL;
         }
-        // Fim da linha
-        fprintf(fp, "\n");
+
+        table_free(part);
     }
 
-    fclose(fp);
+    free(chunks);
+
+    return t;
 }
 
 // função para filtrar uma tabela com base num predicado
@@ -307,87 +975,257 @@ struct table *table_filter(const struct table *table,
                            bool (*predicate)(const void *row, const void *context),
                            const void *context)
 {
-    // Alocar a estrutura da nova tabela
-    struct table *new_table = malloc(sizeof(struct table));
-    if (!new_table)
+    // o predicado pode ler qualquer coluna
+    if (table_materialize_columns(table, ALL_COLUMNS) != 0)
         return NULL;
 
-    // Inicializar metadados
-    new_table->num_cols = table->num_cols;
-    new_table->num_rows = 0;
-    new_table->pointer_array_capacity = INITIAL_POINTER_ARR_CAPACITY;
-    new_table->data = malloc(new_table->pointer_array_capacity * sizeof(char **));
-
-    if (!new_table->data)
-    {
-        free(new_table);
+    // Alocar a estrutura da nova tabela
+    struct table *new_table = table_create(table->num_cols);
+    if (!new_table)
         return NULL;
-    }
 
     // Iterar sobre as linhas da tabela original
     for (size_t i = 0; i < table->num_rows; i++)
     {
         // Obter a linha atual
-        char **current_row = table->data[i];
+        char **current_row = table_row(table, i);
         // Verificar se a linha satisfaz o predicado
         if (predicate((const void *)current_row, context))
         {
-            // Verificar se precisamos de aumentar a capacidade do array de ponteiros para linhas
-            // duplicamos a capacidade se necessário
-            if (new_table->num_rows >= new_table->pointer_array_capacity)
+            // Verificar se precisamos de aumentar a capacidade da matriz de células
+            if (table_reserve_row(new_table) != 0)
             {
-                size_t new_cap = new_table->pointer_array_capacity * 2;
-                char ***new_data_ptr = realloc(new_table->data, new_cap * sizeof(char **));
-
-                if (!new_data_ptr)
-                {
-                    table_free(new_table);
-                    return NULL;
-                }
-                new_table->data = new_data_ptr;
-                new_table->pointer_array_capacity = new_cap;
+                table_free(new_table);
+                return NULL;
             }
 
-            // Duplicar a linha
-            char **row_copy = duplicate_row(new_table->num_cols, current_row);
-            if (!row_copy)
+            // Copiar as células da linha para a arena da nova tabela
+            // Se a célula for NULL (célula em falta), mantemos NULL
+            char **row_copy = table_row(new_table, new_table->num_rows);
+            for (size_t j = 0; j < new_table->num_cols; j++)
             {
-                table_free(new_table);
-                return NULL;
+                row_copy[j] = NULL;
+                if (current_row[j])
+                {
+                    row_copy[j] = arena_strndup(new_table, current_row[j], strlen(current_row[j]));
+                    if (!row_copy[j])
+                    {
+                        table_free(new_table);
+                        return NULL;
+                    }
+                }
             }
 
-            // Adicionar a linha duplicada à nova tabela
-            new_table->data[new_table->num_rows] = row_copy;
             new_table->num_rows++;
         }
     }
 
     return new_table;
 }
-// função para eliminar uma linha da tabela
-int table_delete_row(struct table *table, size_t row_index)
+
+// função auxiliar para filtrar uma tabela sem copiar as linhas (table_filter_view, com as
+// colunas lidas pelo predicado já copiadas do ficheiro mapeado)
+static struct table *filter_view(const struct table *table,
+                                 bool (*predicate)(const void *row, const void *context),
+                                 const void *context)
 {
-    if (!table || row_index >= table->num_rows)
-        return -1;
+    // as linhas eliminadas são removidas antes de percorrer a tabela
+    if (table_flush_deletes(table) != 0)
+        return NULL;
+
+    // os índices da seleção têm 32 bits; tabelas maiores são copiadas
+    if (table->num_rows > UINT32_MAX)
+        return table_filter(table, predicate, context);
+
+    // uma vista de uma vista seleciona diretamente as linhas da tabela de origem
+    struct table *source = table->source ? table->source : (struct table *)table;
+
+    struct table *view = table_create(table->num_cols);
+    if (!view)
+        return NULL;
 
-    // Libertar a memória da linha a eliminar
-    if (table->data[row_index])
+    // reservamos logo o máximo possível (4 bytes por linha) e encolhemos no fim
+    view->selection = malloc((table->num_rows ? table->num_rows : 1) * sizeof(uint32_t));
+    if (!view->selection)
     {
-        for (size_t j = 0; j < table->num_cols; j++)
-        {
-            free(table->data[row_index][j]);
-        }
-        free(table->data[row_index]);
+        free(view);
+        return NULL;
     }
 
-    // Mover todas as linhas seguintes uma posição para cima
-    for (size_t i = row_index; i < table->num_rows - 1; i++)
+    for (size_t i = 0; i < table->num_rows; i++)
     {
-        table->data[i] = table->data[i + 1];
+        if (predicate((const void *)table_row(table, i), context))
+            view->selection[view->num_rows++] = (uint32_t)table_physical_row(table, i);
     }
 
-    // Decrementar o número de linhas
-    table->num_rows--;
+    uint32_t *selection = realloc(view->selection, (view->num_rows ? view->num_rows : 1) * sizeof(uint32_t));
+    if (selection)
+        view->selection = selection;
+    view->pointer_array_capacity = view->num_rows;
 
-    return 0;
+    view->source = source;
+    source->refcount++;
+
+    return view;
+}
+
+// função para filtrar uma tabela sem copiar as linhas
+// o resultado é uma vista: um array com os índices das linhas que satisfazem o predicado
+// sobre a tabela original, que fica viva enquanto a vista existir
+struct table *table_filter_view(const struct table *table,
+                                bool (*predicate)(const void *row, const void *context),
+                                const void *context)
+{
+    if (table_materialize_columns(table, ALL_COLUMNS) != 0)
+        return NULL;
+
+    return filter_view(table, predicate, context);
+}
+
+// função auxiliar para criar uma vista com as linhas rows da tabela
+struct table *table_create_view(const struct table *table, const uint32_t *rows, size_t num_rows)
+{
+    struct table *source = table->source ? table->source : (struct table *)table;
+
+    struct table *view = table_create(table->num_cols);
+    if (!view)
+        return NULL;
+
+    view->selection = malloc((num_rows ? num_rows : 1) * sizeof(uint32_t));
+    if (!view->selection)
+    {
+        free(view);
+        return NULL;
+    }
+
+    // os índices de uma vista são convertidos em índices da tabela de origem
+    for (size_t i = 0; i < num_rows; i++)
+        view->selection[i] = (uint32_t)table_physical_row(table, rows[i]);
+
+    view->num_rows = num_rows;
+    view->pointer_array_capacity = num_rows;
+    view->source = source;
+    source->refcount++;
+
+    return view;
+}
+
+// partição de linhas avaliada por uma tarefa de table_filter_parallel
+struct filter_part
+{
+    const struct table *table;
+    bool (*predicate)(const void *row, const void *context);
+    const void *context;
+    uint32_t *selection; // seleção final (cada partição escreve a partir do seu início)
+    size_t rows_per_part;
+    size_t *counts;      // linhas aceites em cada partição
+};
+
+// função auxiliar para avaliar o predicado numa partição de linhas
+// os índices aceites ficam em selection a partir da posição da primeira linha da partição
+// (nunca há mais aceites que linhas, por isso as partições não se sobrepõem)
+static void filter_part_task(void *arg, size_t index)
+{
+    struct filter_part *part = (struct filter_part *)arg;
+    const struct table *table = part->table;
+    size_t begin = index * part->rows_per_part;
+    size_t end = begin + part->rows_per_part;
+    if (end > table->num_rows)
+        end = table->num_rows;
+
+    uint32_t *out = part->selection + begin;
+    size_t count = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (part->predicate((const void *)table_row(table, i), part->context))
+            out[count++] = (uint32_t)table_physical_row(table, i);
+    }
+
+    part->counts[index] = count;
+}
+
+// função auxiliar para filtrar uma tabela com várias threads (table_filter_parallel, com as
+// colunas lidas pelo predicado já copiadas do ficheiro mapeado)
+static struct table *filter_parallel(const struct table *table,
+                                     bool (*predicate)(const void *row, const void *context),
+                                     const void *context, int num_threads)
+{
+    if (table_flush_deletes(table) != 0)
+        return NULL;
+
+    if (num_threads <= 1 || table->num_rows < FILTER_MIN_PART_ROWS || table->num_rows > UINT32_MAX)
+        return filter_view(table, predicate, context);
+
+    // várias partições por thread, para equilibrar a carga quando o predicado custa mais nalgumas linhas
+    size_t num_parts = (size_t)num_threads * 4;
+    size_t rows_per_part = (table->num_rows + num_parts - 1) / num_parts;
+    if (rows_per_part < FILTER_MIN_PART_ROWS)
+        rows_per_part = FILTER_MIN_PART_ROWS;
+    num_parts = (table->num_rows + rows_per_part - 1) / rows_per_part;
+
+    struct table *source = table->source ? table->source : (struct table *)table;
+    struct table *view = table_create(table->num_cols);
+    size_t *counts = calloc(num_parts, sizeof(size_t));
+    if (view)
+        view->selection = malloc(table->num_rows * sizeof(uint32_t));
+
+    if (!view || !view->selection || !counts)
+    {
+        free(counts);
+        if (view)
+            free(view->selection);
+        free(view);
+        return NULL;
+    }
+
+    struct filter_part part;
+    part.table = table;
+    part.predicate = predicate;
+    part.context = context;
+    part.selection = view->selection;
+    part.rows_per_part = rows_per_part;
+    part.counts = counts;
+
+    thread_pool_run(num_threads, filter_part_task, &part, num_parts);
+
+    // juntar os resultados das partições, por ordem
+    for (size_t k = 0; k < num_parts; k++)
+    {
+        memmove(view->selection + view->num_rows, view->selection + k * rows_per_part,
+                counts[k] * sizeof(uint32_t));
+        view->num_rows += counts[k];
+    }
+    free(counts);
+
+    uint32_t *selection = realloc(view->selection, (view->num_rows ? view->num_rows : 1) * sizeof(uint32_t));
+    if (selection)
+        view->selection = selection;
+    view->pointer_array_capacity = view->num_rows;
+
+    view->source = source;
+    source->refcount++;
+
+    return view;
+}
+
+// função para filtrar uma tabela com várias threads (o predicado tem de ser thread-safe)
+// as linhas são divididas em partições avaliadas pelo pool de threads e os resultados
+// são juntos pela ordem original; o resultado é uma vista, como em table_filter_view
+struct table *table_filter_parallel(const struct table *table,
+                                    bool (*predicate)(const void *row, const void *context),
+                                    const void *context, int num_threads)
+{
+    return table_filter_columns(table, predicate, context, num_threads, ALL_COLUMNS);
+}
+
+// função para filtrar uma tabela com várias threads, copiando antes do ficheiro mapeado só as
+// colunas cols (as que o predicado lê)
+struct table *table_filter_columns(const struct table *table,
+                                   bool (*predicate)(const void *row, const void *context),
+                                   const void *context, int num_threads, uint32_t cols)
+{
+    if (table_materialize_columns(table, cols) != 0)
+        return NULL;
+
+    return filter_parallel(table, predicate, context, num_threads);
 }
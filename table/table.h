@@ -2,34 +2,424 @@
 #define TABLE_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 #define MAX_COLS 26
 #define INITIAL_POINTER_ARR_CAPACITY 10
 
+// Tamanho do buffer de leitura de table_load_csv
+#define LOAD_BUFFER_SIZE (1024 * 1024)
+
+// Número máximo de lotes em cada fila do pipeline de table_filter_csv
+#define PIPELINE_QUEUE_DEPTH 4
+
+// Número máximo de threads das operações paralelas
+#define TABLE_MAX_THREADS 64
+
+// Número mínimo de linhas de cada partição de table_filter_parallel
+#define FILTER_MIN_PART_ROWS 4096
+
+// Número de linhas de cada lote passado aos kernels em lote (table_filter_batch, table_transform_batch)
+#define TABLE_BATCH_ROWS 4096
+
+// Número máximo de linhas da amostra usada por table_filter_expr para estimar a seletividade
+#define EXPR_SAMPLE_ROWS 1024
+
+// Número mínimo de linhas de cada parte ordenada por uma thread em table_sort
+#define SORT_MIN_RUN_ROWS 65536
+
+// Número mínimo de linhas de cada parte agregada por uma thread em table_group_by
+#define GROUP_MIN_PART_ROWS 65536
+
+// Número mínimo de linhas de cada parte procurada (e de cada bloco copiado) por uma thread em
+// table_hash_join
+#define JOIN_MIN_PART_ROWS 65536
+
+// Tamanho mínimo do intervalo do ficheiro analisado por cada thread (table_load_csv_parallel)
+#define PARALLEL_MIN_CHUNK_SIZE (1024 * 1024)
+
+// Tamanho do buffer de escrita de table_save_csv
+#define SAVE_BUFFER_SIZE (1024 * 1024)
+
+// Número de linhas de cada bloco formatado por uma thread em table_save_csv_parallel
+#define SAVE_CHUNK_ROWS 16384
+
+// Tamanho mínimo e máximo dos blocos da arena de strings
+#define ARENA_MIN_BLOCK_SIZE (64 * 1024)
+#define ARENA_MAX_BLOCK_SIZE (4 * 1024 * 1024)
+
+// Tipo de uma coluna (table_infer_types)
+enum column_type
+{
+    COLUMN_STRING,
+    COLUMN_INT64,
+    COLUMN_DOUBLE
+};
+
+// Número máximo de valores distintos de uma coluna com dicionário (table_dict_encode)
+#define DICT_MAX_DISTINCT 65536
+
+// Uma coluna só tem dicionário se cada valor aparecer, em média, pelo menos este número de vezes
+#define DICT_MIN_ROWS_PER_VALUE 16
+
+// Bloco da arena (definido em table.c)
+struct arena_block;
+
+// Linhas eliminadas ainda por compactar (definidas em table_internal.h)
+struct tombstones;
+
+// Informação extra de uma coluna, como os índices (definida em table_internal.h)
+struct column_info;
+
 struct table
 {
     size_t num_cols;
     size_t num_rows;
-    size_t pointer_array_capacity;
-    char ***data;
+    size_t pointer_array_capacity; // capacidade da matriz de células (em linhas)
+    char **cells;                  // matriz plana num_rows x num_cols, linha a linha (ler com table_get_row)
+    struct arena_block *arena;     // arena onde vivem as strings das células
+    void *map_addr;                // ficheiro mapeado em memória (table_load_csv_mmap), ou NULL
+    size_t map_size;
+    uint32_t lazy_cols;            // colunas que ainda podem ter células por copiar do ficheiro mapeado
+    struct table *source;          // tabela de origem, se esta tabela for uma vista (ou NULL)
+    uint32_t *selection;           // vista: índices das linhas selecionadas na tabela de origem
+    int refcount;                  // referências à tabela (a própria e as vistas que a usam)
+    struct column_info *columns;   // informação extra de cada coluna (NULL enquanto não for precisa)
+    struct tombstones *deleted;    // linhas eliminadas ainda por compactar (ou NULL)
 };
 
 // Carrega o CSV (Alínea b)
 struct table *table_load_csv(const char *filename);
 
+// Progresso de um carregamento (table_load_csv_progress)
+// os campos são atualizados pela thread que carrega e podem ser lidos por outras threads
+// (com __atomic_load_n); para cancelar, outra thread põe cancel a 1 (com __atomic_store_n)
+struct table_load_progress
+{
+    size_t total_bytes; // tamanho do ficheiro
+    size_t bytes_read;  // bytes já lidos
+    size_t rows;        // linhas já carregadas (incluindo o cabeçalho)
+    int cancel;
+};
+
+// Igual a table_load_csv, mas atualiza progress depois de cada bloco lido e pára se o
+// carregamento for cancelado (devolve NULL em erro ou se tiver sido cancelado)
+// progress tem de começar a zeros (ou ser NULL)
+struct table *table_load_csv_progress(const char *filename, struct table_load_progress *progress);
+
+// Carrega o CSV mapeando o ficheiro em memória (só para leitura)
+// as células ficam como vistas sobre o ficheiro mapeado, sem cópias; cada coluna só é copiada
+// para a arena (terminada com '\0') quando uma operação precisa dela, e cada linha quando é
+// lida com table_get_row (ver table_materialize)
+struct table *table_load_csv_mmap(const char *filename);
+
+// Carrega o CSV dividindo o ficheiro por num_threads threads
+struct table *table_load_csv_parallel(const char *filename, int num_threads);
+
+// Leitura do CSV linha a linha (streaming), em memória constante
+struct table_reader;
+
+// Abre o ficheiro para leitura (NULL em erro)
+struct table_reader *table_reader_open(const char *filename);
+
+// Lê a próxima linha (a primeira é o cabeçalho) e devolve as suas células
+// o array e as células são reutilizados: só são válidos até à próxima chamada
+// devolve NULL no fim do ficheiro ou em erro (ver table_reader_error)
+char **table_reader_next(struct table_reader *reader);
+
+// Número de colunas (definido pela primeira linha; 0 antes de a ler)
+size_t table_reader_num_cols(const struct table_reader *reader);
+
+// Indica se table_reader_next parou por um erro
+bool table_reader_error(const struct table_reader *reader);
+
+// Fecha o ficheiro e liberta o leitor
+void table_reader_close(struct table_reader *reader);
+
 // Salva o CSV (Alínea c)
-void table_save_csv(const struct table *table, const char *filename);
+// devolve o número de bytes escritos (-1 em erro)
+long table_save_csv(const struct table *table, const char *filename);
+
+// Igual a table_save_csv, mas as linhas são formatadas em blocos por num_threads threads
+// (os blocos são escritos pela ordem da tabela; o ficheiro é igual ao de table_save_csv)
+long table_save_csv_parallel(const struct table *table, const char *filename, int num_threads);
+
+// Guarda a tabela num snapshot binário (offsets das células + strings, secções alinhadas à
+// página, com versão e checksums), que table_load_snapshot carrega sem parsing
+// só o texto das células é guardado (tipos, dicionários e índices não)
+// devolve o número de bytes escritos (-1 em erro)
+long table_save_snapshot(const struct table *table, const char *filename);
+
+// Carrega um snapshot de table_save_snapshot mapeando o ficheiro em memória; as células apontam
+// diretamente para o ficheiro mapeado e os checksums são validados com num_threads threads
+// devolve NULL em erro (ficheiro inválido, de outra versão ou corrompido)
+struct table *table_load_snapshot(const char *filename, int num_threads);
+
+// Infere o tipo de cada coluna (int64, double ou string) a partir das células a seguir ao
+// cabeçalho, com num_threads threads; as colunas numéricas passam a ter também os valores
+// em arrays nativos (o texto das células não muda) (retorna 0 em sucesso, -1 em erro)
+int table_infer_types(struct table *table, int num_threads);
+
+// Tipo da coluna col (COLUMN_STRING se os tipos não tiverem sido inferidos)
+enum column_type table_column_type(const struct table *table, size_t col);
+
+// Valor da célula (row_index, col) de uma coluna COLUMN_INT64
+// devolve falso se a coluna não for desse tipo ou se a célula não tiver valor (vazia, cabeçalho)
+bool table_get_int64(const struct table *table, size_t row_index, size_t col, int64_t *value);
+
+// Valor da célula (row_index, col) de uma coluna numérica (COLUMN_INT64 ou COLUMN_DOUBLE)
+// devolve falso se a coluna não for numérica ou se a célula não tiver valor
+bool table_get_double(const struct table *table, size_t row_index, size_t col, double *value);
+
+// Cria um dicionário para cada coluna com poucos valores distintos (ver DICT_MAX_DISTINCT e
+// DICT_MIN_ROWS_PER_VALUE), com num_threads threads: cada valor distinto é guardado uma só vez
+// e cada linha guarda o código de 32 bits do seu valor; os filtros por igualdade nessas colunas
+// comparam códigos em vez de strings (retorna 0 em sucesso, -1 em erro)
+// se a tabela não for usada por vistas, as strings são também copiadas para uma arena nova,
+// sem repetições, e a memória antiga (ou o ficheiro mapeado) é libertada
+int table_dict_encode(struct table *table, int num_threads);
+
+// Indica se a coluna col tem dicionário
+bool table_has_dict(const struct table *table, size_t col);
 
 // Filtra a tabela (Alínea e)
 struct table *table_filter(const struct table *table,
                            bool (*predicate)(const void *row, const void *context),
                            const void *context);
 
+// Filtra a tabela sem copiar linhas: devolve uma vista sobre a tabela original
+// a vista funciona como qualquer outra tabela (show, save, filtros, ...) e mantém a
+// tabela original viva até ser libertada com table_free
+struct table *table_filter_view(const struct table *table,
+                                bool (*predicate)(const void *row, const void *context),
+                                const void *context);
+
+// Igual a table_filter_view, mas avalia o predicado em num_threads threads
+// (o predicado tem de poder ser chamado em paralelo); a ordem das linhas é mantida
+struct table *table_filter_parallel(const struct table *table,
+                                    bool (*predicate)(const void *row, const void *context),
+                                    const void *context, int num_threads);
+
+// Kernel de predicado em lote: marca keep[i - first] a verdadeiro para cada linha i de
+// [first, end) que fica (keep começa a falso); as linhas são lidas com table_get_row
+typedef void (*table_batch_predicate)(const struct table *table, size_t first, size_t end,
+                                      bool *keep, const void *context);
+
+// Saída de um lote de table_transform_batch (opaca)
+struct table_batch_output;
+
+// Kernel de transformação em lote: para cada linha i de [first, end) cuja célula da coluna col
+// muda, chama table_batch_set(out, i, ...); as linhas sem valor novo ficam como estão
+typedef void (*table_batch_transform)(const struct table *table, size_t col, size_t first, size_t end,
+                                      struct table_batch_output *out, const void *context);
+
+// Dá o novo valor (len bytes, copiados) à célula da linha row (retorna 0 em sucesso, -1 em erro)
+int table_batch_set(struct table_batch_output *out, size_t row, const char *value, size_t len);
+
+// Marca o lote como falhado (por exemplo, se o kernel não conseguir alocar memória): a coluna
+// não é alterada e table_transform_batch retorna -1
+void table_batch_fail(struct table_batch_output *out);
+
+// Filtra a tabela chamando o kernel uma vez por lote de TABLE_BATCH_ROWS linhas, com os lotes
+// distribuídos por num_threads threads (o kernel tem de poder ser chamado em paralelo)
+// o resultado é uma vista, como em table_filter_parallel, com a ordem das linhas mantida
+struct table *table_filter_batch(const struct table *table, table_batch_predicate kernel,
+                                 const void *context, int num_threads);
+
+// Altera a coluna col chamando o kernel uma vez por lote de TABLE_BATCH_ROWS linhas, com os lotes
+// distribuídos por num_threads threads; os valores novos só são aplicados se todos os lotes
+// correrem bem e os índices, tipos e dicionário da coluna são descartados
+// numa vista muda as células da tabela de origem, que não pode ser usada por outras vistas
+// (retorna 0 em sucesso, -1 em erro)
+int table_transform_batch(struct table *table, size_t col, table_batch_transform kernel,
+                          const void *context, int num_threads);
+
+// Expressão booleana sobre as células de uma linha (table_expr_parse)
+struct table_expr;
+
+// Compila uma expressão como "A = joaquim and E < 1.0 or not B = maca": comparações
+// <coluna> <op> <valor> (=, !=, <, <=, >, >=), com a coluna dada pela letra, ligadas por and,
+// or e not e agrupadas com parênteses (not antes de and, and antes de or); os valores com
+// espaços ou operadores vão entre aspas ("" é uma aspa)
+// = e != comparam strings; os outros operadores comparam números se o valor for um número
+// (as células que não são números ficam de fora) e strings (strcmp) se não for
+// devolve NULL em erro, com a mensagem em error (error_size bytes)
+struct table_expr *table_expr_parse(const char *text, size_t num_cols, char *error, size_t error_size);
+
+// Cria a comparação <col> <op> <value> (op: "=", "!=", "<", "<=", ">" ou ">="; NULL em erro)
+struct table_expr *table_expr_compare(size_t col, const char *op, const char *value);
+
+// Junta a e b com and e devolve a expressão resultante, que fica com os dois (os and seguidos
+// ficam num só nó); em erro devolve NULL e não altera a nem b
+struct table_expr *table_expr_and(struct table_expr *a, struct table_expr *b);
+
+// Avalia a expressão numa linha (pode ser usada como predicado de table_filter e afins)
+bool table_expr_match(const void *row, const void *expr);
+
+// Filtra a tabela pela expressão numa só passagem, com num_threads threads; os operandos de
+// cada and/or são primeiro reordenados pela seletividade estimada numa amostra das linhas,
+// para que a avaliação (com curto-circuito) decida o mais cedo possível, e as comparações usam
+// os valores já convertidos das colunas numéricas e os códigos das colunas com dicionário
+// o resultado é uma vista, como em table_filter_parallel
+struct table *table_filter_expr(const struct table *table, struct table_expr *expr, int num_threads);
+
+// Igual a table_filter_expr, mas só procura as primeiras max_rows linhas que satisfazem a
+// expressão: a passagem pela tabela pára assim que as encontra (ex: para mostrar o início do
+// resultado de um filtro sem o calcular todo)
+struct table *table_filter_expr_first(const struct table *table, struct table_expr *expr, size_t max_rows);
+
+// Liberta a expressão
+void table_expr_free(struct table_expr *expr);
+
+// Forma de comparar uma coluna de ordenação (table_sort)
+enum sort_type
+{
+    SORT_AUTO,    // numérica se todas as células forem números (ou vazias), string se não
+    SORT_NUMERIC, // as células que não são números ficam no fim
+    SORT_STRING   // strcmp
+};
+
+// Coluna de ordenação de table_sort
+struct table_sort_key
+{
+    size_t col;
+    bool descending;
+    enum sort_type type;
+};
+
+// Ordena as linhas pelas colunas keys (a segunda só desempata a primeira, e assim por diante),
+// com num_threads threads; a ordenação é estável, as células vazias (e, nas colunas numéricas,
+// as que não são números) ficam no fim e a primeira linha da tabela carregada (o cabeçalho)
+// fica no lugar
+// só mudam os ponteiros das linhas (numa vista, os índices da seleção): as strings não são
+// copiadas e os índices, tipos e dicionários das colunas acompanham as linhas
+// uma tabela base usada por vistas não pode ser ordenada (retorna 0 em sucesso, -1 em erro)
+int table_sort(struct table *table, const struct table_sort_key *keys, size_t num_keys, int num_threads);
+
+// Agregação calculada por table_group_by em cada grupo
+enum table_agg_op
+{
+    AGG_COUNT, // células não vazias da coluna (ou linhas do grupo, com TABLE_AGG_ROWS)
+    AGG_SUM,   // soma, mínimo, máximo e média das células da coluna que são números
+    AGG_MIN,
+    AGG_MAX,
+    AGG_AVG
+};
+
+// Coluna de AGG_COUNT para contar todas as linhas do grupo (count(*))
+#define TABLE_AGG_ROWS ((size_t)-1)
+
+// Agregação de uma coluna (table_group_by)
+struct table_aggregate
+{
+    enum table_agg_op op;
+    size_t col;
+};
+
+// Agrupa as linhas pelos valores das colunas key_cols e calcula as agregações aggs de cada grupo,
+// numa só passagem com num_threads threads (cada thread agrega uma parte das linhas numa tabela
+// hash própria e as tabelas parciais são juntadas no fim)
+// o resultado é uma tabela nova, com as colunas de chave seguidas das agregações: o cabeçalho
+// ("fruta", "sum(quantidade)", ...) e uma linha por grupo, pela ordem da primeira linha de cada
+// grupo; as agregações de um grupo sem números ficam vazias (exceto count)
+// a primeira linha da tabela carregada (o cabeçalho) não é agregada (devolve NULL em erro)
+struct table *table_group_by(const struct table *table, const size_t *key_cols, size_t num_keys,
+                             const struct table_aggregate *aggs, size_t num_aggs, int num_threads);
+
+// Junta as linhas de left e right com o mesmo valor (string) nas colunas left_col e right_col,
+// por hash: as linhas da tabela mais pequena vão para uma tabela hash e as da outra procuram o
+// seu valor, em paralelo com num_threads threads
+// o resultado é uma tabela nova, com as colunas de left seguidas das de right: o cabeçalho e uma
+// linha por par, pela ordem das linhas de left (e, para a mesma linha, pela ordem de right); as
+// células vazias (ou só com espaços) e as NULL nunca se juntam (devolve NULL em erro)
+struct table *table_hash_join(const struct table *left, size_t left_col, const struct table *right,
+                              size_t right_col, int num_threads);
+
+// Filtra um ficheiro CSV diretamente para outro, em streaming (sem carregar a tabela)
+// leitura, filtragem e escrita correm em threads diferentes, ligadas por filas limitadas
+// devolve o número de linhas escritas (-1 em erro)
+long table_filter_csv(const char *src_file, const char *dest_file,
+                      bool (*predicate)(const void *row, const void *context),
+                      const void *context);
+
+// Cria um índice hash (valor -> linhas) sobre a coluna col (retorna 0 em sucesso, -1 em erro)
+// o índice é mantido pelas eliminações (table_delete_*) e usado por table_filter_equals
+int table_create_index(struct table *table, size_t col);
+
+// Indica se a coluna col tem um índice hash
+bool table_has_index(const struct table *table, size_t col);
+
+// Cria um índice ordenado sobre a coluna col (retorna 0 em sucesso, -1 em erro)
+// as chaves são numéricas se todas as células da coluna, exceto o cabeçalho, forem números;
+// senão são strings (ordem de strcmp); tal como o índice hash, é mantido pelas eliminações
+int table_create_ordered_index(struct table *table, size_t col);
+
+// Indica se a coluna col tem um índice ordenado
+bool table_has_ordered_index(const struct table *table, size_t col);
+
+// Filtra as linhas com a célula da coluna col igual a value; o resultado é uma vista
+// com índice só são visitadas as linhas com esse valor; com dicionário são comparados os códigos;
+// sem nenhum dos dois a tabela é percorrida com num_threads threads (como em table_filter_parallel)
+struct table *table_filter_equals(const struct table *table, size_t col, const char *value, int num_threads);
+
+// Filtra as linhas com a célula da coluna col entre low e high; o resultado é uma vista
+// low ou high NULL: o intervalo não tem esse limite; *_inclusive: o limite faz parte do intervalo
+// a comparação é numérica se os limites forem números (as células que não são números ficam
+// de fora), senão é por strcmp; com um índice ordenado do mesmo tipo, o intervalo é encontrado
+// por pesquisa binária, senão a tabela é percorrida com num_threads threads
+struct table *table_filter_range(const struct table *table, size_t col,
+                                 const char *low, bool low_inclusive,
+                                 const char *high, bool high_inclusive, int num_threads);
+
+// Devolve a linha row_index da tabela (array com num_cols células, terminadas com '\0')
+// numa tabela carregada com table_load_csv_mmap (ou table_load_csv_parallel), as células da
+// linha que ainda estão só no ficheiro mapeado são copiadas primeiro, por isso, até a tabela
+// estar toda copiada (table_materialize), não pode ser chamada em paralelo (NULL se faltar memória)
+char **table_get_row(const struct table *table, size_t row_index);
+
+// Indica se a primeira linha da tabela é o cabeçalho (a primeira linha da tabela carregada)
+bool table_has_header(const struct table *table);
+
+// Copia para a arena as células das linhas [first, end) que ainda são vistas sobre o ficheiro
+// mapeado (com todas as linhas de uma tabela base, table_get_row deixa de copiar e pode ser
+// chamada em paralelo; 0 em sucesso, -1 em erro)
+int table_materialize(const struct table *table, size_t first, size_t end);
+
 // Elimina uma linha da tabela (retorna 0 em sucesso, -1 em erro)
+// numa vista a linha só sai da vista; uma tabela usada por vistas não pode ser alterada
+// a linha só é marcada como eliminada (O(log n)); as linhas marcadas são removidas de uma vez
+// antes da próxima operação que percorra a tabela (filtros, índices, save) ou com table_compact
 int table_delete_row(struct table *table, size_t row_index);
 
-// Liberta memória
+// Elimina count linhas seguidas a partir da linha first (devolve o número de linhas eliminadas,
+// -1 em erro)
+long table_delete_range(struct table *table, size_t first, size_t count);
+
+// Elimina as linhas que satisfazem o predicado, numa só passagem (devolve o número de linhas
+// eliminadas, -1 em erro)
+long table_delete_where(struct table *table,
+                        bool (*predicate)(const void *row, const void *context),
+                        const void *context);
+
+// Remove já as linhas eliminadas, numa só passagem (retorna 0 em sucesso, -1 em erro)
+int table_compact(struct table *table);
+
+// Memória usada por uma tabela, em bytes (table_memory_usage)
+struct table_memory
+{
+    size_t cell_strings;  // strings das células: blocos da arena e ficheiro mapeado
+    size_t arena_slack;   // espaço dos blocos da arena ainda por usar
+    size_t row_pointers;  // matriz de células (um ponteiro por célula)
+    size_t pointer_slack; // matriz reservada a mais (pointer_array_capacity além das linhas)
+    size_t selection;     // vista: índices das linhas selecionadas
+    size_t metadata;      // índices, tipos e dicionários das colunas, linhas eliminadas por compactar
+};
+
+// Calcula a memória usada pela tabela; numa vista inclui a tabela de origem, que a vista mantém viva
+void table_memory_usage(const struct table *table, struct table_memory *mem);
+
+// Liberta memória (numa tabela usada por vistas, só quando a última vista for libertada)
 void table_free(struct table *t);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "table.h"
+#include "table_internal.h"
+#include "thread_pool.h"
+
+// Kernels em lote (table_filter_batch / table_transform_batch)
+//
+// as linhas são divididas em lotes de TABLE_BATCH_ROWS linhas e cada lote é uma tarefa do
+// pool de threads: o kernel é chamado uma vez por lote, com o intervalo [first, end), em vez
+// de uma vez por linha, e vários lotes correm ao mesmo tempo
+// os kernels só leem a tabela; os resultados (linhas aceites, novos valores) são aplicados
+// depois de todos os lotes terminarem, pela ordem das linhas
+
+// função auxiliar para calcular o número de lotes de uma tabela
+static size_t num_batches(const struct table *table)
+{
+    return (table->num_rows + TABLE_BATCH_ROWS - 1) / TABLE_BATCH_ROWS;
+}
+
+// estado partilhado pelas tarefas de table_filter_batch
+struct filter_batch_job
+{
+    const struct table *table;
+    table_batch_predicate kernel;
+    const void *context;
+    uint32_t *selection; // cada lote escreve a partir da posição da sua primeira linha
+    size_t *counts;      // linhas aceites em cada lote
+};
+
+static void filter_batch_task(void *arg, size_t index)
+{
+    struct filter_batch_job *job = (struct filter_batch_job *)arg;
+    const struct table *table = job->table;
+    size_t first = index * TABLE_BATCH_ROWS;
+    size_t end = first + TABLE_BATCH_ROWS;
+    if (end > table->num_rows)
+        end = table->num_rows;
+
+    bool keep[TABLE_BATCH_ROWS];
+    memset(keep, 0, (end - first) * sizeof(bool));
+    job->kernel(table, first, end, keep, job->context);
+
+    uint32_t *out = job->selection + first;
+    size_t count = 0;
+    for (size_t i = first; i < end; i++)
+    {
+        if (keep[i - first])
+            out[count++] = (uint32_t)table_physical_row(table, i);
+    }
+
+    job->counts[index] = count;
+}
+
+// função para filtrar uma tabela com um kernel de predicado em lote, com num_threads threads
+struct table *table_filter_batch(const struct table *table, table_batch_predicate kernel,
+                                 const void *context, int num_threads)
+{
+    // o kernel pode ler qualquer coluna
+    if (table_flush_deletes(table) != 0 || table->num_rows > UINT32_MAX ||
+        table_materialize_columns(table, ALL_COLUMNS) != 0)
+        return NULL;
+
+    size_t batches = num_batches(table);
+    struct table *source = table->source ? table->source : (struct table *)table;
+    struct table *view = table_create(table->num_cols);
+    size_t *counts = calloc(batches ? batches : 1, sizeof(size_t));
+    if (view)
+        view->selection = malloc((table->num_rows ? table->num_rows : 1) * sizeof(uint32_t));
+
+    if (!view || !view->selection || !counts)
+    {
+        free(counts);
+        if (view)
+            free(view->selection);
+        free(view);
+        return NULL;
+    }
+
+    struct filter_batch_job job;
+    job.table = table;
+    job.kernel = kernel;
+    job.context = context;
+    job.selection = view->selection;
+    job.counts = counts;
+
+    thread_pool_run(num_threads, filter_batch_task, &job, batches);
+
+    // juntar os resultados dos lotes, por ordem
+    for (size_t k = 0; k < batches; k++)
+    {
+        memmove(view->selection + view->num_rows, view->selection + k * TABLE_BATCH_ROWS,
+                counts[k] * sizeof(uint32_t));
+        view->num_rows += counts[k];
+    }
+    free(counts);
+
+    uint32_t *selection = realloc(view->selection, (view->num_rows ? view->num_rows : 1) * sizeof(uint32_t));
+    if (selection)
+        view->selection = selection;
+    view->pointer_array_capacity = view->num_rows;
+
+    view->source = source;
+    source->refcount++;
+
+    return view;
+}
+
+// saída de um lote de table_transform_batch
+struct table_batch_output
+{
+    size_t first;
+    size_t end;
+    char **cells;          // novo valor de cada linha do lote (NULL: a célula não muda)
+    struct table *scratch; // dona da arena com os novos valores do lote
+    bool error;
+};
+
+int table_batch_set(struct table_batch_output *out, size_t row, const char *value, size_t len)
+{
+    if (row < out->first || row >= out->end)
+        return -1;
+
+    char *copy = arena_strndup(out->scratch, value, len);
+    if (!copy)
+    {
+        out->error = true;
+        return -1;
+    }
+
+    out->cells[row - out->first] = copy;
+    return 0;
+}
+
+void table_batch_fail(struct table_batch_output *out)
+{
+    out->error = true;
+}
+
+// estado partilhado pelas tarefas de table_transform_batch
+struct transform_batch_job
+{
+    const struct table *table;
+    size_t col;
+    table_batch_transform kernel;
+    const void *context;
+    struct table_batch_output *outputs; // uma saída por lote
+};
+
+static void transform_batch_task(void *arg, size_t index)
+{
+    struct transform_batch_job *job = (struct transform_batch_job *)arg;
+    struct table_batch_output *out = &job->outputs[index];
+
+    out->first = index * TABLE_BATCH_ROWS;
+    out->end = out->first + TABLE_BATCH_ROWS;
+    if (out->end > job->table->num_rows)
+        out->end = job->table->num_rows;
+    out->error = false;
+    out->scratch = table_create(0);
+    out->cells = calloc(out->end - out->first, sizeof(char *));
+    if (!out->scratch || !out->cells)
+    {
+        out->error = true;
+        return;
+    }
+
+    job->kernel(job->table, job->col, out->first, out->end, out, job->context);
+}
+
+// função para alterar a coluna col com um kernel de transformação em lote, com num_threads threads
+int table_transform_batch(struct table *table, size_t col, table_batch_transform kernel,
+                          const void *context, int num_threads)
+{
+    // as células mudam na tabela base: só se mais ninguém a estiver a usar
+    struct table *base = table->source ? table->source : table;
+    if (col >= table->num_cols || base->refcount > 1 || table_flush_deletes(table) != 0 ||
+        table_materialize_columns(table, ALL_COLUMNS) != 0)
+        return -1;
+
+    size_t batches = num_batches(table);
+    struct table_batch_output *outputs = calloc(batches ? batches : 1, sizeof(struct table_batch_output));
+    if (!outputs)
+        return -1;
+
+    struct transform_batch_job job;
+    job.table = table;
+    job.col = col;
+    job.kernel = kernel;
+    job.context = context;
+    job.outputs = outputs;
+
+    thread_pool_run(num_threads, transform_batch_task, &job, batches);
+
+    int result = 0;
+    for (size_t k = 0; k < batches; k++)
+        result = outputs[k].error ? -1 : result;
+
+    // aplicar os novos valores (só se todos os lotes correram bem: a tabela muda toda ou nada)
+    bool changed = false;
+    for (size_t k = 0; k < batches; k++)
+    {
+        struct table_batch_output *out = &outputs[k];
+        if (result == 0)
+        {
+            for (size_t i = out->first; i < out->end; i++)
+            {
+                char *value = out->cells[i - out->first];
+                if (value)
+                {
+                    base->cells[table_physical_row(table, i) * base->num_cols + col] = value;
+                    changed = true;
+                }
+            }
+
+            // as strings novas passam para a arena da tabela
+            if (out->scratch)
+                arena_attach(base, arena_detach(out->scratch));
+        }
+
+        free(out->cells);
+        table_free(out->scratch);
+    }
+    free(outputs);
+
+    // os índices, tipos e dicionário da coluna deixam de corresponder às células
+    if (changed)
+        table_reset_column(base, col);
+
+    return result;
+}
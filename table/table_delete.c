@@ -0,0 +1,249 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "table.h"
+#include "table_internal.h"
+
+// Eliminação de linhas com marcas (tombstones)
+//
+// eliminar uma linha só a marca num mapa de bits: as linhas seguintes não mudam de sítio
+// as posições da tabela (linhas da matriz, ou entradas da seleção numa vista) ficam iguais até
+// a tabela ser compactada, o que acontece numa só passagem antes da próxima operação que
+// percorra a tabela (filtros, índices, save, ...) ou com table_compact
+// entretanto, a linha i é a i-ésima posição não marcada, encontrada com uma árvore de Fenwick
+// que conta as linhas vivas (O(log n) por acesso e por eliminação)
+
+// função auxiliar para recalcular a árvore de Fenwick a partir do mapa de bits, em O(n)
+static void tombstones_rebuild(struct tombstones *ts)
+{
+    size_t n = ts->num_slots;
+
+    for (size_t i = 1; i <= n; i++)
+        ts->tree[i] = !(ts->bits[(i - 1) / 64] >> ((i - 1) % 64) & 1);
+
+    for (size_t i = 1; i <= n; i++)
+    {
+        size_t parent = i + (i & -i);
+        if (parent <= n)
+            ts->tree[parent] += ts->tree[i];
+    }
+}
+
+// função auxiliar para começar a marcar linhas eliminadas numa tabela sem marcas
+static int tombstones_create(struct table *table)
+{
+    if (table->num_rows >= UINT32_MAX)
+        return -1;
+
+    struct tombstones *ts = malloc(sizeof(struct tombstones));
+    if (!ts)
+        return -1;
+
+    ts->num_slots = table->num_rows;
+    ts->bits = calloc((ts->num_slots + 63) / 64 + 1, sizeof(uint64_t));
+    ts->tree = malloc((ts->num_slots + 1) * sizeof(uint32_t));
+    if (!ts->bits || !ts->tree)
+    {
+        free(ts->bits);
+        free(ts->tree);
+        free(ts);
+        return -1;
+    }
+
+    // todas as linhas estão vivas: cada nó conta as (i & -i) posições que cobre
+    for (size_t i = 1; i <= ts->num_slots; i++)
+        ts->tree[i] = (uint32_t)(i & -i);
+
+    table->deleted = ts;
+    return 0;
+}
+
+static void tombstones_free(struct tombstones *ts)
+{
+    if (!ts)
+        return;
+
+    free(ts->bits);
+    free(ts->tree);
+    free(ts);
+}
+
+// função auxiliar para marcar uma posição (ainda viva) como eliminada
+static void tombstones_mark(struct tombstones *ts, size_t slot)
+{
+    ts->bits[slot / 64] |= (uint64_t)1 << (slot % 64);
+    for (size_t i = slot + 1; i <= ts->num_slots; i += i & -i)
+        ts->tree[i]--;
+}
+
+// função auxiliar para encontrar a posição da linha row_index (a row_index-ésima posição viva)
+// desce pela árvore de Fenwick, do maior salto para o menor
+size_t tombstones_select(const struct tombstones *ts, size_t row_index)
+{
+    size_t pos = 0;
+    size_t remaining = row_index + 1;
+    size_t step = 1;
+    while (step * 2 <= ts->num_slots)
+        step *= 2;
+
+    for (; step > 0; step /= 2)
+    {
+        if (pos + step <= ts->num_slots && ts->tree[pos + step] < remaining)
+        {
+            pos += step;
+            remaining -= ts->tree[pos];
+        }
+    }
+
+    return pos;
+}
+
+// função para eliminar uma linha da tabela
+int table_delete_row(struct table *table, size_t row_index)
+{
+    if (!table || row_index >= table->num_rows)
+        return -1;
+
+    // Não podemos mudar as linhas de uma tabela usada por vistas (as vistas apontam para elas)
+    // Numa vista a linha só sai da vista (a tabela de origem não muda)
+    if (!table->source && table->refcount > 1)
+        return -1;
+
+    if (!table->deleted && tombstones_create(table) != 0)
+        return -1;
+
+    // As strings da linha ficam na arena até a tabela ser libertada
+    tombstones_mark(table->deleted, tombstones_select(table->deleted, row_index));
+    table->num_rows--;
+
+    return 0;
+}
+
+// função para eliminar count linhas seguidas a partir de first
+long table_delete_range(struct table *table, size_t first, size_t count)
+{
+    if (!table || first > table->num_rows)
+        return -1;
+    if (count > table->num_rows - first)
+        count = table->num_rows - first;
+    if (count == 0)
+        return 0;
+
+    if (!table->source && table->refcount > 1)
+        return -1;
+
+    if (!table->deleted && tombstones_create(table) != 0)
+        return -1;
+
+    // as posições vivas do intervalo são consecutivas, a menos das que já estavam marcadas
+    struct tombstones *ts = table->deleted;
+    size_t slot = tombstones_select(ts, first);
+    for (size_t marked = 0; marked < count; slot++)
+    {
+        if (!(ts->bits[slot / 64] >> (slot % 64) & 1))
+        {
+            ts->bits[slot / 64] |= (uint64_t)1 << (slot % 64);
+            marked++;
+        }
+    }
+
+    tombstones_rebuild(ts);
+    table->num_rows -= count;
+
+    return (long)count;
+}
+
+// função para eliminar as linhas que satisfazem o predicado, numa só passagem
+long table_delete_where(struct table *table,
+                        bool (*predicate)(const void *row, const void *context),
+                        const void *context)
+{
+    if (!table)
+        return -1;
+
+    if (!table->source && table->refcount > 1)
+        return -1;
+
+    // o predicado pode ler qualquer coluna
+    if (table_materialize_columns(table, ALL_COLUMNS) != 0 || (!table->deleted && tombstones_create(table) != 0))
+        return -1;
+
+    struct tombstones *ts = table->deleted;
+    const struct table *base = table->source ? table->source : table;
+    long count = 0;
+
+    for (size_t slot = 0; slot < ts->num_slots; slot++)
+    {
+        uint64_t bit = (uint64_t)1 << (slot % 64);
+        if (ts->bits[slot / 64] & bit)
+            continue;
+
+        size_t row = table->source ? table->selection[slot] : slot;
+        if (predicate((const void *)(base->cells + row * base->num_cols), context))
+        {
+            ts->bits[slot / 64] |= bit;
+            count++;
+        }
+    }
+
+    tombstones_rebuild(ts);
+    table->num_rows -= count;
+
+    return count;
+}
+
+// função para compactar a tabela: as posições marcadas são removidas numa só passagem
+int table_compact(struct table *table)
+{
+    struct tombstones *ts = table->deleted;
+    if (!ts)
+        return 0;
+
+    // os índices são atualizados primeiro: é o único passo que pode falhar (e não muda nada)
+    if (table_index_compact(table) != 0)
+        return -1;
+
+    if (!table->source)
+        table_types_compact(table);
+
+    size_t w = 0;
+    for (size_t slot = 0; slot < ts->num_slots; slot++)
+    {
+        if (ts->bits[slot / 64] >> (slot % 64) & 1)
+            continue;
+
+        if (w != slot)
+        {
+            if (table->source)
+                table->selection[w] = table->selection[slot];
+            else
+                memcpy(table->cells + w * table->num_cols, table->cells + slot * table->num_cols,
+                       table->num_cols * sizeof(char *));
+        }
+        w++;
+    }
+
+    tombstones_free(ts);
+    table->deleted = NULL;
+
+    return 0;
+}
+
+// função auxiliar para compactar a tabela antes de uma operação que percorre as posições
+// a compactação não muda o conteúdo da tabela (só onde as linhas estão), por isso também
+// é feita em tabelas recebidas como const
+int table_flush_deletes(const struct table *table)
+{
+    if (!table->deleted)
+        return 0;
+
+    return table_compact((struct table *)table);
+}
+
+// função auxiliar para libertar as marcas de uma tabela (table_free)
+void table_free_deletes(struct table *table)
+{
+    tombstones_free(table->deleted);
+    table->deleted = NULL;
+}
@@ -0,0 +1,691 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "table.h"
+#include "table_internal.h"
+
+// Expressões booleanas (table_expr_parse / table_filter_expr)
+//
+// a expressão é compilada uma vez numa árvore: as folhas são comparações <coluna> <op> <valor>
+// e os nós and/or têm todos os operandos seguidos (a and b and c é um só nó com três filhos),
+// para que o planeamento possa reordená-los livremente
+// table_filter_expr liga as folhas à tabela (valores já convertidos das colunas numéricas,
+// códigos das colunas com dicionário), estima a seletividade de cada folha numa amostra das
+// linhas e ordena os filhos de cada and/or pelo custo esperado até à primeira resposta; a
+// tabela é depois percorrida uma só vez, com curto-circuito
+
+enum expr_kind
+{
+    EXPR_COMPARE,
+    EXPR_AND,
+    EXPR_OR,
+    EXPR_NOT
+};
+
+enum expr_op
+{
+    OP_EQ,
+    OP_NE,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE
+};
+
+struct table_expr
+{
+    enum expr_kind kind;
+
+    // comparação
+    size_t col;
+    enum expr_op op;
+    char *value;
+    bool numeric; // comparação numérica (op de ordem e valor numérico)
+    double number;
+
+    // ligação à tabela durante table_filter_expr (NULL/0 fora dela)
+    char **cells;                   // matriz da tabela base
+    size_t num_cols;
+    const struct column_info *info; // coluna numérica: valores já convertidos
+    const uint32_t *codes;          // coluna com dicionário: código de cada linha
+    uint32_t code;                  // código de value (DICT_NO_CODE se não estiver no dicionário)
+
+    // and, or, not
+    struct table_expr **children;
+    size_t num_children;
+
+    // planeamento
+    double selectivity; // fração estimada das linhas em que a expressão é verdadeira
+    double cost;        // custo estimado de avaliar a expressão numa linha
+    double rank;        // ordem do filho no and/or do pai (menor primeiro)
+};
+
+// função auxiliar para avaliar uma comparação numa linha
+static bool compare_matches(const struct table_expr *e, char **row)
+{
+    if (e->codes)
+    {
+        uint32_t code = e->codes[(row - e->cells) / e->num_cols];
+        if (code == DICT_NO_CODE)
+            return false;
+        return (code == e->code) == (e->op == OP_EQ);
+    }
+
+    const char *cell = row[e->col];
+    int cmp;
+    if (e->numeric)
+    {
+        double value;
+        if (e->info)
+        {
+            if (!column_number(e->info, (row - e->cells) / e->num_cols, &value))
+                return false;
+        }
+        else if (!cell || !parse_number(cell, &value))
+            return false;
+        cmp = (value > e->number) - (value < e->number);
+    }
+    else
+    {
+        if (!cell)
+            return false;
+        cmp = strcmp(cell, e->value);
+    }
+
+    switch (e->op)
+    {
+    case OP_EQ:
+        return cmp == 0;
+    case OP_NE:
+        return cmp != 0;
+    case OP_LT:
+        return cmp < 0;
+    case OP_LE:
+        return cmp <= 0;
+    case OP_GT:
+        return cmp > 0;
+    default:
+        return cmp >= 0;
+    }
+}
+
+// função auxiliar para avaliar a expressão numa linha, com curto-circuito
+static bool expr_eval(const struct table_expr *e, char **row)
+{
+    switch (e->kind)
+    {
+    case EXPR_COMPARE:
+        return compare_matches(e, row);
+    case EXPR_NOT:
+        return !expr_eval(e->children[0], row);
+    case EXPR_AND:
+        for (size_t i = 0; i < e->num_children; i++)
+        {
+            if (!expr_eval(e->children[i], row))
+                return false;
+        }
+        return true;
+    default:
+        for (size_t i = 0; i < e->num_children; i++)
+        {
+            if (expr_eval(e->children[i], row))
+                return true;
+        }
+        return false;
+    }
+}
+
+bool table_expr_match(const void *row, const void *expr)
+{
+    return expr_eval((const struct table_expr *)expr, (char **)row);
+}
+
+void table_expr_free(struct table_expr *expr)
+{
+    if (!expr)
+        return;
+
+    for (size_t i = 0; i < expr->num_children; i++)
+        table_expr_free(expr->children[i]);
+    free(expr->children);
+    free(expr->value);
+    free(expr);
+}
+
+// Compilação
+
+enum token_kind
+{
+    TOKEN_END,
+    TOKEN_LPAREN,
+    TOKEN_RPAREN,
+    TOKEN_OP,
+    TOKEN_WORD,
+    TOKEN_ERROR
+};
+
+struct expr_parser
+{
+    const char *pos;
+    size_t num_cols;
+    char *error;
+    size_t error_size;
+
+    // token atual (start/len apontam para o texto; um valor entre aspas ainda tem as aspas)
+    enum token_kind kind;
+    const char *start;
+    size_t len;
+    bool quoted;
+};
+
+// função auxiliar para guardar a primeira mensagem de erro (len 0: fim da expressão)
+static void parse_error(struct expr_parser *p, const char *message, const char *token, size_t len)
+{
+    if (p->error_size == 0 || p->error[0] != '\0')
+        return;
+
+    if (len == 0)
+        snprintf(p->error, p->error_size, "%s end of expression", message);
+    else
+        snprintf(p->error, p->error_size, "%s '%.*s'", message, (int)len, token);
+}
+
+static bool is_op_char(char c)
+{
+    return c == '=' || c == '!' || c == '<' || c == '>';
+}
+
+// função auxiliar para ler o próximo token
+static void next_token(struct expr_parser *p)
+{
+    while (*p->pos == ' ' || *p->pos == '\t' || *p->pos == '\n' || *p->pos == '\r')
+        p->pos++;
+
+    p->start = p->pos;
+    p->quoted = false;
+
+    char c = *p->pos;
+    if (c == '\0')
+        p->kind = TOKEN_END;
+    else if (c == '(' || c == ')')
+    {
+        p->kind = c == '(' ? TOKEN_LPAREN : TOKEN_RPAREN;
+        p->pos++;
+    }
+    else if (is_op_char(c))
+    {
+        p->kind = TOKEN_OP;
+        p->pos += (p->pos[1] == '=') ? 2 : 1;
+    }
+    else if (c == '"')
+    {
+        // valor entre aspas: "" dentro das aspas é uma aspa
+        p->kind = TOKEN_WORD;
+        p->quoted = true;
+        p->pos++;
+        while (*p->pos && !(p->pos[0] == '"' && p->pos[1] != '"'))
+            p->pos += (p->pos[0] == '"') ? 2 : 1;
+        if (*p->pos != '"')
+        {
+            p->kind = TOKEN_ERROR;
+            parse_error(p, "missing closing quote in", p->start, strlen(p->start));
+        }
+        else
+            p->pos++;
+    }
+    else
+    {
+        p->kind = TOKEN_WORD;
+        while (*p->pos && *p->pos != ' ' && *p->pos != '\t' && *p->pos != '\n' && *p->pos != '\r' &&
+               *p->pos != '(' && *p->pos != ')' && *p->pos != '"' && !is_op_char(*p->pos))
+            p->pos++;
+    }
+
+    p->len = p->pos - p->start;
+}
+
+// função auxiliar para testar se o token atual é a palavra-chave keyword (sem distinguir maiúsculas)
+static bool token_is(const struct expr_parser *p, const char *keyword)
+{
+    return p->kind == TOKEN_WORD && !p->quoted && p->len == strlen(keyword) &&
+           strncasecmp(p->start, keyword, p->len) == 0;
+}
+
+// função auxiliar para copiar o token atual (sem as aspas)
+static char *token_value(const struct expr_parser *p)
+{
+    if (!p->quoted)
+        return strndup(p->start, p->len);
+
+    char *value = malloc(p->len);
+    if (!value)
+        return NULL;
+
+    size_t n = 0;
+    for (size_t i = 1; i + 1 < p->len; i++)
+    {
+        value[n++] = p->start[i];
+        if (p->start[i] == '"')
+            i++;
+    }
+    value[n] = '\0';
+    return value;
+}
+
+static struct table_expr *new_node(enum expr_kind kind)
+{
+    struct table_expr *e = calloc(1, sizeof(struct table_expr));
+    if (e)
+        e->kind = kind;
+    return e;
+}
+
+// função auxiliar para acrescentar um filho a um nó and/or/not (retorna 0 em sucesso, -1 em erro)
+static int add_child(struct table_expr *e, struct table_expr *child)
+{
+    struct table_expr **children = realloc(e->children, (e->num_children + 1) * sizeof(struct table_expr *));
+    if (!children)
+        return -1;
+
+    e->children = children;
+    e->children[e->num_children++] = child;
+    return 0;
+}
+
+// função auxiliar para ler um operador (len caracteres); devolve falso se não for válido
+static bool parse_op(const char *s, size_t len, enum expr_op *op)
+{
+    if ((len == 1 && s[0] == '=') || (len == 2 && strncmp(s, "==", 2) == 0))
+        *op = OP_EQ;
+    else if (len == 2 && strncmp(s, "!=", 2) == 0)
+        *op = OP_NE;
+    else if (len == 1 && s[0] == '<')
+        *op = OP_LT;
+    else if (len == 2 && strncmp(s, "<=", 2) == 0)
+        *op = OP_LE;
+    else if (len == 1 && s[0] == '>')
+        *op = OP_GT;
+    else if (len == 2 && strncmp(s, ">=", 2) == 0)
+        *op = OP_GE;
+    else
+        return false;
+    return true;
+}
+
+// função auxiliar para criar uma comparação (fica com value, que tem de ter sido alocado)
+static struct table_expr *new_compare(size_t col, enum expr_op op, char *value)
+{
+    struct table_expr *e = new_node(EXPR_COMPARE);
+    if (!e)
+        return NULL;
+
+    e->col = col;
+    e->op = op;
+    e->value = value;
+    e->numeric = op != OP_EQ && op != OP_NE && parse_number(value, &e->number);
+    return e;
+}
+
+struct table_expr *table_expr_compare(size_t col, const char *op, const char *value)
+{
+    enum expr_op parsed;
+    if (!parse_op(op, strlen(op), &parsed))
+        return NULL;
+
+    char *copy = strdup(value);
+    struct table_expr *e = copy ? new_compare(col, parsed, copy) : NULL;
+    if (!e)
+        free(copy);
+    return e;
+}
+
+// função para juntar duas expressões com and (os operandos de and seguidos ficam num só nó)
+struct table_expr *table_expr_and(struct table_expr *a, struct table_expr *b)
+{
+    struct table_expr *e = a->kind == EXPR_AND ? a : new_node(EXPR_AND);
+    if (!e)
+        return NULL;
+
+    // os filhos novos são acrescentados de uma vez, para que um erro não altere a nem b
+    size_t extra = (e == a ? 0 : 1) + (b->kind == EXPR_AND ? b->num_children : 1);
+    struct table_expr **children = realloc(e->children, (e->num_children + extra) * sizeof(struct table_expr *));
+    if (!children)
+    {
+        if (e != a)
+            free(e);
+        return NULL;
+    }
+    e->children = children;
+
+    if (e != a)
+        e->children[e->num_children++] = a;
+    if (b->kind == EXPR_AND)
+    {
+        memcpy(e->children + e->num_children, b->children, b->num_children * sizeof(struct table_expr *));
+        e->num_children += b->num_children;
+        free(b->children);
+        free(b);
+    }
+    else
+        e->children[e->num_children++] = b;
+
+    return e;
+}
+
+static struct table_expr *parse_or(struct expr_parser *p);
+
+// comparação: <coluna> <op> <valor>
+static struct table_expr *parse_compare(struct expr_parser *p)
+{
+    if (p->kind != TOKEN_WORD || p->quoted)
+    {
+        parse_error(p, "expected a column, found", p->start, p->len);
+        return NULL;
+    }
+
+    char letter = p->start[0];
+    size_t col = (letter >= 'a' && letter <= 'z') ? (size_t)(letter - 'a') : (size_t)(letter - 'A');
+    if (p->len != 1 || !((letter >= 'a' && letter <= 'z') || (letter >= 'A' && letter <= 'Z')) || col >= p->num_cols)
+    {
+        parse_error(p, "invalid column", p->start, p->len);
+        return NULL;
+    }
+
+    next_token(p);
+    enum expr_op op;
+    if (p->kind != TOKEN_OP)
+    {
+        parse_error(p, "expected an operator, found", p->start, p->len);
+        return NULL;
+    }
+    if (!parse_op(p->start, p->len, &op))
+    {
+        parse_error(p, "invalid operator", p->start, p->len);
+        return NULL;
+    }
+
+    next_token(p);
+    if (p->kind != TOKEN_WORD)
+    {
+        parse_error(p, "expected a value, found", p->start, p->len);
+        return NULL;
+    }
+
+    char *value = token_value(p);
+    struct table_expr *e = value ? new_compare(col, op, value) : NULL;
+    if (!e)
+    {
+        free(value);
+        parse_error(p, "out of memory at", p->start, p->len);
+        return NULL;
+    }
+
+    next_token(p);
+    return e;
+}
+
+// operando: not <operando> | ( <expressão> ) | <comparação>
+static struct table_expr *parse_unary(struct expr_parser *p)
+{
+    if (token_is(p, "not"))
+    {
+        next_token(p);
+        struct table_expr *child = parse_unary(p);
+        struct table_expr *e = child ? new_node(EXPR_NOT) : NULL;
+        if (!e || add_child(e, child) != 0)
+        {
+            table_expr_free(child);
+            free(e);
+            return NULL;
+        }
+        return e;
+    }
+
+    if (p->kind == TOKEN_LPAREN)
+    {
+        next_token(p);
+        struct table_expr *e = parse_or(p);
+        if (e && p->kind != TOKEN_RPAREN)
+        {
+            parse_error(p, "expected ')', found", p->start, p->len);
+            table_expr_free(e);
+            return NULL;
+        }
+        next_token(p);
+        return e;
+    }
+
+    return parse_compare(p);
+}
+
+// função auxiliar para ler uma sequência de operandos ligados por keyword (and ou or)
+// os operandos ficam todos no mesmo nó; um só operando é devolvido tal como está
+static struct table_expr *parse_chain(struct expr_parser *p, const char *keyword, enum expr_kind kind,
+                                      struct table_expr *(*parse_operand)(struct expr_parser *))
+{
+    struct table_expr *first = parse_operand(p);
+    if (!first || !token_is(p, keyword))
+        return first;
+
+    struct table_expr *e = new_node(kind);
+    if (!e || add_child(e, first) != 0)
+    {
+        table_expr_free(first);
+        free(e);
+        return NULL;
+    }
+
+    while (token_is(p, keyword))
+    {
+        next_token(p);
+        struct table_expr *child = parse_operand(p);
+        if (!child || add_child(e, child) != 0)
+        {
+            table_expr_free(child);
+            table_expr_free(e);
+            return NULL;
+        }
+    }
+
+    return e;
+}
+
+static struct table_expr *parse_and(struct expr_parser *p)
+{
+    return parse_chain(p, "and", EXPR_AND, parse_unary);
+}
+
+static struct table_expr *parse_or(struct expr_parser *p)
+{
+    return parse_chain(p, "or", EXPR_OR, parse_and);
+}
+
+struct table_expr *table_expr_parse(const char *text, size_t num_cols, char *error, size_t error_size)
+{
+    struct expr_parser p;
+    p.pos = text;
+    p.num_cols = num_cols;
+    p.error = error;
+    p.error_size = error_size;
+    if (error_size > 0)
+        error[0] = '\0';
+
+    next_token(&p);
+    struct table_expr *e = parse_or(&p);
+    if (e && p.kind != TOKEN_END)
+    {
+        parse_error(&p, "unexpected", p.start, p.len);
+        table_expr_free(e);
+        return NULL;
+    }
+
+    if (!e && error_size > 0 && error[0] == '\0')
+        snprintf(error, error_size, "out of memory");
+    return e;
+}
+
+// Planeamento
+
+// função auxiliar para ligar as comparações à tabela (ou desligá-las, com table NULL)
+static void expr_bind(struct table_expr *e, const struct table *table)
+{
+    for (size_t i = 0; i < e->num_children; i++)
+        expr_bind(e->children[i], table);
+    if (e->kind != EXPR_COMPARE)
+        return;
+
+    e->cells = NULL;
+    e->num_cols = 0;
+    e->info = NULL;
+    e->codes = NULL;
+    if (!table)
+        return;
+
+    const struct table *base = table->source ? table->source : table;
+    e->cells = base->cells;
+    e->num_cols = base->num_cols;
+    if (!base->columns)
+        return;
+
+    const struct column_info *info = &base->columns[e->col];
+    if (e->numeric && info->type != COLUMN_STRING)
+        e->info = info;
+    else if ((e->op == OP_EQ || e->op == OP_NE) && info->codes)
+    {
+        e->codes = info->codes;
+        e->code = dict_lookup(info, e->value);
+    }
+}
+
+static int compare_rank(const void *a, const void *b)
+{
+    double x = (*(struct table_expr *const *)a)->rank;
+    double y = (*(struct table_expr *const *)b)->rank;
+    return (x > y) - (x < y);
+}
+
+// função auxiliar para estimar a seletividade e o custo de cada nó nas linhas de sample e
+// ordenar os filhos de cada and/or
+// and: primeiro os filhos com menor custo / (1 - seletividade), que mais depressa dão falso
+// or: primeiro os filhos com menor custo / seletividade, que mais depressa dão verdadeiro
+static void expr_plan(struct table_expr *e, char ***sample, size_t num_samples)
+{
+    if (e->kind == EXPR_COMPARE)
+    {
+        size_t matches = 0;
+        for (size_t k = 0; k < num_samples; k++)
+            matches += compare_matches(e, sample[k]);
+
+        // estimativa com suavização (nunca 0 nem 1, mesmo com poucas linhas)
+        e->selectivity = (matches + 1.0) / (num_samples + 2.0);
+        e->cost = (e->codes || e->info) ? 0.5 : e->numeric ? 2.0 : 1.0;
+        return;
+    }
+
+    for (size_t i = 0; i < e->num_children; i++)
+        expr_plan(e->children[i], sample, num_samples);
+
+    if (e->kind == EXPR_NOT)
+    {
+        e->selectivity = 1.0 - e->children[0]->selectivity;
+        e->cost = e->children[0]->cost;
+        return;
+    }
+
+    bool is_and = e->kind == EXPR_AND;
+    for (size_t i = 0; i < e->num_children; i++)
+    {
+        struct table_expr *c = e->children[i];
+        c->rank = c->cost / (is_and ? 1.0 - c->selectivity : c->selectivity);
+    }
+    qsort(e->children, e->num_children, sizeof(struct table_expr *), compare_rank);
+
+    // custo esperado: cada filho só é avaliado se os anteriores não tiverem decidido
+    double reach = 1.0;
+    e->cost = 0.0;
+    for (size_t i = 0; i < e->num_children; i++)
+    {
+        struct table_expr *c = e->children[i];
+        e->cost += reach * c->cost;
+        reach *= is_and ? c->selectivity : 1.0 - c->selectivity;
+    }
+    e->selectivity = is_and ? reach : 1.0 - reach;
+}
+
+// função auxiliar para obter as colunas lidas pela expressão (máscara de bits)
+static uint32_t expr_columns(const struct table_expr *e)
+{
+    uint32_t cols = e->kind == EXPR_COMPARE && e->col < MAX_COLS ? 1u << e->col : 0;
+    for (size_t i = 0; i < e->num_children; i++)
+        cols |= expr_columns(e->children[i]);
+    return cols;
+}
+
+// função auxiliar para ligar a expressão à tabela e ordenar os operandos pela seletividade
+// estimada numa amostra de linhas espalhadas pela tabela (retorna 0 em sucesso, -1 em erro)
+static int expr_prepare(struct table_expr *expr, const struct table *table)
+{
+    // as células e os arrays das colunas têm de estar compactados antes da ligação, e as
+    // colunas da expressão copiadas do ficheiro mapeado
+    if (table_flush_deletes(table) != 0 || table_materialize_columns(table, expr_columns(expr)) != 0)
+        return -1;
+
+    expr_bind(expr, table);
+
+    size_t num_samples = table->num_rows < EXPR_SAMPLE_ROWS ? table->num_rows : EXPR_SAMPLE_ROWS;
+    char ***sample = malloc((num_samples ? num_samples : 1) * sizeof(char **));
+    if (sample)
+    {
+        for (size_t k = 0; k < num_samples; k++)
+            sample[k] = table_row(table, k * table->num_rows / num_samples);
+        expr_plan(expr, sample, num_samples);
+        free(sample);
+    }
+
+    return 0;
+}
+
+// função para filtrar a tabela pela expressão numa só passagem (ver table_expr_parse)
+struct table *table_filter_expr(const struct table *table, struct table_expr *expr, int num_threads)
+{
+    if (expr_prepare(expr, table) != 0)
+        return NULL;
+
+    struct table *view = table_filter_columns(table, table_expr_match, expr, num_threads, expr_columns(expr));
+
+    expr_bind(expr, NULL);
+    return view;
+}
+
+// função para obter as primeiras max_rows linhas que satisfazem a expressão
+// a passagem pela tabela pára assim que as encontra
+struct table *table_filter_expr_first(const struct table *table, struct table_expr *expr, size_t max_rows)
+{
+    if (expr_prepare(expr, table) != 0 || table->num_rows > UINT32_MAX)
+        return NULL;
+
+    if (max_rows > table->num_rows)
+        max_rows = table->num_rows;
+    uint32_t *rows = malloc((max_rows ? max_rows : 1) * sizeof(uint32_t));
+    if (!rows)
+    {
+        expr_bind(expr, NULL);
+        return NULL;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < table->num_rows && count < max_rows; i++)
+    {
+        if (expr_eval(expr, table_row(table, i)))
+            rows[count++] = (uint32_t)i;
+    }
+
+    struct table *view = table_create_view(table, rows, count);
+    free(rows);
+
+    expr_bind(expr, NULL);
+    return view;
+}
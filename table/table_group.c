@@ -0,0 +1,537 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "table.h"
+#include "table_internal.h"
+#include "thread_pool.h"
+
+// Agregação por grupos (table_group_by)
+//
+// as linhas são divididas em partes contíguas, uma por tarefa do pool de threads; cada tarefa
+// junta as suas linhas numa tabela de grupos própria (tabela de dispersão com endereçamento
+// aberto, como o índice hash), sem partilhar nada com as outras
+// no fim, as tabelas parciais são juntadas pela ordem das partes, por isso os grupos ficam pela
+// ordem da primeira linha de cada um
+// as chaves não são copiadas durante a agregação: cada grupo guarda uma linha da tabela que o
+// representa; as colunas com dicionário comparam códigos em vez de strings
+
+// Estado de uma agregação num grupo
+struct group_agg
+{
+    size_t count; // count: células não vazias; outras: células com número
+    double sum;
+    double min;
+    double max;
+};
+
+// Tabela de grupos de uma parte das linhas
+struct group_table
+{
+    uint32_t *slots;         // grupo + 1 de cada posição (0 = posição livre)
+    size_t num_slots;        // potência de 2
+    uint64_t *hashes;        // hash da chave de cada grupo
+    uint32_t *rows;          // linha que representa cada grupo
+    struct group_agg *aggs;  // num_aggs estados por grupo
+    size_t num_groups;
+    size_t groups_capacity;
+    bool error;
+};
+
+// Coluna de chave: códigos do dicionário (se a coluna tiver) ou as células
+struct group_key
+{
+    size_t col;
+    const uint32_t *codes;
+};
+
+// Coluna agregada já resolvida
+struct group_column
+{
+    enum table_agg_op op;
+    size_t col;
+    const struct column_info *info; // coluna com tipo numérico inferido (ou NULL)
+};
+
+struct group_job
+{
+    const struct table *table;
+    struct group_key *keys;
+    size_t num_keys;
+    struct group_column *aggs;
+    size_t num_aggs;
+    size_t first;     // primeira linha agregada (1 se a tabela tem cabeçalho)
+    size_t num_parts;
+    struct group_table *parts;
+};
+
+// função auxiliar para baralhar os bits do hash (os bits baixos escolhem a posição)
+static uint64_t mix_hash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// função auxiliar para calcular o hash da chave da linha row (FNV-1a sobre as colunas de chave)
+static uint64_t key_hash(const struct group_job *job, size_t row)
+{
+    char **cells = table_row(job->table, row);
+    uint64_t h = 14695981039346656037ULL;
+
+    for (size_t k = 0; k < job->num_keys; k++)
+    {
+        const struct group_key *key = &job->keys[k];
+        if (key->codes)
+        {
+            h ^= key->codes[table_physical_row(job->table, row)];
+            h *= 1099511628211ULL;
+        }
+        else if (cells[key->col])
+        {
+            for (const char *s = cells[key->col]; *s; s++)
+            {
+                h ^= (unsigned char)*s;
+                h *= 1099511628211ULL;
+            }
+        }
+
+        // separador entre colunas (para "ab","c" e "a","bc" terem hashes diferentes)
+        h ^= 0xff;
+        h *= 1099511628211ULL;
+    }
+
+    return mix_hash(h);
+}
+
+// função auxiliar para testar se as linhas a e b têm a mesma chave
+static bool same_key(const struct group_job *job, size_t a, size_t b)
+{
+    char **row_a = table_row(job->table, a);
+    char **row_b = table_row(job->table, b);
+
+    for (size_t k = 0; k < job->num_keys; k++)
+    {
+        const struct group_key *key = &job->keys[k];
+        if (key->codes)
+        {
+            if (key->codes[table_physical_row(job->table, a)] != key->codes[table_physical_row(job->table, b)])
+                return false;
+            continue;
+        }
+
+        const char *x = row_a[key->col];
+        const char *y = row_b[key->col];
+        if (x != y && (!x || !y || strcmp(x, y) != 0))
+            return false;
+    }
+
+    return true;
+}
+
+// função auxiliar para procurar a chave da linha row na tabela de grupos
+// devolve a posição do grupo, ou a posição livre onde deve ser inserido
+static size_t find_group_slot(const struct group_job *job, const struct group_table *gt, size_t row, uint64_t h)
+{
+    size_t mask = gt->num_slots - 1;
+    size_t pos = h & mask;
+
+    while (gt->slots[pos])
+    {
+        uint32_t g = gt->slots[pos] - 1;
+        if (gt->hashes[g] == h && same_key(job, gt->rows[g], row))
+            return pos;
+        pos = (pos + 1) & mask;
+    }
+
+    return pos;
+}
+
+// função auxiliar para duplicar a tabela de dispersão (mantemos no máximo 50% de ocupação)
+static int grow_group_slots(struct group_table *gt)
+{
+    size_t new_num_slots = gt->num_slots ? gt->num_slots * 2 : 64;
+    uint32_t *new_slots = calloc(new_num_slots, sizeof(uint32_t));
+    if (!new_slots)
+        return -1;
+
+    free(gt->slots);
+    gt->slots = new_slots;
+    gt->num_slots = new_num_slots;
+
+    // voltar a inserir todos os grupos (as chaves são todas distintas)
+    for (size_t g = 0; g < gt->num_groups; g++)
+    {
+        size_t pos = gt->hashes[g] & (new_num_slots - 1);
+        while (new_slots[pos])
+            pos = (pos + 1) & (new_num_slots - 1);
+        new_slots[pos] = (uint32_t)g + 1;
+    }
+
+    return 0;
+}
+
+// função auxiliar para acrescentar um grupo novo, representado pela linha row, na posição pos
+// devolve o número do grupo (-1 em erro; pos deixa de ser válida se a tabela crescer)
+static long add_group(const struct group_job *job, struct group_table *gt, size_t pos, size_t row, uint64_t h)
+{
+    if (gt->num_groups == gt->groups_capacity)
+    {
+        size_t new_capacity = gt->groups_capacity ? gt->groups_capacity * 2 : 64;
+        uint64_t *hashes = realloc(gt->hashes, new_capacity * sizeof(uint64_t));
+        if (!hashes)
+            return -1;
+        gt->hashes = hashes;
+
+        uint32_t *rows = realloc(gt->rows, new_capacity * sizeof(uint32_t));
+        if (!rows)
+            return -1;
+        gt->rows = rows;
+
+        struct group_agg *aggs = realloc(gt->aggs, new_capacity * (job->num_aggs ? job->num_aggs : 1) * sizeof(struct group_agg));
+        if (!aggs)
+            return -1;
+        gt->aggs = aggs;
+
+        gt->groups_capacity = new_capacity;
+    }
+
+    size_t g = gt->num_groups++;
+    gt->hashes[g] = h;
+    gt->rows[g] = (uint32_t)row;
+    gt->slots[pos] = (uint32_t)g + 1;
+
+    struct group_agg *agg = gt->aggs + g * job->num_aggs;
+    for (size_t a = 0; a < job->num_aggs; a++)
+    {
+        agg[a].count = 0;
+        agg[a].sum = 0;
+        agg[a].min = 0;
+        agg[a].max = 0;
+    }
+
+    if (2 * gt->num_groups > gt->num_slots && grow_group_slots(gt) != 0)
+        return -1;
+
+    return (long)g;
+}
+
+// função auxiliar para procurar o grupo da linha row (e criá-lo, se não existir)
+static long find_group(const struct group_job *job, struct group_table *gt, size_t row)
+{
+    uint64_t h = key_hash(job, row);
+    size_t pos = find_group_slot(job, gt, row, h);
+    if (gt->slots[pos])
+        return gt->slots[pos] - 1;
+    return add_group(job, gt, pos, row, h);
+}
+
+// função auxiliar para obter o valor numérico da célula da linha row (falso se não tiver número)
+static bool agg_number(const struct group_job *job, const struct group_column *c, size_t row, double *value)
+{
+    if (c->info)
+        return column_number(c->info, table_physical_row(job->table, row), value);
+
+    const char *cell = table_row(job->table, row)[c->col];
+    return cell && parse_number(cell, value);
+}
+
+// função auxiliar para juntar a linha row às agregações do grupo
+static void update_aggs(const struct group_job *job, struct group_agg *agg, size_t row)
+{
+    // cada coluna só é convertida uma vez por linha, mesmo com várias agregações
+    // (0: por converter, 1: número, 2: sem número)
+    unsigned char state[MAX_COLS] = {0};
+    double numbers[MAX_COLS];
+
+    for (size_t a = 0; a < job->num_aggs; a++)
+    {
+        const struct group_column *c = &job->aggs[a];
+        if (c->op == AGG_COUNT)
+        {
+            if (c->col == TABLE_AGG_ROWS)
+            {
+                agg[a].count++;
+            }
+            else
+            {
+                const char *cell = table_row(job->table, row)[c->col];
+                agg[a].count += cell && !is_blank(cell);
+            }
+            continue;
+        }
+
+        if (state[c->col] == 0)
+            state[c->col] = agg_number(job, c, row, &numbers[c->col]) ? 1 : 2;
+        if (state[c->col] == 2)
+            continue;
+
+        double value = numbers[c->col];
+        if (agg[a].count == 0 || value < agg[a].min)
+            agg[a].min = value;
+        if (agg[a].count == 0 || value > agg[a].max)
+            agg[a].max = value;
+        agg[a].count++;
+        agg[a].sum += value;
+    }
+}
+
+// tarefa: agregar as linhas de uma parte na sua tabela de grupos
+static void group_part_task(void *arg, size_t index)
+{
+    struct group_job *job = (struct group_job *)arg;
+    struct group_table *gt = &job->parts[index];
+    size_t count = job->table->num_rows - job->first;
+    size_t begin = job->first + index * count / job->num_parts;
+    size_t end = job->first + (index + 1) * count / job->num_parts;
+
+    if (grow_group_slots(gt) != 0)
+    {
+        gt->error = true;
+        return;
+    }
+
+    for (size_t row = begin; row < end; row++)
+    {
+        long g = find_group(job, gt, row);
+        if (g < 0)
+        {
+            gt->error = true;
+            return;
+        }
+        update_aggs(job, gt->aggs + g * job->num_aggs, row);
+    }
+}
+
+// função auxiliar para juntar a tabela de grupos src à tabela dst (retorna 0 em sucesso, -1 em erro)
+static int merge_groups(const struct group_job *job, struct group_table *dst, const struct group_table *src)
+{
+    for (size_t g = 0; g < src->num_groups; g++)
+    {
+        size_t pos = find_group_slot(job, dst, src->rows[g], src->hashes[g]);
+        long d = dst->slots[pos] ? (long)dst->slots[pos] - 1 : add_group(job, dst, pos, src->rows[g], src->hashes[g]);
+        if (d < 0)
+            return -1;
+
+        struct group_agg *to = dst->aggs + d * job->num_aggs;
+        const struct group_agg *from = src->aggs + g * job->num_aggs;
+        for (size_t a = 0; a < job->num_aggs; a++)
+        {
+            if (from[a].count == 0)
+                continue;
+            if (to[a].count == 0 || from[a].min < to[a].min)
+                to[a].min = from[a].min;
+            if (to[a].count == 0 || from[a].max > to[a].max)
+                to[a].max = from[a].max;
+            to[a].count += from[a].count;
+            to[a].sum += from[a].sum;
+        }
+    }
+
+    return 0;
+}
+
+static void free_group_table(struct group_table *gt)
+{
+    free(gt->slots);
+    free(gt->hashes);
+    free(gt->rows);
+    free(gt->aggs);
+}
+
+// função auxiliar para escrever um número numa célula: inteiro, se o for, ou com 15 dígitos
+static void format_number(char *buf, size_t size, double value)
+{
+    if (value > -1e15 && value < 1e15 && value == (double)(int64_t)value)
+        snprintf(buf, size, "%lld", (long long)value);
+    else
+        snprintf(buf, size, "%.15g", value);
+}
+
+// função auxiliar para escrever o resultado de uma agregação (vazio se o grupo não tiver números)
+static void format_agg(char *buf, size_t size, const struct group_column *c, const struct group_agg *agg)
+{
+    buf[0] = '\0';
+    if (c->op == AGG_COUNT)
+        snprintf(buf, size, "%zu", agg->count);
+    else if (agg->count == 0)
+        return;
+    else if (c->op == AGG_SUM)
+        format_number(buf, size, agg->sum);
+    else if (c->op == AGG_MIN)
+        format_number(buf, size, agg->min);
+    else if (c->op == AGG_MAX)
+        format_number(buf, size, agg->max);
+    else
+        format_number(buf, size, agg->sum / agg->count);
+}
+
+// função auxiliar para escrever uma linha da tabela resultado (retorna 0 em sucesso, -1 em erro)
+static int add_result_row(struct table *result, char **values)
+{
+    if (table_reserve_row(result) != 0)
+        return -1;
+
+    char **row = result->cells + result->num_rows * result->num_cols;
+    for (size_t c = 0; c < result->num_cols; c++)
+    {
+        row[c] = NULL;
+        if (values[c] && !(row[c] = arena_strndup(result, values[c], strlen(values[c]))))
+            return -1;
+    }
+
+    result->num_rows++;
+    return 0;
+}
+
+// função auxiliar para criar a tabela resultado: o cabeçalho e uma linha por grupo
+static struct table *build_result(const struct group_job *job, const struct group_table *groups)
+{
+    static const char *op_names[] = {"count", "sum", "min", "max", "avg"};
+    size_t num_cols = job->num_keys + job->num_aggs;
+    struct table *result = table_create(num_cols);
+    if (!result)
+        return NULL;
+
+    char names[MAX_COLS][256];
+    char *values[MAX_COLS];
+
+    // cabeçalho: os nomes das colunas de chave e "op(coluna)" (com os nomes do cabeçalho da
+    // tabela, se tiver, ou as letras das colunas)
+    char **header = job->first ? table_row(job->table, 0) : NULL;
+    for (size_t k = 0; k < job->num_keys; k++)
+    {
+        size_t col = job->keys[k].col;
+        snprintf(names[k], sizeof(names[k]), "%c", (char)('A' + col));
+        values[k] = header && header[col] ? header[col] : names[k];
+    }
+    for (size_t a = 0; a < job->num_aggs; a++)
+    {
+        const struct group_column *c = &job->aggs[a];
+        char *name = names[job->num_keys + a];
+        if (c->col == TABLE_AGG_ROWS)
+            snprintf(name, sizeof(names[0]), "%s(*)", op_names[c->op]);
+        else if (header && header[c->col])
+            snprintf(name, sizeof(names[0]), "%s(%s)", op_names[c->op], header[c->col]);
+        else
+            snprintf(name, sizeof(names[0]), "%s(%c)", op_names[c->op], (char)('A' + c->col));
+        values[job->num_keys + a] = name;
+    }
+    if (add_result_row(result, values) != 0)
+    {
+        table_free(result);
+        return NULL;
+    }
+
+    for (size_t g = 0; g < groups->num_groups; g++)
+    {
+        char **key = table_row(job->table, groups->rows[g]);
+        for (size_t k = 0; k < job->num_keys; k++)
+            values[k] = key[job->keys[k].col];
+
+        const struct group_agg *agg = groups->aggs + g * job->num_aggs;
+        for (size_t a = 0; a < job->num_aggs; a++)
+        {
+            format_agg(names[job->num_keys + a], sizeof(names[0]), &job->aggs[a], &agg[a]);
+            values[job->num_keys + a] = names[job->num_keys + a];
+        }
+
+        if (add_result_row(result, values) != 0)
+        {
+            table_free(result);
+            return NULL;
+        }
+    }
+
+    return result;
+}
+
+// função para agrupar as linhas pelas colunas key_cols e calcular as agregações aggs de cada
+// grupo, com num_threads threads
+struct table *table_group_by(const struct table *table, const size_t *key_cols, size_t num_keys,
+                             const struct table_aggregate *aggs, size_t num_aggs, int num_threads)
+{
+    if (num_keys == 0 || num_keys + num_aggs > MAX_COLS || table->num_rows > UINT32_MAX ||
+        table_flush_deletes(table) != 0)
+        return NULL;
+    for (size_t k = 0; k < num_keys; k++)
+    {
+        if (key_cols[k] >= table->num_cols)
+            return NULL;
+    }
+    for (size_t a = 0; a < num_aggs; a++)
+    {
+        if (aggs[a].op > AGG_AVG || (aggs[a].col >= table->num_cols && !(aggs[a].op == AGG_COUNT && aggs[a].col == TABLE_AGG_ROWS)))
+            return NULL;
+    }
+
+    // só as colunas das chaves e das agregações são lidas
+    uint32_t cols = 0;
+    for (size_t k = 0; k < num_keys; k++)
+        cols |= 1u << key_cols[k];
+    for (size_t a = 0; a < num_aggs; a++)
+    {
+        if (aggs[a].col != TABLE_AGG_ROWS)
+            cols |= 1u << aggs[a].col;
+    }
+    if (table_materialize_columns(table, cols) != 0)
+        return NULL;
+
+    const struct table *base = table->source ? table->source : table;
+    struct group_key keys[MAX_COLS];
+    struct group_column columns[MAX_COLS];
+
+    struct group_job job;
+    memset(&job, 0, sizeof(job));
+    job.table = table;
+    job.keys = keys;
+    job.num_keys = num_keys;
+    job.aggs = columns;
+    job.num_aggs = num_aggs;
+
+    for (size_t k = 0; k < num_keys; k++)
+    {
+        keys[k].col = key_cols[k];
+        keys[k].codes = base->columns ? base->columns[key_cols[k]].codes : NULL;
+    }
+    for (size_t a = 0; a < num_aggs; a++)
+    {
+        columns[a].op = aggs[a].op;
+        columns[a].col = aggs[a].col;
+        const struct column_info *info = base->columns && aggs[a].col != TABLE_AGG_ROWS ? &base->columns[aggs[a].col] : NULL;
+        columns[a].info = info && info->type != COLUMN_STRING ? info : NULL;
+    }
+
+    // o cabeçalho (primeira linha da tabela carregada) não é agregado
+    job.first = table_has_header(table) ? 1 : 0;
+
+    // partes: uma por thread, com pelo menos GROUP_MIN_PART_ROWS linhas
+    size_t count = table->num_rows - job.first;
+    job.num_parts = count / GROUP_MIN_PART_ROWS;
+    if (job.num_parts > (size_t)num_threads)
+        job.num_parts = num_threads;
+    if (job.num_parts == 0)
+        job.num_parts = 1;
+
+    job.parts = calloc(job.num_parts, sizeof(struct group_table));
+    if (!job.parts)
+        return NULL;
+
+    thread_pool_run(num_threads, group_part_task, &job, job.num_parts);
+
+    // juntar as tabelas parciais na primeira, pela ordem das partes
+    bool error = false;
+    for (size_t p = 0; p < job.num_parts; p++)
+        error = error || job.parts[p].error;
+    for (size_t p = 1; p < job.num_parts && !error; p++)
+        error = merge_groups(&job, &job.parts[0], &job.parts[p]) != 0;
+
+    struct table *result = error ? NULL : build_result(&job, &job.parts[0]);
+
+    for (size_t p = 0; p < job.num_parts; p++)
+        free_group_table(&job.parts[p]);
+    free(job.parts);
+    return result;
+}
@@ -0,0 +1,1012 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/mman.h>
+#include "table.h"
+#include "table_internal.h"
+#include "thread_pool.h"
+
+// Índice hash de uma coluna: valor -> lista das linhas com esse valor
+//
+// cada valor distinto é um grupo; as linhas de todos os grupos estão num único array,
+// agrupadas por valor e por ordem crescente dentro de cada grupo:
+//     rows[offsets[g] .. offsets[g + 1]) são as linhas do grupo g
+// a tabela de dispersão (endereçamento aberto) só guarda o número do grupo de cada valor
+// as células NULL (linhas com menos colunas) não entram no índice: nunca são iguais a um valor
+// posição eliminada, na compactação (ver hash_index_remap)
+#define REMAP_DELETED UINT32_MAX
+
+struct hash_index
+{
+    uint32_t *slots;    // grupo + 1 de cada posição (0 = posição livre)
+    size_t num_slots;   // potência de 2
+    const char **keys;  // valor de cada grupo (aponta para uma célula da tabela)
+    uint64_t *hashes;   // hash de cada grupo
+    uint32_t *offsets;  // num_groups + 1 posições em rows
+    size_t num_groups;
+    size_t groups_capacity;
+    uint32_t *rows;     // linhas de cada grupo
+};
+
+// Índice ordenado de uma coluna: as linhas ordenadas pelo valor da coluna
+//
+// as chaves são numéricas (double) se todas as células da coluna forem números, exceto
+// a primeira linha (o cabeçalho); caso contrário são as strings, por ordem de strcmp
+// num índice numérico só entram as células que são números
+// as chaves iguais ficam pela ordem das linhas
+struct ordered_key
+{
+    union
+    {
+        double number;
+        const char *string;
+    };
+    uint32_t row;
+};
+
+struct ordered_index
+{
+    bool numeric;
+    size_t num_keys;
+    struct ordered_key *keys;
+};
+
+static void ordered_index_free(struct ordered_index *ix);
+
+// função auxiliar para calcular o hash de uma string (FNV-1a)
+static uint64_t hash_string(const char *s)
+{
+    uint64_t h = 14695981039346656037ULL;
+    while (*s)
+    {
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// função auxiliar para procurar a posição do valor na tabela de dispersão
+// devolve a posição do valor, ou a posição livre onde deve ser inserido
+static size_t find_slot(const struct hash_index *ix, const char *value, uint64_t h)
+{
+    size_t mask = ix->num_slots - 1;
+    size_t pos = h & mask;
+
+    while (ix->slots[pos])
+    {
+        uint32_t g = ix->slots[pos] - 1;
+        if (ix->hashes[g] == h && strcmp(ix->keys[g], value) == 0)
+            return pos;
+        pos = (pos + 1) & mask;
+    }
+
+    return pos;
+}
+
+// função auxiliar para duplicar a tabela de dispersão (mantemos no máximo 50% de ocupação)
+static int grow_slots(struct hash_index *ix)
+{
+    size_t new_num_slots = ix->num_slots ? ix->num_slots * 2 : 64;
+    uint32_t *new_slots = calloc(new_num_slots, sizeof(uint32_t));
+    if (!new_slots)
+        return -1;
+
+    free(ix->slots);
+    ix->slots = new_slots;
+    ix->num_slots = new_num_slots;
+
+    // voltar a inserir todos os grupos (os valores são todos distintos)
+    for (size_t g = 0; g < ix->num_groups; g++)
+    {
+        size_t pos = ix->hashes[g] & (new_num_slots - 1);
+        while (new_slots[pos])
+            pos = (pos + 1) & (new_num_slots - 1);
+        new_slots[pos] = (uint32_t)g + 1;
+    }
+
+    return 0;
+}
+
+// função auxiliar para acrescentar um grupo novo (os offsets guardam por agora o número de linhas)
+static int add_group(struct hash_index *ix, const char *value, uint64_t h)
+{
+    if (ix->num_groups == ix->groups_capacity)
+    {
+        size_t new_capacity = ix->groups_capacity ? ix->groups_capacity * 2 : 64;
+        const char **keys = realloc(ix->keys, new_capacity * sizeof(char *));
+        if (!keys)
+            return -1;
+        ix->keys = keys;
+
+        uint64_t *hashes = realloc(ix->hashes, new_capacity * sizeof(uint64_t));
+        if (!hashes)
+            return -1;
+        ix->hashes = hashes;
+
+        // mais uma posição para o fim do último grupo
+        uint32_t *offsets = realloc(ix->offsets, (new_capacity + 1) * sizeof(uint32_t));
+        if (!offsets)
+            return -1;
+        ix->offsets = offsets;
+
+        ix->groups_capacity = new_capacity;
+    }
+
+    ix->keys[ix->num_groups] = value;
+    ix->hashes[ix->num_groups] = h;
+    ix->offsets[ix->num_groups] = 0;
+    ix->num_groups++;
+
+    return 0;
+}
+
+static void hash_index_free(struct hash_index *ix)
+{
+    if (!ix)
+        return;
+
+    free(ix->slots);
+    free(ix->keys);
+    free(ix->hashes);
+    free(ix->offsets);
+    free(ix->rows);
+    free(ix);
+}
+
+// função auxiliar para construir o índice da coluna col
+// primeira passagem: encontrar o grupo de cada linha e contar as linhas de cada grupo
+// segunda passagem: colocar cada linha na posição do seu grupo
+static struct hash_index *hash_index_build(const struct table *table, size_t col)
+{
+    struct hash_index *ix = calloc(1, sizeof(struct hash_index));
+    uint32_t *group_of_row = malloc((table->num_rows ? table->num_rows : 1) * sizeof(uint32_t));
+    if (!ix || !group_of_row || grow_slots(ix) != 0)
+        goto error;
+
+    size_t indexed = 0;
+
+    for (size_t i = 0; i < table->num_rows; i++)
+    {
+        const char *value = table_row(table, i)[col];
+        if (!value)
+        {
+            group_of_row[i] = UINT32_MAX;
+            continue;
+        }
+
+        uint64_t h = hash_string(value);
+        size_t pos = find_slot(ix, value, h);
+        if (!ix->slots[pos])
+        {
+            if (add_group(ix, value, h) != 0)
+                goto error;
+            ix->slots[pos] = (uint32_t)ix->num_groups;
+        }
+
+        uint32_t g = ix->slots[pos] - 1;
+        group_of_row[i] = g;
+        ix->offsets[g]++;
+        indexed++;
+
+        if (ix->num_groups * 2 > ix->num_slots && grow_slots(ix) != 0)
+            goto error;
+    }
+
+    // coluna sem valores: os arrays dos grupos ainda não foram criados
+    if (!ix->offsets && !(ix->offsets = calloc(1, sizeof(uint32_t))))
+        goto error;
+
+    // contagens -> posição inicial de cada grupo
+    uint32_t sum = 0;
+    for (size_t g = 0; g < ix->num_groups; g++)
+    {
+        uint32_t count = ix->offsets[g];
+        ix->offsets[g] = sum;
+        sum += count;
+    }
+    ix->offsets[ix->num_groups] = sum;
+
+    ix->rows = malloc((indexed ? indexed : 1) * sizeof(uint32_t));
+    if (!ix->rows)
+        goto error;
+
+    // usamos offsets como cursor de escrita de cada grupo; no fim cada um aponta para o início
+    // do grupo seguinte, por isso basta deslocar os valores uma posição
+    for (size_t i = 0; i < table->num_rows; i++)
+    {
+        if (group_of_row[i] != UINT32_MAX)
+            ix->rows[ix->offsets[group_of_row[i]]++] = (uint32_t)i;
+    }
+    memmove(ix->offsets + 1, ix->offsets, ix->num_groups * sizeof(uint32_t));
+    ix->offsets[0] = 0;
+
+    free(group_of_row);
+    return ix;
+
+error:
+    free(group_of_row);
+    hash_index_free(ix);
+    return NULL;
+}
+
+// função auxiliar para atualizar o índice na compactação da tabela
+// remap dá a nova posição de cada posição antiga (REMAP_DELETED se foi eliminada); como remap
+// é crescente, as linhas de cada grupo continuam por ordem
+static void hash_index_remap(struct hash_index *ix, const uint32_t *remap)
+{
+    uint32_t w = 0;
+    for (size_t g = 0; g < ix->num_groups; g++)
+    {
+        uint32_t begin = ix->offsets[g];
+        uint32_t end = ix->offsets[g + 1];
+        ix->offsets[g] = w;
+
+        for (uint32_t k = begin; k < end; k++)
+        {
+            uint32_t r = remap[ix->rows[k]];
+            if (r != REMAP_DELETED)
+                ix->rows[w++] = r;
+        }
+    }
+    ix->offsets[ix->num_groups] = w;
+}
+
+// função auxiliar para criar a informação das colunas, se ainda não existir
+int table_ensure_columns(struct table *table)
+{
+    if (!table->columns)
+        table->columns = calloc(table->num_cols, sizeof(struct column_info));
+
+    return table->columns ? 0 : -1;
+}
+
+// função para criar um índice hash sobre a coluna col
+// se a coluna já tiver um índice, é reconstruído
+int table_create_index(struct table *table, size_t col)
+{
+    if (!table || table_flush_deletes(table) != 0 || col >= table->num_cols || table->num_rows >= UINT32_MAX ||
+        table_ensure_columns(table) != 0 || table_materialize_columns(table, 1u << col) != 0)
+        return -1;
+
+    struct hash_index *ix = hash_index_build(table, col);
+    if (!ix)
+        return -1;
+
+    hash_index_free(table->columns[col].hash);
+    table->columns[col].hash = ix;
+
+    return 0;
+}
+
+bool table_has_index(const struct table *table, size_t col)
+{
+    return table->columns && col < table->num_cols && table->columns[col].hash;
+}
+
+// contexto do predicado de igualdade usado quando a coluna não tem índice
+struct equals_ctx
+{
+    size_t col;
+    const char *value;
+};
+
+static bool equals_predicate(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    const struct equals_ctx *ctx = (const struct equals_ctx *)context;
+
+    return row[ctx->col] && strcmp(row[ctx->col], ctx->value) == 0;
+}
+
+// Dicionário de uma coluna: cada valor distinto recebe um código (o número do seu grupo na
+// tabela de dispersão do índice hash, sem as listas de linhas) e a coluna guarda o código de
+// cada linha da tabela base; as células da coluna passam a apontar todas para a cópia única
+// do seu valor, e a comparação com um valor passa a ser uma comparação de inteiros
+
+struct dict_job
+{
+    struct table *table;
+    size_t max_distinct;
+};
+
+// função auxiliar para criar o dicionário de uma coluna
+// desiste (e a coluna fica sem dicionário) se a coluna tiver mais de max_distinct valores
+static void dict_column_task(void *arg, size_t col)
+{
+    struct dict_job *job = (struct dict_job *)arg;
+    struct table *table = job->table;
+    struct column_info *info = &table->columns[col];
+
+    if (info->dict)
+        return;
+
+    struct hash_index *dict = calloc(1, sizeof(struct hash_index));
+    uint32_t *codes = malloc((table->num_rows ? table->num_rows : 1) * sizeof(uint32_t));
+    if (!dict || !codes || grow_slots(dict) != 0)
+        goto give_up;
+
+    for (size_t i = 0; i < table->num_rows; i++)
+    {
+        const char *value = table->cells[i * table->num_cols + col];
+        if (!value)
+        {
+            codes[i] = DICT_NO_CODE;
+            continue;
+        }
+
+        uint64_t h = hash_string(value);
+        size_t pos = find_slot(dict, value, h);
+        if (!dict->slots[pos])
+        {
+            if (dict->num_groups == job->max_distinct || add_group(dict, value, h) != 0)
+                goto give_up;
+            dict->slots[pos] = (uint32_t)dict->num_groups;
+        }
+        codes[i] = dict->slots[pos] - 1;
+
+        if (dict->num_groups * 2 > dict->num_slots && grow_slots(dict) != 0)
+            goto give_up;
+    }
+
+    info->dict = dict;
+    info->codes = codes;
+    return;
+
+give_up:
+    hash_index_free(dict);
+    free(codes);
+}
+
+// função auxiliar para copiar as strings da tabela para uma arena nova, sem repetições
+// cada valor de um dicionário é copiado uma só vez; as outras células são copiadas uma a uma
+// no fim, a arena antiga e o ficheiro mapeado (onde estavam as strings) são libertados
+static int compact_strings(struct table *table)
+{
+    struct arena_block *old_arena = arena_detach(table);
+
+    for (size_t col = 0; col < table->num_cols; col++)
+    {
+        struct hash_index *dict = table->columns[col].dict;
+        for (size_t g = 0; dict && g < dict->num_groups; g++)
+        {
+            char *copy = arena_strndup(table, dict->keys[g], strlen(dict->keys[g]));
+            if (!copy)
+                goto error;
+            dict->keys[g] = copy;
+        }
+    }
+
+    for (size_t i = 0; i < table->num_rows; i++)
+    {
+        char **row = table->cells + i * table->num_cols;
+        for (size_t col = 0; col < table->num_cols; col++)
+        {
+            const struct column_info *info = &table->columns[col];
+            if (info->dict)
+                row[col] = info->codes[i] == DICT_NO_CODE ? NULL : (char *)info->dict->keys[info->codes[i]];
+            else if (row[col] && !(row[col] = arena_strndup(table, row[col], strlen(row[col]))))
+                goto error;
+        }
+    }
+
+    // os índices apontam para as strings antigas: são reconstruídos
+    // se a reconstrução falhar, a coluna fica sem esse índice e o erro é devolvido
+    int status = 0;
+    for (size_t col = 0; col < table->num_cols; col++)
+    {
+        struct column_info *info = &table->columns[col];
+        if (info->hash)
+        {
+            hash_index_free(info->hash);
+            info->hash = NULL;
+            if (table_create_index(table, col) != 0)
+                status = -1;
+        }
+        if (info->ordered)
+        {
+            ordered_index_free(info->ordered);
+            info->ordered = NULL;
+            if (table_create_ordered_index(table, col) != 0)
+                status = -1;
+        }
+    }
+
+    arena_release(old_arena);
+    if (table->map_addr)
+    {
+        munmap(table->map_addr, table->map_size);
+        table->map_addr = NULL;
+        table->map_size = 0;
+    }
+
+    return status;
+
+error:
+    // as células já copiadas e as ainda por copiar continuam válidas com as duas arenas
+    arena_attach(table, old_arena);
+    return -1;
+}
+
+// função para criar os dicionários das colunas com poucos valores distintos
+int table_dict_encode(struct table *table, int num_threads)
+{
+    // os códigos pertencem aos dados: numa vista são criados na tabela de origem
+    if (table->source)
+        table = table->source;
+
+    if (table_flush_deletes(table) != 0 || table->num_rows > UINT32_MAX || table_ensure_columns(table) != 0 ||
+        table_materialize_columns(table, ALL_COLUMNS) != 0)
+        return -1;
+
+    struct dict_job job;
+    job.table = table;
+    job.max_distinct = table->num_rows / DICT_MIN_ROWS_PER_VALUE;
+    if (job.max_distinct > DICT_MAX_DISTINCT)
+        job.max_distinct = DICT_MAX_DISTINCT;
+
+    thread_pool_run(num_threads, dict_column_task, &job, table->num_cols);
+
+    // enquanto houver vistas, as strings não podem mudar de sítio (os índices das vistas
+    // apontam para elas); os dicionários ficam, mas sem poupar memória
+    if (table->refcount > 1)
+        return 0;
+
+    return compact_strings(table);
+}
+
+bool table_has_dict(const struct table *table, size_t col)
+{
+    const struct table *base = table->source ? table->source : table;
+    return base->columns && col < base->num_cols && base->columns[col].dict;
+}
+
+// função auxiliar para obter o código de um valor no dicionário da coluna (DICT_NO_CODE se o
+// valor não estiver no dicionário)
+uint32_t dict_lookup(const struct column_info *info, const char *value)
+{
+    size_t pos = find_slot(info->dict, value, hash_string(value));
+    return info->dict->slots[pos] ? info->dict->slots[pos] - 1 : DICT_NO_CODE;
+}
+
+// função auxiliar para filtrar por igualdade uma coluna com dicionário
+// o valor é convertido no seu código e as linhas são comparadas pelo código
+static struct table *dict_filter_equals(const struct table *table, const struct column_info *info,
+                                        const char *value)
+{
+    uint32_t code = dict_lookup(info, value);
+    if (code == DICT_NO_CODE)
+        return table_create_view(table, NULL, 0);
+
+    uint32_t *rows = malloc((table->num_rows ? table->num_rows : 1) * sizeof(uint32_t));
+    if (!rows)
+        return NULL;
+
+    size_t count = 0;
+    for (size_t i = 0; i < table->num_rows; i++)
+    {
+        if (info->codes[table_physical_row(table, i)] == code)
+            rows[count++] = (uint32_t)i;
+    }
+
+    struct table *view = table_create_view(table, rows, count);
+    free(rows);
+
+    return view;
+}
+
+// função para filtrar as linhas com a coluna col igual a value
+// com índice, só são visitadas as linhas do grupo do valor; com dicionário, são comparados
+// os códigos; sem nenhum dos dois, a tabela é percorrida
+struct table *table_filter_equals(const struct table *table, size_t col, const char *value, int num_threads)
+{
+    if (col >= table->num_cols || table_flush_deletes(table) != 0)
+        return NULL;
+
+    if (!table_has_index(table, col) && table_has_dict(table, col))
+    {
+        const struct table *base = table->source ? table->source : table;
+        return dict_filter_equals(table, &base->columns[col], value);
+    }
+
+    if (!table_has_index(table, col))
+    {
+        struct equals_ctx ctx;
+        ctx.col = col;
+        ctx.value = value;
+        return table_filter_columns(table, equals_predicate, &ctx, num_threads, 1u << col);
+    }
+
+    const struct hash_index *ix = table->columns[col].hash;
+    size_t pos = find_slot(ix, value, hash_string(value));
+    if (!ix->slots[pos])
+        return table_create_view(table, NULL, 0);
+
+    uint32_t g = ix->slots[pos] - 1;
+    return table_create_view(table, ix->rows + ix->offsets[g], ix->offsets[g + 1] - ix->offsets[g]);
+}
+
+static int compare_numeric_keys(const void *a, const void *b)
+{
+    const struct ordered_key *x = (const struct ordered_key *)a;
+    const struct ordered_key *y = (const struct ordered_key *)b;
+
+    if (x->number != y->number)
+        return x->number < y->number ? -1 : 1;
+    return x->row < y->row ? -1 : (x->row > y->row);
+}
+
+static int compare_string_keys(const void *a, const void *b)
+{
+    const struct ordered_key *x = (const struct ordered_key *)a;
+    const struct ordered_key *y = (const struct ordered_key *)b;
+
+    int cmp = strcmp(x->string, y->string);
+    if (cmp != 0)
+        return cmp;
+    return x->row < y->row ? -1 : (x->row > y->row);
+}
+
+static void ordered_index_free(struct ordered_index *ix)
+{
+    if (!ix)
+        return;
+
+    free(ix->keys);
+    free(ix);
+}
+
+// função auxiliar para construir o índice ordenado da coluna col
+static struct ordered_index *ordered_index_build(const struct table *table, size_t col)
+{
+    struct ordered_index *ix = calloc(1, sizeof(struct ordered_index));
+    if (ix)
+        ix->keys = malloc((table->num_rows ? table->num_rows : 1) * sizeof(struct ordered_key));
+    if (!ix || !ix->keys)
+    {
+        ordered_index_free(ix);
+        return NULL;
+    }
+
+    // a coluna é numérica se todas as células a seguir ao cabeçalho forem números (ou vazias)
+    // se os tipos já tiverem sido inferidos, os valores são lidos dos arrays da coluna
+    const struct table *base = table->source ? table->source : table;
+    const struct column_info *typed = table_column_type(table, col) != COLUMN_STRING ? &base->columns[col] : NULL;
+    ix->numeric = true;
+    size_t num_numbers = 0;
+    for (size_t i = 0; i < table->num_rows; i++)
+    {
+        struct ordered_key *key = &ix->keys[num_numbers];
+        if (typed)
+        {
+            if (column_number(typed, table_physical_row(table, i), &key->number))
+            {
+                key->row = (uint32_t)i;
+                num_numbers++;
+            }
+            continue;
+        }
+
+        const char *value = table_row(table, i)[col];
+        if (!value)
+            continue;
+
+        if (parse_number(value, &key->number))
+        {
+            key->row = (uint32_t)i;
+            num_numbers++;
+        }
+        else if (i > 0 && !is_blank(value))
+        {
+            ix->numeric = false;
+            break;
+        }
+    }
+
+    if (ix->numeric && num_numbers > 0)
+    {
+        ix->num_keys = num_numbers;
+        qsort(ix->keys, ix->num_keys, sizeof(struct ordered_key), compare_numeric_keys);
+        return ix;
+    }
+
+    ix->numeric = false;
+    for (size_t i = 0; i < table->num_rows; i++)
+    {
+        const char *value = table_row(table, i)[col];
+        if (value)
+        {
+            ix->keys[ix->num_keys].string = value;
+            ix->keys[ix->num_keys].row = (uint32_t)i;
+            ix->num_keys++;
+        }
+    }
+    qsort(ix->keys, ix->num_keys, sizeof(struct ordered_key), compare_string_keys);
+
+    return ix;
+}
+
+// função auxiliar para atualizar o índice ordenado na compactação da tabela (ver hash_index_remap)
+static void ordered_index_remap(struct ordered_index *ix, const uint32_t *remap)
+{
+    size_t w = 0;
+    for (size_t k = 0; k < ix->num_keys; k++)
+    {
+        struct ordered_key key = ix->keys[k];
+        key.row = remap[key.row];
+        if (key.row != REMAP_DELETED)
+            ix->keys[w++] = key;
+    }
+    ix->num_keys = w;
+}
+
+// função para criar um índice ordenado sobre a coluna col
+int table_create_ordered_index(struct table *table, size_t col)
+{
+    if (!table || table_flush_deletes(table) != 0 || col >= table->num_cols || table->num_rows >= UINT32_MAX ||
+        table_ensure_columns(table) != 0 || table_materialize_columns(table, 1u << col) != 0)
+        return -1;
+
+    struct ordered_index *ix = ordered_index_build(table, col);
+    if (!ix)
+        return -1;
+
+    ordered_index_free(table->columns[col].ordered);
+    table->columns[col].ordered = ix;
+
+    return 0;
+}
+
+bool table_has_ordered_index(const struct table *table, size_t col)
+{
+    return table->columns && col < table->num_cols && table->columns[col].ordered;
+}
+
+// intervalo de valores de table_filter_range (os limites NULL não restringem)
+// a comparação é numérica se os limites forem números, senão é por strcmp
+struct range_ctx
+{
+    size_t col;
+    bool numeric;
+    const char *low;
+    const char *high;
+    double low_number;
+    double high_number;
+    bool low_inclusive;
+    bool high_inclusive;
+    const struct table *base;         // tabela base das linhas
+    const struct column_info *typed;  // coluna numérica com os valores já convertidos (ou NULL)
+};
+
+// função auxiliar para comparar uma chave do índice com um limite do intervalo
+static int compare_key(const struct range_ctx *range, const struct ordered_key *key, bool high)
+{
+    if (range->numeric)
+    {
+        double bound = high ? range->high_number : range->low_number;
+        return key->number < bound ? -1 : (key->number > bound);
+    }
+    return strcmp(key->string, high ? range->high : range->low);
+}
+
+// função auxiliar para testar se uma célula está dentro do intervalo
+static bool range_predicate(const void *row_ptr, const void *context)
+{
+    char **row = (char **)row_ptr;
+    const struct range_ctx *range = (const struct range_ctx *)context;
+    struct ordered_key key;
+
+    if (range->typed)
+    {
+        // as linhas apontam para a matriz da tabela base: a posição dá o número da linha
+        size_t row_num = (size_t)(row - range->base->cells) / range->base->num_cols;
+        if (!column_number(range->typed, row_num, &key.number))
+            return false;
+    }
+    else if (!row[range->col])
+        return false;
+    else if (range->numeric)
+    {
+        if (!parse_number(row[range->col], &key.number))
+            return false;
+    }
+    else
+        key.string = row[range->col];
+
+    if (range->low)
+    {
+        int cmp = compare_key(range, &key, false);
+        if (cmp < 0 || (cmp == 0 && !range->low_inclusive))
+            return false;
+    }
+    if (range->high)
+    {
+        int cmp = compare_key(range, &key, true);
+        if (cmp > 0 || (cmp == 0 && !range->high_inclusive))
+            return false;
+    }
+
+    return true;
+}
+
+// função auxiliar para a pesquisa binária: primeira chave em que o limite deixa de ser satisfeito
+// (após o limite inferior, para high falso; após o limite superior, para high verdadeiro)
+static size_t search_bound(const struct ordered_index *ix, const struct range_ctx *range, bool high)
+{
+    bool inclusive = high ? range->high_inclusive : range->low_inclusive;
+    // o limite inferior exclui as chaves menores (ou iguais, se não for inclusivo)
+    // o limite superior inclui as chaves menores (ou iguais, se for inclusivo)
+    bool skip_equal = high ? inclusive : !inclusive;
+    size_t lo = 0;
+    size_t hi = ix->num_keys;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = compare_key(range, &ix->keys[mid], high);
+        if (cmp < 0 || (cmp == 0 && skip_equal))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static int compare_rows(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : (x > y);
+}
+
+// função para filtrar as linhas com a coluna col no intervalo [low, high]
+// com um índice ordenado do mesmo tipo, o intervalo é encontrado por pesquisa binária e só as
+// linhas do resultado são visitadas; senão a tabela é percorrida com num_threads threads
+struct table *table_filter_range(const struct table *table, size_t col,
+                                 const char *low, bool low_inclusive,
+                                 const char *high, bool high_inclusive, int num_threads)
+{
+    if (col >= table->num_cols || table_flush_deletes(table) != 0)
+        return NULL;
+
+    struct range_ctx range;
+    range.col = col;
+    range.low = low;
+    range.high = high;
+    range.low_inclusive = low_inclusive;
+    range.high_inclusive = high_inclusive;
+    range.numeric = (low || high) &&
+                    (!low || parse_number(low, &range.low_number)) &&
+                    (!high || parse_number(high, &range.high_number));
+
+    range.base = table->source ? table->source : table;
+    range.typed = range.numeric && table_column_type(table, col) != COLUMN_STRING ? &range.base->columns[col] : NULL;
+
+    const struct ordered_index *ix = table_has_ordered_index(table, col) ? table->columns[col].ordered : NULL;
+    if (!ix || ix->numeric != range.numeric)
+        return table_filter_columns(table, range_predicate, &range, num_threads, 1u << col);
+
+    size_t begin = low ? search_bound(ix, &range, false) : 0;
+    size_t end = high ? search_bound(ix, &range, true) : ix->num_keys;
+    size_t count = end > begin ? end - begin : 0;
+
+    uint32_t *rows = malloc((count ? count : 1) * sizeof(uint32_t));
+    if (!rows)
+        return NULL;
+
+    // a vista mantém a ordem da tabela: as linhas do intervalo são reordenadas
+    // com muitas linhas é mais rápido marcá-las num mapa de bits e percorrê-lo
+    if (count > table->num_rows / 16)
+    {
+        uint64_t *marks = calloc((table->num_rows + 63) / 64, sizeof(uint64_t));
+        if (!marks)
+        {
+            free(rows);
+            return NULL;
+        }
+
+        for (size_t k = begin; k < end; k++)
+            marks[ix->keys[k].row / 64] |= (uint64_t)1 << (ix->keys[k].row % 64);
+
+        size_t n = 0;
+        for (size_t w = 0; w < (table->num_rows + 63) / 64; w++)
+        {
+            for (uint64_t m = marks[w]; m; m &= m - 1)
+                rows[n++] = (uint32_t)(w * 64 + __builtin_ctzll(m));
+        }
+        free(marks);
+    }
+    else
+    {
+        for (size_t k = begin; k < end; k++)
+            rows[k - begin] = ix->keys[k].row;
+        qsort(rows, count, sizeof(uint32_t), compare_rows);
+    }
+
+    struct table *view = table_create_view(table, rows, count);
+    free(rows);
+
+    return view;
+}
+
+// função auxiliar para atualizar os índices na compactação da tabela
+int table_index_compact(struct table *table)
+{
+    bool has_indexes = false;
+    for (size_t col = 0; table->columns && col < table->num_cols; col++)
+        has_indexes = has_indexes || table->columns[col].hash || table->columns[col].ordered;
+    if (!has_indexes)
+        return 0;
+
+    // nova posição de cada posição antiga
+    const struct tombstones *ts = table->deleted;
+    uint32_t *remap = malloc((ts->num_slots ? ts->num_slots : 1) * sizeof(uint32_t));
+    if (!remap)
+        return -1;
+
+    uint32_t w = 0;
+    for (size_t slot = 0; slot < ts->num_slots; slot++)
+        remap[slot] = (ts->bits[slot / 64] >> (slot % 64) & 1) ? REMAP_DELETED : w++;
+
+    for (size_t col = 0; col < table->num_cols; col++)
+    {
+        if (table->columns[col].hash)
+            hash_index_remap(table->columns[col].hash, remap);
+        if (table->columns[col].ordered)
+            ordered_index_remap(table->columns[col].ordered, remap);
+    }
+
+    free(remap);
+    return 0;
+}
+
+// função auxiliar para reordenar a informação das colunas quando as linhas da tabela base mudam
+// de posição (table_sort): order[i] é a posição antiga da linha que fica na posição i
+// os índices passam a ter as posições novas (as linhas de cada grupo do índice hash voltam a
+// ficar por ordem) e os valores e códigos são copiados pela nova ordem; se faltar memória, a
+// informação da coluna é descartada (como se as células tivessem mudado)
+void table_columns_permute(struct table *table, const uint32_t *order)
+{
+    size_t n = table->num_rows;
+    uint32_t *remap = table->columns ? malloc((n ? n : 1) * sizeof(uint32_t)) : NULL;
+    if (remap)
+    {
+        for (size_t i = 0; i < n; i++)
+            remap[order[i]] = (uint32_t)i;
+    }
+
+    for (size_t col = 0; table->columns && col < table->num_cols; col++)
+    {
+        struct column_info *info = &table->columns[col];
+        if (!remap)
+        {
+            table_reset_column(table, col);
+            continue;
+        }
+
+        if (info->hash)
+        {
+            struct hash_index *ix = info->hash;
+            hash_index_remap(ix, remap);
+            for (size_t g = 0; g < ix->num_groups; g++)
+                qsort(ix->rows + ix->offsets[g], ix->offsets[g + 1] - ix->offsets[g], sizeof(uint32_t), compare_rows);
+        }
+        if (info->ordered)
+            ordered_index_remap(info->ordered, remap);
+
+        bool ok = true;
+        if (info->codes)
+        {
+            uint32_t *codes = malloc((n ? n : 1) * sizeof(uint32_t));
+            if (codes)
+            {
+                for (size_t i = 0; i < n; i++)
+                    codes[i] = info->codes[order[i]];
+                free(info->codes);
+                info->codes = codes;
+            }
+            ok = codes != NULL;
+        }
+        if (ok && info->values)
+        {
+            union column_value *values = malloc((n ? n : 1) * sizeof(union column_value));
+            uint64_t *nulls = calloc(n ? (n + 63) / 64 : 1, sizeof(uint64_t));
+            if (values && nulls)
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    values[i] = info->values[order[i]];
+                    nulls[i / 64] |= (info->nulls[order[i] / 64] >> (order[i] % 64) & 1) << (i % 64);
+                }
+                free(info->values);
+                free(info->nulls);
+                info->values = values;
+                info->nulls = nulls;
+            }
+            else
+            {
+                free(values);
+                free(nulls);
+                ok = false;
+            }
+        }
+
+        if (!ok)
+            table_reset_column(table, col);
+    }
+
+    free(remap);
+}
+
+// função auxiliar para calcular a memória de um índice hash (ou dicionário)
+static size_t hash_index_memory(const struct hash_index *ix)
+{
+    if (!ix)
+        return 0;
+
+    return sizeof(struct hash_index) + ix->num_slots * sizeof(uint32_t) +
+           ix->groups_capacity * (sizeof(const char *) + sizeof(uint64_t) + sizeof(uint32_t)) +
+           (ix->offsets ? (ix->offsets[ix->num_groups] + 1) * sizeof(uint32_t) : 0);
+}
+
+// função auxiliar para calcular a memória da informação das colunas (table_memory_usage)
+// num_slots: número de linhas dos arrays indexados pelas linhas da tabela
+size_t table_columns_memory(const struct table *table, size_t num_slots)
+{
+    if (!table->columns)
+        return 0;
+
+    size_t total = table->num_cols * sizeof(struct column_info);
+    for (size_t col = 0; col < table->num_cols; col++)
+    {
+        const struct column_info *info = &table->columns[col];
+
+        total += hash_index_memory(info->hash) + hash_index_memory(info->dict);
+        if (info->ordered)
+            total += sizeof(struct ordered_index) + info->ordered->num_keys * sizeof(struct ordered_key);
+        if (info->values)
+            total += num_slots * sizeof(union column_value) + (num_slots + 63) / 64 * sizeof(uint64_t);
+        if (info->codes)
+            total += num_slots * sizeof(uint32_t);
+    }
+
+    return total;
+}
+
+// função auxiliar para descartar os índices, tipos e dicionário de uma coluna cujas células mudaram
+void table_reset_column(struct table *table, size_t col)
+{
+    if (!table->columns)
+        return;
+
+    struct column_info *info = &table->columns[col];
+    hash_index_free(info->hash);
+    ordered_index_free(info->ordered);
+    free(info->values);
+    free(info->nulls);
+    hash_index_free(info->dict);
+    free(info->codes);
+    memset(info, 0, sizeof(struct column_info));
+    info->type = COLUMN_STRING;
+}
+
+// função auxiliar para libertar a informação das colunas (índices, tipos, dicionários)
+void table_free_columns(struct table *table)
+{
+    if (!table->columns)
+        return;
+
+    for (size_t col = 0; col < table->num_cols; col++)
+    {
+        hash_index_free(table->columns[col].hash);
+        ordered_index_free(table->columns[col].ordered);
+        free(table->columns[col].values);
+        free(table->columns[col].nulls);
+        hash_index_free(table->columns[col].dict);
+        free(table->columns[col].codes);
+    }
+
+    free(table->columns);
+    table->columns = NULL;
+}
@@ -0,0 +1,205 @@
+#ifndef TABLE_INTERNAL_H
+#define TABLE_INTERNAL_H
+
+// Funções internas da biblioteca, partilhadas entre os ficheiros de ../table
+// (não fazem parte da interface pública em table.h)
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include "table.h"
+
+// Reserva size bytes na arena da tabela
+char *arena_alloc(struct table *t, size_t size);
+
+// Copia uma string (len bytes) para a arena da tabela, terminada com '\0'
+char *arena_strndup(struct table *t, const char *s, size_t len);
+
+// Esvazia a arena da tabela, ficando só com o bloco mais recente para reutilizar
+void arena_reset(struct table *t);
+
+// Retira a arena à tabela (que fica com uma arena vazia) e devolve os seus blocos
+struct arena_block *arena_detach(struct table *t);
+
+// Devolve à tabela os blocos de uma arena retirada com arena_detach
+void arena_attach(struct table *t, struct arena_block *blocks);
+
+// Liberta os blocos de uma arena retirada com arena_detach
+void arena_release(struct arena_block *blocks);
+
+// Cria uma tabela vazia com num_cols colunas
+struct table *table_create(size_t num_cols);
+
+// Garante que a matriz de células tem espaço para mais uma linha (0 em sucesso, -1 em erro)
+int table_reserve_row(struct table *t);
+
+// Cria uma vista da tabela com as linhas rows (índices em table, num_rows linhas)
+struct table *table_create_view(const struct table *table, const uint32_t *rows, size_t num_rows);
+
+// Lê as linhas do buffer [buf, end) para a tabela (ver table.c)
+// devolve o número de bytes consumidos ou -1 em erro
+ssize_t load_rows(struct table *t, char *buf, char *end, bool in_place, bool last, int *last_sep);
+
+// Células vistas (table_load_csv_mmap): um campo sem aspas escapadas não é copiado; a célula é o
+// endereço do campo no ficheiro mapeado e o campo acaba no separador seguinte (ou na aspa final,
+// num campo entre aspas), por isso não tem '\0'
+// só existem enquanto lazy_cols não for 0 e só são lidas pela biblioteca (com table_row): para
+// fora, table_get_row copia-as antes de devolver a linha
+
+// Máscara de lazy_cols com todas as colunas
+#define ALL_COLUMNS UINT32_MAX
+
+// Testa se a célula da tabela base é uma vista sobre o ficheiro mapeado (as células copiadas
+// vivem na arena, fora do mapeamento; as de um snapshot mapeado têm '\0' e lazy_cols a 0)
+static inline bool cell_is_view(const struct table *base, const char *cell)
+{
+    return base->lazy_cols && (uintptr_t)cell - (uintptr_t)base->map_addr < base->map_size;
+}
+
+// Comprimento do campo de uma célula vista da tabela base
+size_t cell_view_length(const struct table *base, const char *cell);
+
+// Copia para a arena as células vistas das colunas cols (máscara de bits) de todas as linhas
+// da tabela base (numa vista, da tabela de origem); 0 em sucesso, -1 em erro
+int table_materialize_columns(const struct table *table, uint32_t cols);
+
+// Filtra a tabela como table_filter_parallel, copiando antes só as colunas cols que o predicado lê
+struct table *table_filter_columns(const struct table *table,
+                                   bool (*predicate)(const void *row, const void *context),
+                                   const void *context, int num_threads, uint32_t cols);
+
+// Escritor de CSV com buffer (table_write.c)
+// com fd >= 0 o buffer é escrito no ficheiro quando enche; com fd < 0 o buffer cresce e
+// fica com todo o texto formatado (usado pelas threads de table_save_csv_parallel)
+struct csv_writer
+{
+    int fd;
+    char *buf;
+    size_t len;  // bytes no buffer ainda por escrever
+    size_t size; // capacidade do buffer
+    long bytes;  // total de bytes formatados
+    bool error;
+};
+
+// Inicializa o escritor (0 em sucesso, -1 em erro)
+int csv_writer_init(struct csv_writer *w, int fd);
+
+// Formata as linhas [first, end) da tabela em CSV
+void csv_writer_rows(struct csv_writer *w, const struct table *table, size_t first, size_t end);
+
+// Escreve no ficheiro o que estiver no buffer (0 em sucesso, -1 se alguma escrita falhou)
+int csv_writer_flush(struct csv_writer *w);
+
+// Liberta o buffer do escritor (não fecha o ficheiro)
+void csv_writer_free(struct csv_writer *w);
+
+// Índices de uma coluna (definidos em table_index.c)
+struct hash_index;
+struct ordered_index;
+
+// Valor de uma célula de uma coluna numérica
+union column_value
+{
+    int64_t i;
+    double d;
+};
+
+// Informação extra de uma coluna
+struct column_info
+{
+    struct hash_index *hash;       // índice hash da coluna (ou NULL)
+    struct ordered_index *ordered; // índice ordenado da coluna (ou NULL)
+    enum column_type type;         // tipo inferido por table_infer_types (COLUMN_STRING por omissão)
+    union column_value *values;    // colunas numéricas: valor de cada linha da tabela base
+    uint64_t *nulls;               // colunas numéricas: mapa de bits das linhas sem valor
+    struct hash_index *dict;       // dicionário da coluna: valor distinto -> código (ou NULL)
+    uint32_t *codes;               // colunas com dicionário: código de cada linha da tabela base
+};
+
+// Código das células NULL de uma coluna com dicionário
+#define DICT_NO_CODE UINT32_MAX
+
+// Código de value no dicionário da coluna (DICT_NO_CODE se não estiver no dicionário)
+uint32_t dict_lookup(const struct column_info *info, const char *value);
+
+// Memória usada pela informação das colunas (índices, tipos, dicionários), com arrays de num_slots linhas
+size_t table_columns_memory(const struct table *table, size_t num_slots);
+
+// Cria a informação das colunas da tabela, se ainda não existir (0 em sucesso, -1 em erro)
+int table_ensure_columns(struct table *table);
+
+// Linhas eliminadas ainda por compactar (table_delete.c)
+struct tombstones
+{
+    uint64_t *bits;   // mapa de bits das posições eliminadas
+    uint32_t *tree;   // árvore de Fenwick (índices a partir de 1) com o número de posições vivas
+    size_t num_slots; // número de posições (linhas vivas e eliminadas)
+};
+
+// Posição (na matriz, ou na seleção de uma vista) da linha row_index, saltando as eliminadas
+size_t tombstones_select(const struct tombstones *ts, size_t row_index);
+
+// Compacta a tabela, se tiver linhas eliminadas, antes de uma operação que percorre as posições
+// diretamente (retorna 0 em sucesso, -1 em erro)
+int table_flush_deletes(const struct table *table);
+
+// Liberta as marcas das linhas eliminadas
+void table_free_deletes(struct table *table);
+
+// Atualiza os índices da tabela na compactação: as posições eliminadas saem e as seguintes
+// mudam de número (retorna 0 em sucesso, -1 em erro, sem alterar os índices)
+int table_index_compact(struct table *table);
+
+// Remove as posições eliminadas dos valores das colunas numéricas e dos códigos dos dicionários
+// (só numa tabela base)
+void table_types_compact(struct table *table);
+
+// Reordena a informação das colunas de uma tabela base cujas linhas mudaram de posição
+// (order[i]: posição antiga da linha que fica na posição i)
+void table_columns_permute(struct table *table, const uint32_t *order);
+
+// Descarta os índices, tipos e dicionário da coluna col (as suas células mudaram)
+void table_reset_column(struct table *table, size_t col);
+
+// Liberta a informação extra das colunas (índices, tipos, ...)
+void table_free_columns(struct table *table);
+
+// Linha da tabela base correspondente à linha row_index da tabela (ou vista)
+static inline size_t table_physical_row(const struct table *table, size_t row_index)
+{
+    if (table->deleted)
+        row_index = tombstones_select(table->deleted, row_index);
+    return table->source ? table->selection[row_index] : row_index;
+}
+
+// Linha row_index da tabela, tal como está na matriz de células (as células vistas não são
+// copiadas: a biblioteca copia antes as colunas que lê, com table_materialize_columns)
+static inline char **table_row(const struct table *table, size_t row_index)
+{
+    // numa vista, a linha é a linha selecionada da tabela de origem
+    // com linhas eliminadas ainda por compactar, a posição da linha é procurada (table_delete.c)
+    const struct table *base = table->source ? table->source : table;
+    return base->cells + table_physical_row(table, row_index) * table->num_cols;
+}
+
+// Valor da linha row (da tabela base) de uma coluna numérica, convertido para double
+// devolve falso se a linha não tiver valor
+static inline bool column_number(const struct column_info *info, size_t row, double *value)
+{
+    if (info->nulls[row / 64] >> (row % 64) & 1)
+        return false;
+
+    *value = info->type == COLUMN_INT64 ? (double)info->values[row].i : info->values[row].d;
+    return true;
+}
+
+// Testa se a string só tem espaços
+bool is_blank(const char *s);
+
+// Converte uma célula num número (a célula tem de ser só o número, com espaços opcionais)
+bool parse_number(const char *s, double *value);
+
+// Converte uma célula num inteiro de 64 bits (a célula tem de ser só o número)
+bool parse_int64(const char *s, int64_t *value);
+
+#endif
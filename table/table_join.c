@@ -0,0 +1,453 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "table.h"
+#include "table_internal.h"
+#include "thread_pool.h"
+
+// Junção por hash (table_hash_join)
+//
+// construção: as linhas da tabela mais pequena são juntadas por valor da coluna de junção numa
+// tabela de dispersão (endereçamento aberto, como o índice hash); as linhas de cada valor ficam
+// numa lista, pela ordem das linhas
+// procura: as linhas da outra tabela são divididas em partes, uma por tarefa do pool de threads,
+// e cada tarefa procura o valor de cada linha e guarda os pares de linhas que se juntam
+// os pares ficam pela ordem das linhas da tabela da esquerda (e, para a mesma linha, pela ordem
+// das linhas da direita) e as células são copiadas para a tabela nova, também em paralelo
+
+#define JOIN_NO_ROW UINT32_MAX
+
+// Tabela de dispersão do lado da construção
+struct join_build
+{
+    uint32_t *slots;    // valor + 1 de cada posição (0 = posição livre)
+    size_t num_slots;   // potência de 2
+    const char **keys;  // cada valor distinto (aponta para uma célula da tabela)
+    uint64_t *hashes;   // hash de cada valor
+    uint32_t *heads;    // primeira linha de cada valor
+    size_t num_keys;
+    size_t keys_capacity;
+    uint32_t *next;     // linha seguinte com o mesmo valor (JOIN_NO_ROW no fim da lista)
+};
+
+// Pares de linhas (da procura, da construção) encontrados por uma parte
+struct join_pairs
+{
+    uint32_t *pairs; // 2 posições por par
+    size_t count;
+    size_t capacity;
+    bool error;
+};
+
+struct join_job
+{
+    const struct table *build_table;
+    size_t build_col;
+    const struct table *probe_table;
+    size_t probe_col;
+    size_t probe_first;
+    size_t num_parts;
+    struct join_build *build;
+    struct join_pairs *parts;
+
+    // cópia das células
+    const struct table *left;
+    const struct table *right;
+    const uint32_t *rows;     // 2 posições por linha do resultado: linha da esquerda e da direita
+    size_t num_rows;          // linhas do resultado, sem o cabeçalho
+    struct table *result;
+    struct table **scratch;   // uma tabela por bloco, dona das strings copiadas pelo bloco
+};
+
+// função auxiliar para calcular o hash de uma string (FNV-1a, com os bits baixos baralhados)
+static uint64_t join_hash(const char *s)
+{
+    uint64_t h = 14695981039346656037ULL;
+    while (*s)
+    {
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// função auxiliar para procurar o valor na tabela de dispersão
+// devolve a posição do valor, ou a posição livre onde deve ser inserido
+static size_t find_join_slot(const struct join_build *b, const char *value, uint64_t h)
+{
+    size_t mask = b->num_slots - 1;
+    size_t pos = h & mask;
+
+    while (b->slots[pos])
+    {
+        uint32_t k = b->slots[pos] - 1;
+        if (b->hashes[k] == h && strcmp(b->keys[k], value) == 0)
+            return pos;
+        pos = (pos + 1) & mask;
+    }
+
+    return pos;
+}
+
+// função auxiliar para duplicar a tabela de dispersão (mantemos no máximo 50% de ocupação)
+static int grow_join_slots(struct join_build *b)
+{
+    size_t new_num_slots = b->num_slots ? b->num_slots * 2 : 64;
+    uint32_t *new_slots = calloc(new_num_slots, sizeof(uint32_t));
+    if (!new_slots)
+        return -1;
+
+    free(b->slots);
+    b->slots = new_slots;
+    b->num_slots = new_num_slots;
+
+    for (size_t k = 0; k < b->num_keys; k++)
+    {
+        size_t pos = b->hashes[k] & (new_num_slots - 1);
+        while (new_slots[pos])
+            pos = (pos + 1) & (new_num_slots - 1);
+        new_slots[pos] = (uint32_t)k + 1;
+    }
+
+    return 0;
+}
+
+// função auxiliar para acrescentar um valor novo na posição pos (retorna 0 em sucesso, -1 em erro)
+static int add_join_key(struct join_build *b, size_t pos, const char *value, uint64_t h)
+{
+    if (b->num_keys == b->keys_capacity)
+    {
+        size_t new_capacity = b->keys_capacity ? b->keys_capacity * 2 : 64;
+        const char **keys = realloc(b->keys, new_capacity * sizeof(char *));
+        if (!keys)
+            return -1;
+        b->keys = keys;
+
+        uint64_t *hashes = realloc(b->hashes, new_capacity * sizeof(uint64_t));
+        if (!hashes)
+            return -1;
+        b->hashes = hashes;
+
+        uint32_t *heads = realloc(b->heads, new_capacity * sizeof(uint32_t));
+        if (!heads)
+            return -1;
+        b->heads = heads;
+
+        b->keys_capacity = new_capacity;
+    }
+
+    b->keys[b->num_keys] = value;
+    b->hashes[b->num_keys] = h;
+    b->heads[b->num_keys] = JOIN_NO_ROW;
+    b->slots[pos] = (uint32_t)b->num_keys + 1;
+    b->num_keys++;
+
+    if (2 * b->num_keys > b->num_slots)
+        return grow_join_slots(b);
+    return 0;
+}
+
+static void free_join_build(struct join_build *b)
+{
+    free(b->slots);
+    free(b->keys);
+    free(b->hashes);
+    free(b->heads);
+    free(b->next);
+}
+
+// função auxiliar para construir a tabela de dispersão com as linhas [first, num_rows) da tabela
+// (as células vazias ou NULL nunca se juntam a nada; retorna 0 em sucesso, -1 em erro)
+static int build_join(struct join_build *b, const struct table *table, size_t col, size_t first)
+{
+    memset(b, 0, sizeof(*b));
+    b->next = malloc((table->num_rows ? table->num_rows : 1) * sizeof(uint32_t));
+    if (!b->next || grow_join_slots(b) != 0)
+        return -1;
+
+    // as linhas são inseridas no início da lista do seu valor, da última para a primeira, para
+    // cada lista ficar pela ordem das linhas
+    for (size_t i = table->num_rows; i-- > first;)
+    {
+        const char *value = table_row(table, i)[col];
+        if (!value || is_blank(value))
+            continue;
+
+        uint64_t h = join_hash(value);
+        size_t pos = find_join_slot(b, value, h);
+        uint32_t k;
+        if (b->slots[pos])
+        {
+            k = b->slots[pos] - 1;
+        }
+        else
+        {
+            // um valor novo é o último (pos deixa de ser válida se a tabela crescer)
+            if (add_join_key(b, pos, value, h) != 0)
+                return -1;
+            k = (uint32_t)b->num_keys - 1;
+        }
+        b->next[i] = b->heads[k];
+        b->heads[k] = (uint32_t)i;
+    }
+
+    return 0;
+}
+
+// função auxiliar para guardar um par de linhas (retorna 0 em sucesso, -1 em erro)
+static int add_pair(struct join_pairs *p, uint32_t probe_row, uint32_t build_row)
+{
+    if (p->count == p->capacity)
+    {
+        size_t new_capacity = p->capacity ? p->capacity * 2 : 1024;
+        uint32_t *pairs = realloc(p->pairs, new_capacity * 2 * sizeof(uint32_t));
+        if (!pairs)
+            return -1;
+        p->pairs = pairs;
+        p->capacity = new_capacity;
+    }
+
+    p->pairs[2 * p->count] = probe_row;
+    p->pairs[2 * p->count + 1] = build_row;
+    p->count++;
+    return 0;
+}
+
+// tarefa: procurar as linhas de uma parte da tabela de procura
+static void probe_task(void *arg, size_t index)
+{
+    struct join_job *job = (struct join_job *)arg;
+    struct join_pairs *p = &job->parts[index];
+    size_t count = job->probe_table->num_rows - job->probe_first;
+    size_t begin = job->probe_first + index * count / job->num_parts;
+    size_t end = job->probe_first + (index + 1) * count / job->num_parts;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        const char *value = table_row(job->probe_table, i)[job->probe_col];
+        if (!value || is_blank(value))
+            continue;
+
+        size_t pos = find_join_slot(job->build, value, join_hash(value));
+        if (!job->build->slots[pos])
+            continue;
+
+        for (uint32_t r = job->build->heads[job->build->slots[pos] - 1]; r != JOIN_NO_ROW; r = job->build->next[r])
+        {
+            if (add_pair(p, (uint32_t)i, r) != 0)
+            {
+                p->error = true;
+                return;
+            }
+        }
+    }
+}
+
+// tarefa: copiar as células de um bloco de linhas do resultado
+static void copy_join_task(void *arg, size_t index)
+{
+    struct join_job *job = (struct join_job *)arg;
+    struct table *result = job->result;
+    size_t begin = index * JOIN_MIN_PART_ROWS;
+    size_t end = begin + JOIN_MIN_PART_ROWS;
+    if (end > job->num_rows)
+        end = job->num_rows;
+
+    struct table *scratch = table_create(0);
+    job->scratch[index] = scratch;
+    if (!scratch)
+        return;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        // a linha 0 do resultado é o cabeçalho
+        char **out = result->cells + (i + 1) * result->num_cols;
+        char **l = table_row(job->left, job->rows[2 * i]);
+        char **r = table_row(job->right, job->rows[2 * i + 1]);
+
+        for (size_t c = 0; c < result->num_cols; c++)
+        {
+            const char *cell = c < job->left->num_cols ? l[c] : r[c - job->left->num_cols];
+            out[c] = NULL;
+            if (cell && !(out[c] = arena_strndup(scratch, cell, strlen(cell))))
+            {
+                // sem memória: o bloco fica sem tabela e o resultado é descartado
+                table_free(scratch);
+                job->scratch[index] = NULL;
+                return;
+            }
+        }
+    }
+}
+
+// função auxiliar para escrever o cabeçalho do resultado (os nomes das duas tabelas, ou as
+// letras das colunas da tabela que não tiver cabeçalho)
+static int join_header(struct table *result, const struct table *table, size_t first, size_t offset)
+{
+    char **header = first ? table_row(table, 0) : NULL;
+    for (size_t c = 0; c < table->num_cols; c++)
+    {
+        char letter[2] = {(char)('A' + c), '\0'};
+        const char *name = header && header[c] ? header[c] : letter;
+        if (!(result->cells[offset + c] = arena_strndup(result, name, strlen(name))))
+            return -1;
+    }
+    return 0;
+}
+
+// função para juntar as linhas de left e right com o mesmo valor nas colunas left_col e right_col
+struct table *table_hash_join(const struct table *left, size_t left_col, const struct table *right,
+                              size_t right_col, int num_threads)
+{
+    if (left_col >= left->num_cols || right_col >= right->num_cols || left->num_cols + right->num_cols > MAX_COLS ||
+        left->num_rows > UINT32_MAX || right->num_rows > UINT32_MAX ||
+        table_flush_deletes(left) != 0 || table_flush_deletes(right) != 0 ||
+        table_materialize_columns(left, ALL_COLUMNS) != 0 || table_materialize_columns(right, ALL_COLUMNS) != 0)
+        return NULL;
+
+    // a primeira linha de uma tabela carregada (o cabeçalho) não entra na junção
+    size_t left_first = left->num_rows > 0 && table_physical_row(left, 0) == 0 ? 1 : 0;
+    size_t right_first = right->num_rows > 0 && table_physical_row(right, 0) == 0 ? 1 : 0;
+
+    // a tabela de dispersão é construída com a tabela mais pequena
+    bool build_left = left->num_rows - left_first < right->num_rows - right_first;
+
+    struct join_build build;
+    struct join_job job;
+    memset(&job, 0, sizeof(job));
+    job.build_table = build_left ? left : right;
+    job.build_col = build_left ? left_col : right_col;
+    job.probe_table = build_left ? right : left;
+    job.probe_col = build_left ? right_col : left_col;
+    job.probe_first = build_left ? right_first : left_first;
+    job.build = &build;
+    job.left = left;
+    job.right = right;
+
+    if (build_join(&build, job.build_table, job.build_col, build_left ? left_first : right_first) != 0)
+    {
+        free_join_build(&build);
+        return NULL;
+    }
+
+    // partes da procura: uma por thread, com pelo menos JOIN_MIN_PART_ROWS linhas
+    size_t probe_rows = job.probe_table->num_rows - job.probe_first;
+    job.num_parts = probe_rows / JOIN_MIN_PART_ROWS;
+    if (job.num_parts > (size_t)num_threads)
+        job.num_parts = num_threads;
+    if (job.num_parts == 0)
+        job.num_parts = 1;
+
+    job.parts = calloc(job.num_parts, sizeof(struct join_pairs));
+    if (!job.parts)
+    {
+        free_join_build(&build);
+        return NULL;
+    }
+
+    thread_pool_run(num_threads, probe_task, &job, job.num_parts);
+    free_join_build(&build);
+
+    bool error = false;
+    for (size_t p = 0; p < job.num_parts; p++)
+    {
+        error = error || job.parts[p].error;
+        job.num_rows += job.parts[p].count;
+    }
+
+    // pares (esquerda, direita), pela ordem das linhas da esquerda
+    uint32_t *rows = error ? NULL : malloc((job.num_rows ? job.num_rows : 1) * 2 * sizeof(uint32_t));
+    uint32_t *offsets = build_left && rows ? calloc(left->num_rows + 1, sizeof(uint32_t)) : NULL;
+    if (!rows || (build_left && !offsets))
+    {
+        free(rows);
+        for (size_t p = 0; p < job.num_parts; p++)
+            free(job.parts[p].pairs);
+        free(job.parts);
+        return NULL;
+    }
+
+    if (!build_left)
+    {
+        // a procura foi feita com a esquerda: os pares já estão pela ordem certa
+        size_t w = 0;
+        for (size_t p = 0; p < job.num_parts; p++)
+        {
+            memcpy(rows + 2 * w, job.parts[p].pairs, job.parts[p].count * 2 * sizeof(uint32_t));
+            w += job.parts[p].count;
+        }
+    }
+    else
+    {
+        // a procura foi feita com a direita: ordenar os pares pela linha da esquerda, contando
+        // os pares de cada linha (a ordem das linhas da direita mantém-se)
+        for (size_t p = 0; p < job.num_parts; p++)
+        {
+            for (size_t i = 0; i < job.parts[p].count; i++)
+                offsets[job.parts[p].pairs[2 * i + 1] + 1]++;
+        }
+        for (size_t i = 0; i < left->num_rows; i++)
+            offsets[i + 1] += offsets[i];
+        for (size_t p = 0; p < job.num_parts; p++)
+        {
+            for (size_t i = 0; i < job.parts[p].count; i++)
+            {
+                uint32_t l = job.parts[p].pairs[2 * i + 1];
+                uint32_t w = offsets[l]++;
+                rows[2 * w] = l;
+                rows[2 * w + 1] = job.parts[p].pairs[2 * i];
+            }
+        }
+    }
+
+    free(offsets);
+    for (size_t p = 0; p < job.num_parts; p++)
+        free(job.parts[p].pairs);
+    free(job.parts);
+
+    // tabela nova: o cabeçalho e uma linha por par
+    struct table *result = table_create(left->num_cols + right->num_cols);
+    size_t num_blocks = (job.num_rows + JOIN_MIN_PART_ROWS - 1) / JOIN_MIN_PART_ROWS;
+    job.scratch = calloc(num_blocks ? num_blocks : 1, sizeof(struct table *));
+    if (result)
+        result->cells = malloc((job.num_rows + 1) * result->num_cols * sizeof(char *));
+
+    if (!result || !result->cells || !job.scratch ||
+        join_header(result, left, left_first, 0) != 0 ||
+        join_header(result, right, right_first, left->num_cols) != 0)
+    {
+        free(rows);
+        free(job.scratch);
+        table_free(result);
+        return NULL;
+    }
+    result->num_rows = job.num_rows + 1;
+    result->pointer_array_capacity = result->num_rows;
+
+    job.rows = rows;
+    job.result = result;
+    thread_pool_run(num_threads, copy_join_task, &job, num_blocks);
+
+    // as strings copiadas passam para a arena da tabela nova
+    for (size_t b = 0; b < num_blocks; b++)
+    {
+        if (!job.scratch[b])
+            error = true;
+        else
+            arena_attach(result, arena_detach(job.scratch[b]));
+        table_free(job.scratch[b]);
+    }
+
+    free(rows);
+    free(job.scratch);
+    if (error)
+    {
+        table_free(result);
+        return NULL;
+    }
+    return result;
+}
@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "table.h"
+#include "table_internal.h"
+
+// Pipeline de filtragem em streaming (table_filter_csv)
+//
+// leitura --> [fila] --> filtro --> [fila] --> escrita
+//
+// cada etapa corre numa thread e as etapas trocam lotes de linhas (pequenas tabelas com
+// no máximo LOAD_BUFFER_SIZE bytes de células) através de filas limitadas
+// em memória estão no máximo PIPELINE_QUEUE_DEPTH lotes por fila, independentemente do
+// tamanho do ficheiro
+
+// fila limitada de lotes entre duas etapas
+// um lote NULL indica o fim dos dados
+struct batch_queue
+{
+    struct table *items[PIPELINE_QUEUE_DEPTH];
+    size_t head;
+    size_t count;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+};
+
+// estado partilhado pelas etapas do pipeline
+struct pipeline
+{
+    int src_fd;
+    struct csv_writer dest;
+    bool (*predicate)(const void *row, const void *context);
+    const void *context;
+    struct batch_queue to_filter;
+    struct batch_queue to_writer;
+    bool read_error;
+    long rows_written;
+};
+
+static void queue_init(struct batch_queue *q)
+{
+    q->head = 0;
+    q->count = 0;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+}
+
+static void queue_destroy(struct batch_queue *q)
+{
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+}
+
+// colocar um lote na fila (bloqueia enquanto a fila estiver cheia)
+static void queue_push(struct batch_queue *q, struct table *batch)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->count == PIPELINE_QUEUE_DEPTH)
+        pthread_cond_wait(&q->not_full, &q->lock);
+
+    q->items[(q->head + q->count) % PIPELINE_QUEUE_DEPTH] = batch;
+    q->count++;
+
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// retirar um lote da fila (bloqueia enquanto a fila estiver vazia)
+static struct table *queue_pop(struct batch_queue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0)
+        pthread_cond_wait(&q->not_empty, &q->lock);
+
+    struct table *batch = q->items[q->head];
+    q->head = (q->head + 1) % PIPELINE_QUEUE_DEPTH;
+    q->count--;
+
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+
+    return batch;
+}
+
+// etapa de leitura: lê o ficheiro em blocos e transforma cada bloco num lote de linhas
+static void *reader_stage(void *arg)
+{
+    struct pipeline *pl = (struct pipeline *)arg;
+    size_t capacity = LOAD_BUFFER_SIZE;
+    char *buf = malloc(capacity);
+    size_t valid = 0;
+    size_t num_cols = 0; // definido pelo cabeçalho, no primeiro lote
+
+    if (!buf)
+        pl->read_error = true;
+
+    while (!pl->read_error)
+    {
+        // uma linha maior que o buffer: duplicar o buffer
+        if (valid == capacity)
+        {
+            char *new_buf = realloc(buf, capacity * 2);
+            if (!new_buf)
+            {
+                pl->read_error = true;
+                break;
+            }
+            buf = new_buf;
+            capacity *= 2;
+        }
+
+        ssize_t bytes_read = read(pl->src_fd, buf + valid, capacity - valid);
+        if (bytes_read < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            pl->read_error = true;
+            break;
+        }
+
+        bool eof = (bytes_read == 0);
+        valid += bytes_read;
+
+        struct table *batch = table_create(num_cols);
+        if (!batch)
+        {
+            pl->read_error = true;
+            break;
+        }
+
+        ssize_t used = load_rows(batch, buf, buf + valid, false, eof, NULL);
+        if (used < 0)
+        {
+            table_free(batch);
+            pl->read_error = true;
+            break;
+        }
+
+        memmove(buf, buf + used, valid - used);
+        valid -= used;
+        num_cols = batch->num_cols;
+
+        if (batch->num_rows > 0)
+            queue_push(&pl->to_filter, batch);
+        else
+            table_free(batch);
+
+        if (eof)
+            break;
+    }
+
+    free(buf);
+    queue_push(&pl->to_filter, NULL);
+    return NULL;
+}
+
+// função auxiliar para manter no lote só as linhas que satisfazem o predicado
+// as linhas aceites são compactadas no início da matriz do próprio lote (sem copiar células)
+static void filter_batch(struct pipeline *pl, struct table *batch)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < batch->num_rows; i++)
+    {
+        char **row = table_row(batch, i);
+        if (pl->predicate((const void *)row, pl->context))
+        {
+            if (kept != i)
+                memcpy(table_row(batch, kept), row, batch->num_cols * sizeof(char *));
+            kept++;
+        }
+    }
+    batch->num_rows = kept;
+}
+
+// etapa de filtragem
+static void *filter_stage(void *arg)
+{
+    struct pipeline *pl = (struct pipeline *)arg;
+    struct table *batch;
+
+    while ((batch = queue_pop(&pl->to_filter)) != NULL)
+    {
+        filter_batch(pl, batch);
+        queue_push(&pl->to_writer, batch);
+    }
+
+    queue_push(&pl->to_writer, NULL);
+    return NULL;
+}
+
+// função para filtrar um ficheiro CSV diretamente para outro, sem carregar a tabela
+// o resultado é igual a table_load_csv + table_filter + table_save_csv
+long table_filter_csv(const char *src_file, const char *dest_file,
+                      bool (*predicate)(const void *row, const void *context),
+                      const void *context)
+{
+    struct pipeline pl;
+    pl.src_fd = open(src_file, O_RDONLY);
+    if (pl.src_fd < 0)
+        return -1;
+
+    int dest_fd = open(dest_file, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (dest_fd < 0)
+    {
+        close(pl.src_fd);
+        return -1;
+    }
+    if (csv_writer_init(&pl.dest, dest_fd) != 0)
+    {
+        close(dest_fd);
+        close(pl.src_fd);
+        return -1;
+    }
+
+    pl.predicate = predicate;
+    pl.context = context;
+    pl.read_error = false;
+    pl.rows_written = 0;
+    queue_init(&pl.to_filter);
+    queue_init(&pl.to_writer);
+
+    // as etapas de leitura e filtragem correm em threads próprias
+    // a escrita é feita pela thread que chamou
+    pthread_t reader_thread, filter_thread;
+    if (pthread_create(&reader_thread, NULL, reader_stage, &pl) != 0)
+    {
+        queue_destroy(&pl.to_filter);
+        queue_destroy(&pl.to_writer);
+        close(pl.src_fd);
+        csv_writer_free(&pl.dest);
+        close(dest_fd);
+        return -1;
+    }
+
+    // se não for possível criar a thread de filtragem, a filtragem é feita junto com a escrita
+    bool filter_started = pthread_create(&filter_thread, NULL, filter_stage, &pl) == 0;
+    struct batch_queue *input = filter_started ? &pl.to_writer : &pl.to_filter;
+
+    // etapa de escrita
+    struct table *batch;
+    while ((batch = queue_pop(input)) != NULL)
+    {
+        if (!filter_started)
+            filter_batch(&pl, batch);
+
+        csv_writer_rows(&pl.dest, batch, 0, batch->num_rows);
+        pl.rows_written += batch->num_rows;
+        table_free(batch);
+    }
+
+    pthread_join(reader_thread, NULL);
+    if (filter_started)
+        pthread_join(filter_thread, NULL);
+
+    queue_destroy(&pl.to_filter);
+    queue_destroy(&pl.to_writer);
+    close(pl.src_fd);
+
+    bool write_error = csv_writer_flush(&pl.dest) != 0;
+    csv_writer_free(&pl.dest);
+    if (close(dest_fd) != 0)
+        write_error = true;
+
+    if (pl.read_error || write_error)
+        return -1;
+
+    return pl.rows_written;
+}
@@ -0,0 +1,398 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "table.h"
+#include "table_internal.h"
+#include "thread_pool.h"
+
+// Snapshots binários (table_save_snapshot / table_load_snapshot)
+//
+// formato do ficheiro (valores na ordem de bytes da máquina, secções alinhadas à página):
+//
+//   [cabeçalho]  página 0: struct snapshot_header (o resto da página fica a zeros)
+//   [offsets]    num_rows * num_cols uint64_t, linha a linha: posição de cada célula no heap
+//                (SNAPSHOT_NULL_CELL para as células NULL)
+//   [heap]       as strings das células, terminadas com '\0'
+//
+// ao carregar, o ficheiro é mapeado em memória e as células apontam diretamente para o heap:
+// não há parsing, só a validação (checksums, em paralelo) e a conversão dos offsets em ponteiros
+// cada secção tem um checksum, calculado por blocos de SNAPSHOT_BLOCK_SIZE bytes
+
+#define SNAPSHOT_MAGIC "TBLSNAP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+#define SNAPSHOT_PAGE_SIZE 4096
+#define SNAPSHOT_BLOCK_SIZE (1024 * 1024)
+#define SNAPSHOT_NULL_CELL UINT64_MAX
+
+struct snapshot_header
+{
+    char magic[8];             // SNAPSHOT_MAGIC
+    uint32_t version;          // SNAPSHOT_VERSION
+    uint32_t byte_order;       // SNAPSHOT_BYTE_ORDER, escrito com a ordem de bytes da máquina
+    uint64_t num_rows;
+    uint64_t num_cols;
+    uint64_t offsets_pos;      // posição da secção de offsets no ficheiro
+    uint64_t heap_pos;         // posição do heap no ficheiro
+    uint64_t heap_size;
+    uint64_t offsets_checksum;
+    uint64_t heap_checksum;
+    uint64_t header_checksum;  // checksum dos campos anteriores (tem de ser o último campo)
+};
+
+#define CHECKSUM_PRIME1 0x9E3779B185EBCA87ull
+#define CHECKSUM_PRIME2 0xC2B2AE3D27D4EB4Full
+
+// função auxiliar para misturar uma palavra no estado do checksum
+static inline uint64_t checksum_round(uint64_t h, uint64_t word)
+{
+    h += word * CHECKSUM_PRIME2;
+    h = (h << 31) | (h >> 33);
+    return h * CHECKSUM_PRIME1;
+}
+
+// função auxiliar para calcular o checksum de um bloco
+// 4 estados independentes, para as multiplicações não ficarem à espera umas das outras
+static uint64_t checksum_block(const char *p, size_t len)
+{
+    uint64_t h[4] = {1, 2, 3, 4};
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            uint64_t word;
+            memcpy(&word, p + i + 8 * k, sizeof(word));
+            h[k] = checksum_round(h[k], word);
+        }
+    }
+
+    uint64_t result = checksum_round(checksum_round(h[0], h[1]), checksum_round(h[2], h[3]));
+    for (; i < len; i++)
+        result = checksum_round(result, (unsigned char)p[i]);
+
+    return checksum_round(result, len);
+}
+
+// função auxiliar para escrever o buffer todo na posição pos de fd
+static int pwrite_all(int fd, const char *buf, size_t len, off_t pos)
+{
+    while (len > 0)
+    {
+        ssize_t n = pwrite(fd, buf, len, pos);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+        pos += n;
+    }
+    return 0;
+}
+
+// secção do ficheiro a ser escrita: um buffer de SNAPSHOT_BLOCK_SIZE bytes, escrito (e
+// somado ao checksum) sempre que enche, para os blocos coincidirem com os da leitura
+struct snapshot_section
+{
+    int fd;
+    off_t pos;         // posição do próximo bloco no ficheiro
+    char *buf;
+    size_t len;
+    uint64_t size;     // bytes escritos na secção
+    uint64_t checksum;
+    bool error;
+};
+
+static int section_init(struct snapshot_section *s, int fd, off_t pos)
+{
+    s->fd = fd;
+    s->pos = pos;
+    s->len = 0;
+    s->size = 0;
+    s->checksum = 0;
+    s->error = false;
+    s->buf = malloc(SNAPSHOT_BLOCK_SIZE);
+    return s->buf ? 0 : -1;
+}
+
+static void section_flush(struct snapshot_section *s)
+{
+    if (s->len == 0)
+        return;
+
+    s->checksum = checksum_round(s->checksum, checksum_block(s->buf, s->len));
+    if (!s->error && pwrite_all(s->fd, s->buf, s->len, s->pos) != 0)
+        s->error = true;
+    s->pos += s->len;
+    s->len = 0;
+}
+
+static void section_put(struct snapshot_section *s, const void *data, size_t n)
+{
+    const char *p = (const char *)data;
+    s->size += n;
+
+    while (n > 0)
+    {
+        size_t chunk = SNAPSHOT_BLOCK_SIZE - s->len;
+        if (chunk > n)
+            chunk = n;
+        memcpy(s->buf + s->len, p, chunk);
+        s->len += chunk;
+        p += chunk;
+        n -= chunk;
+
+        if (s->len == SNAPSHOT_BLOCK_SIZE)
+            section_flush(s);
+    }
+}
+
+static uint64_t align_to_page(uint64_t pos)
+{
+    return (pos + SNAPSHOT_PAGE_SIZE - 1) & ~(uint64_t)(SNAPSHOT_PAGE_SIZE - 1);
+}
+
+// função para guardar a tabela num snapshot binário
+long table_save_snapshot(const struct table *table, const char *filename)
+{
+    if (table_flush_deletes(table) != 0)
+        return -1;
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+        return -1;
+
+    struct snapshot_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.num_rows = table->num_rows;
+    header.num_cols = table->num_cols;
+    header.offsets_pos = SNAPSHOT_PAGE_SIZE;
+    header.heap_pos = align_to_page(header.offsets_pos + header.num_rows * header.num_cols * sizeof(uint64_t));
+
+    // as duas secções são escritas ao mesmo tempo, cada uma com o seu buffer
+    struct snapshot_section offsets, heap;
+    int result = -1;
+    const struct table *base = table->source ? table->source : table;
+    if (section_init(&offsets, fd, header.offsets_pos) == 0)
+    {
+        if (section_init(&heap, fd, header.heap_pos) == 0)
+        {
+            for (size_t i = 0; i < table->num_rows; i++)
+            {
+                char **row = table_row(table, i);
+                for (size_t j = 0; j < table->num_cols; j++)
+                {
+                    uint64_t offset = SNAPSHOT_NULL_CELL;
+                    if (row[j] && cell_is_view(base, row[j]))
+                    {
+                        // célula vista sobre o ficheiro mapeado: o campo é escrito sem ser copiado
+                        offset = heap.size;
+                        section_put(&heap, row[j], cell_view_length(base, row[j]));
+                        section_put(&heap, "", 1);
+                    }
+                    else if (row[j])
+                    {
+                        offset = heap.size;
+                        section_put(&heap, row[j], strlen(row[j]) + 1);
+                    }
+                    section_put(&offsets, &offset, sizeof(offset));
+                }
+            }
+            section_flush(&offsets);
+            section_flush(&heap);
+
+            header.heap_size = heap.size;
+            header.offsets_checksum = offsets.checksum;
+            header.heap_checksum = heap.checksum;
+            header.header_checksum = checksum_block((const char *)&header,
+                                                    offsetof(struct snapshot_header, header_checksum));
+
+            // o cabeçalho é escrito por último: um snapshot interrompido não tem cabeçalho válido
+            char page[SNAPSHOT_PAGE_SIZE];
+            memset(page, 0, sizeof(page));
+            memcpy(page, &header, sizeof(header));
+            if (!offsets.error && !heap.error && pwrite_all(fd, page, sizeof(page), 0) == 0)
+                result = 0;
+
+            free(heap.buf);
+        }
+        free(offsets.buf);
+    }
+
+    if (close(fd) != 0)
+        result = -1;
+
+    return result == 0 ? (long)(header.heap_pos + header.heap_size) : -1;
+}
+
+// estado partilhado pelas threads que validam o snapshot
+struct snapshot_check
+{
+    const char *map;
+    const struct snapshot_header *header;
+    size_t offsets_blocks;  // número de blocos da secção de offsets (os do heap vêm a seguir)
+    uint64_t *block_checksums;
+    char **cells;           // matriz de células da tabela, preenchida a partir dos offsets
+    int invalid;            // algum offset aponta para fora do heap
+};
+
+// função auxiliar para converter os offsets de um bloco em ponteiros para o heap
+static void convert_offsets(struct snapshot_check *check, const uint64_t *offsets, size_t first, size_t count)
+{
+    const struct snapshot_header *h = check->header;
+    const char *heap = check->map + h->heap_pos;
+
+    for (size_t k = first; k < first + count; k++)
+    {
+        if (offsets[k] == SNAPSHOT_NULL_CELL)
+            check->cells[k] = NULL;
+        else if (offsets[k] < h->heap_size)
+            check->cells[k] = (char *)heap + offsets[k];
+        else
+        {
+            __atomic_store_n(&check->invalid, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+}
+
+static void check_block_task(void *arg, size_t index)
+{
+    struct snapshot_check *check = (struct snapshot_check *)arg;
+    const struct snapshot_header *h = check->header;
+    uint64_t pos = h->offsets_pos;
+    uint64_t size = h->num_rows * h->num_cols * sizeof(uint64_t);
+    size_t block = index;
+
+    if (index >= check->offsets_blocks)
+    {
+        pos = h->heap_pos;
+        size = h->heap_size;
+        block = index - check->offsets_blocks;
+    }
+
+    uint64_t begin = (uint64_t)block * SNAPSHOT_BLOCK_SIZE;
+    uint64_t len = size - begin < SNAPSHOT_BLOCK_SIZE ? size - begin : SNAPSHOT_BLOCK_SIZE;
+    check->block_checksums[index] = checksum_block(check->map + pos + begin, len);
+
+    // os blocos de offsets são também convertidos, enquanto ainda estão na cache
+    if (index < check->offsets_blocks)
+        convert_offsets(check, (const uint64_t *)(check->map + pos), begin / sizeof(uint64_t),
+                        len / sizeof(uint64_t));
+}
+
+// função auxiliar para validar o cabeçalho contra o tamanho do ficheiro
+static bool header_valid(const struct snapshot_header *h, uint64_t file_size)
+{
+    if (memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic)) != 0 || h->version != SNAPSHOT_VERSION ||
+        h->byte_order != SNAPSHOT_BYTE_ORDER)
+        return false;
+
+    if (h->header_checksum != checksum_block((const char *)h, offsetof(struct snapshot_header, header_checksum)))
+        return false;
+
+    if (h->num_cols > MAX_COLS || h->num_rows > file_size / sizeof(uint64_t))
+        return false;
+
+    uint64_t offsets_size = h->num_rows * h->num_cols * sizeof(uint64_t);
+    return h->offsets_pos >= sizeof(struct snapshot_header) && h->offsets_pos <= file_size &&
+           offsets_size <= file_size - h->offsets_pos && h->heap_pos >= h->offsets_pos + offsets_size &&
+           h->heap_pos <= file_size && h->heap_size <= file_size - h->heap_pos;
+}
+
+// função auxiliar para somar os checksums dos blocos de uma secção (pela ordem dos blocos)
+static uint64_t combine_checksums(const uint64_t *blocks, size_t count)
+{
+    uint64_t checksum = 0;
+    for (size_t k = 0; k < count; k++)
+        checksum = checksum_round(checksum, blocks[k]);
+    return checksum;
+}
+
+// função para carregar uma tabela a partir de um snapshot binário
+struct table *table_load_snapshot(const char *filename, int num_threads)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < SNAPSHOT_PAGE_SIZE)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // as strings nunca são alteradas: o mapeamento pode ser só de leitura
+    char *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    const struct snapshot_header *h = (const struct snapshot_header *)map;
+    if (!header_valid(h, st.st_size))
+    {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    // validar os checksums e converter os offsets em ponteiros, um bloco por tarefa
+    uint64_t offsets_size = h->num_rows * h->num_cols * sizeof(uint64_t);
+    struct snapshot_check check;
+    check.map = map;
+    check.header = h;
+    check.offsets_blocks = (offsets_size + SNAPSHOT_BLOCK_SIZE - 1) / SNAPSHOT_BLOCK_SIZE;
+    size_t heap_blocks = (h->heap_size + SNAPSHOT_BLOCK_SIZE - 1) / SNAPSHOT_BLOCK_SIZE;
+    size_t num_cells = offsets_size / sizeof(uint64_t);
+    check.block_checksums = malloc((check.offsets_blocks + heap_blocks + 1) * sizeof(uint64_t));
+    struct table *t = table_create(h->num_cols);
+    char **cells = malloc((num_cells ? num_cells : 1) * sizeof(char *));
+    if (!check.block_checksums || !t || !cells)
+    {
+        free(check.block_checksums);
+        free(cells);
+        table_free(t);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    t->map_addr = map;
+    t->map_size = st.st_size;
+
+    // o heap tem de acabar numa string terminada: assim nenhuma célula passa do fim do heap
+    bool valid = h->heap_size == 0 || map[h->heap_pos + h->heap_size - 1] == '\0';
+
+    check.cells = cells;
+    check.invalid = 0;
+    if (valid)
+        thread_pool_run(num_threads, check_block_task, &check, check.offsets_blocks + heap_blocks);
+
+    valid = valid && !check.invalid &&
+            combine_checksums(check.block_checksums, check.offsets_blocks) == h->offsets_checksum &&
+            combine_checksums(check.block_checksums + check.offsets_blocks, heap_blocks) == h->heap_checksum;
+    free(check.block_checksums);
+
+    t->cells = cells;
+    if (!valid)
+    {
+        table_free(t);
+        return NULL;
+    }
+
+    t->num_rows = h->num_rows;
+    t->pointer_array_capacity = h->num_rows;
+
+    return t;
+}
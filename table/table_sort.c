@@ -0,0 +1,587 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "table.h"
+#include "table_internal.h"
+#include "thread_pool.h"
+
+// Ordenação (table_sort)
+//
+// cada linha dá um registo com uma chave de 64 bits, tirada da primeira coluna de ordenação, que
+// se ordena como um inteiro sem sinal: os números passam por uma transformação que mantém a ordem
+// e as strings dão os seus primeiros 8 bytes; as linhas sem valor ficam com a chave máxima (no fim)
+// os registos são divididos em partes ordenadas em paralelo por radix sort (LSD, 8 bits de cada
+// vez, estável) e as partes são depois juntadas duas a duas, também em paralelo
+// nos grupos de registos com a mesma chave, se a chave for o valor todo (números, strings com
+// menos de 8 bytes) o grupo é ordenado da mesma forma pela chave da coluna seguinte; se não for
+// (strings com os mesmos 8 primeiros bytes), pela chave dos 8 bytes seguintes da mesma string
+// os empates totais ficam pela ordem original
+
+// Registo ordenado: chave de uma coluna de ordenação (a primeira, fora dos grupos de empates) e
+// linha da tabela
+struct sort_record
+{
+    uint64_t key;
+    uint32_t row;
+};
+
+// Coluna de ordenação já resolvida
+struct sort_column
+{
+    size_t col;
+    bool descending;
+    bool numeric;
+    bool check;                     // SORT_AUTO: ainda falta confirmar que as células são números
+    const struct column_info *info; // coluna com tipo numérico inferido (ou NULL)
+};
+
+struct sort_job
+{
+    const struct table *table;
+    struct sort_column *keys;
+    size_t num_keys;
+    size_t first; // primeira linha ordenada (1 se o cabeçalho fica no lugar)
+    size_t count; // número de linhas ordenadas
+
+    struct sort_record *records;
+    struct sort_record *tmp;
+    int *not_numeric; // por coluna: apareceu uma célula que não é número (colunas a confirmar)
+
+    size_t chunk_rows; // linhas de cada tarefa da extração e da cópia das linhas
+    size_t num_runs;   // partes ordenadas separadamente (potência de 2)
+    size_t width;      // partes já juntadas em cada lado da junção atual
+    const struct sort_record *src;
+    struct sort_record *dst;
+
+    // aplicação da nova ordem
+    const uint32_t *order;
+    char **cells;
+};
+
+// função auxiliar para obter o valor numérico da célula (falso se a célula não tiver número)
+static bool cell_number(const struct sort_job *job, const struct sort_column *k, size_t row, double *value)
+{
+    if (k->info)
+        return column_number(k->info, table_physical_row(job->table, row), value);
+
+    const char *cell = table_row(job->table, row)[k->col];
+    return cell && parse_number(cell, value);
+}
+
+// chave de 64 bits de um double, com a mesma ordem (os negativos têm os bits todos trocados)
+static uint64_t double_key(double value)
+{
+    if (value == 0)
+        value = 0; // -0 e 0 ficam iguais
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits >> 63) ? ~bits : bits | ((uint64_t)1 << 63);
+}
+
+// chave de 64 bits dos primeiros 8 bytes de uma string (big-endian, com zeros no fim)
+static uint64_t string_key(const char *s)
+{
+    uint64_t key = 0;
+    int i = 0;
+    for (; i < 8 && s[i]; i++)
+        key = key << 8 | (unsigned char)s[i];
+    return key << (8 * (8 - i));
+}
+
+// função auxiliar para calcular a chave da coluna de ordenação level de uma linha
+static uint64_t row_key(const struct sort_job *job, size_t level, size_t row)
+{
+    const struct sort_column *k = &job->keys[level];
+    uint64_t key;
+
+    if (k->numeric)
+    {
+        if (k->info && k->info->type == COLUMN_INT64)
+        {
+            size_t phys = table_physical_row(job->table, row);
+            if (k->info->nulls[phys / 64] >> (phys % 64) & 1)
+                return UINT64_MAX;
+            key = (uint64_t)k->info->values[phys].i ^ ((uint64_t)1 << 63);
+        }
+        else
+        {
+            double value;
+            if (!cell_number(job, k, row, &value))
+                return UINT64_MAX;
+            key = double_key(value);
+        }
+    }
+    else
+    {
+        const char *cell = table_row(job->table, row)[k->col];
+        if (!cell)
+            return UINT64_MAX;
+        key = string_key(cell);
+    }
+
+    return k->descending ? ~key : key;
+}
+
+// função auxiliar para comparar duas linhas numa coluna (as linhas sem valor ficam no fim)
+static int compare_cells(const struct sort_job *job, const struct sort_column *k, size_t a, size_t b)
+{
+    int cmp;
+    if (k->numeric)
+    {
+        if (k->info && k->info->type == COLUMN_INT64)
+        {
+            size_t pa = table_physical_row(job->table, a);
+            size_t pb = table_physical_row(job->table, b);
+            bool has_a = !(k->info->nulls[pa / 64] >> (pa % 64) & 1);
+            bool has_b = !(k->info->nulls[pb / 64] >> (pb % 64) & 1);
+            if (!has_a || !has_b)
+                return has_a == has_b ? 0 : has_a ? -1 : 1;
+            int64_t x = k->info->values[pa].i, y = k->info->values[pb].i;
+            cmp = (x > y) - (x < y);
+        }
+        else
+        {
+            double x, y;
+            bool has_a = cell_number(job, k, a, &x);
+            bool has_b = cell_number(job, k, b, &y);
+            if (!has_a || !has_b)
+                return has_a == has_b ? 0 : has_a ? -1 : 1;
+            cmp = (x > y) - (x < y);
+        }
+    }
+    else
+    {
+        const char *x = table_row(job->table, a)[k->col];
+        const char *y = table_row(job->table, b)[k->col];
+        if (!x || !y)
+            return (x != NULL) == (y != NULL) ? 0 : x ? -1 : 1;
+        cmp = strcmp(x, y);
+    }
+
+    return k->descending ? -cmp : cmp;
+}
+
+// função auxiliar para calcular a chave dos 8 bytes a partir de offset da string da coluna level
+// (a string tem pelo menos offset bytes)
+static uint64_t string_tail_key(const struct sort_job *job, size_t level, size_t row, size_t offset)
+{
+    const struct sort_column *k = &job->keys[level];
+    uint64_t key = string_key(table_row(job->table, row)[k->col] + offset);
+    return k->descending ? ~key : key;
+}
+
+// função auxiliar para testar se a chave da coluna level (dos bytes a partir de offset, nas
+// strings) é o valor todo: números e strings que acabam nesses 8 bytes; a primeira chave máxima
+// pode ser de uma linha sem valor ou não, por isso não é
+static bool key_is_exact(const struct sort_job *job, size_t level, size_t offset, uint64_t key)
+{
+    const struct sort_column *k = &job->keys[level];
+    if (key == UINT64_MAX && offset == 0)
+        return false;
+    if (k->numeric)
+        return true;
+    return ((k->descending ? ~key : key) & 0xff) == 0;
+}
+
+// função auxiliar para comparar dois registos com chaves da coluna level (as colunas anteriores
+// são iguais): a chave, depois as colunas a partir de level (se a chave não decidir sozinha) e
+// por fim a linha, para a ordenação ser estável
+static int compare_records(const struct sort_job *job, size_t level, const struct sort_record *a,
+                           const struct sort_record *b)
+{
+    if (a->key != b->key)
+        return a->key < b->key ? -1 : 1;
+
+    for (size_t k = key_is_exact(job, level, 0, a->key) ? level + 1 : level; k < job->num_keys; k++)
+    {
+        int cmp = compare_cells(job, &job->keys[k], a->row, b->row);
+        if (cmp != 0)
+            return cmp;
+    }
+
+    return a->row < b->row ? -1 : (a->row > b->row);
+}
+
+// função auxiliar para juntar as sequências ordenadas a[0, na) e b[0, nb) em out
+static void merge_records(const struct sort_job *job, size_t level, const struct sort_record *a, size_t na,
+                          const struct sort_record *b, size_t nb, struct sort_record *out)
+{
+    size_t i = 0, j = 0, w = 0;
+    while (i < na && j < nb)
+        out[w++] = compare_records(job, level, &b[j], &a[i]) < 0 ? b[j++] : a[i++];
+    memcpy(out + w, a + i, (na - i) * sizeof(struct sort_record));
+    memcpy(out + w + (na - i), b + j, (nb - j) * sizeof(struct sort_record));
+}
+
+// função auxiliar para ordenar records[0, n) com compare_records (merge sort; tmp com n posições)
+static void merge_sort_records(const struct sort_job *job, size_t level, struct sort_record *records,
+                               struct sort_record *tmp, size_t n)
+{
+    if (n <= 16)
+    {
+        // inserção, para as sequências pequenas
+        for (size_t i = 1; i < n; i++)
+        {
+            struct sort_record r = records[i];
+            size_t j = i;
+            while (j > 0 && compare_records(job, level, &r, &records[j - 1]) < 0)
+            {
+                records[j] = records[j - 1];
+                j--;
+            }
+            records[j] = r;
+        }
+        return;
+    }
+
+    size_t half = n / 2;
+    merge_sort_records(job, level, records, tmp, half);
+    merge_sort_records(job, level, records + half, tmp + half, n - half);
+    if (compare_records(job, level, &records[half - 1], &records[half]) <= 0)
+        return;
+
+    memcpy(tmp, records, n * sizeof(struct sort_record));
+    merge_records(job, level, tmp, half, tmp + half, n - half, records);
+}
+
+// função auxiliar para ordenar records[0, n) pela chave, por radix sort (LSD, estável; tmp com
+// n posições)
+static void radix_sort_records(struct sort_record *records, struct sort_record *tmp, size_t n)
+{
+    struct sort_record *src = records;
+    struct sort_record *dst = tmp;
+
+    // os histogramas dos 8 bytes da chave são contados numa só passagem
+    size_t counts[8][256] = {{0}};
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t key = src[i].key;
+        for (int d = 0; d < 8; d++)
+            counts[d][key >> (8 * d) & 0xff]++;
+    }
+
+    for (int d = 0; d < 8; d++)
+    {
+        // todos os registos com o mesmo byte: a passagem não mudaria nada
+        if (n == 0 || counts[d][src[0].key >> (8 * d) & 0xff] == n)
+            continue;
+
+        size_t pos = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            size_t c = counts[d][b];
+            counts[d][b] = pos;
+            pos += c;
+        }
+        for (size_t i = 0; i < n; i++)
+            dst[counts[d][src[i].key >> (8 * d) & 0xff]++] = src[i];
+
+        struct sort_record *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    // o resultado tem de ficar em records
+    if (src != records)
+        memcpy(records, src, n * sizeof(struct sort_record));
+}
+
+// função auxiliar para ordenar os grupos de registos com a mesma chave da coluna level (dos bytes
+// a partir de offset, nas strings); records já está ordenado por essa chave e cada grupo pela
+// ordem das linhas
+static void sort_ties(const struct sort_job *job, size_t level, size_t offset, struct sort_record *records,
+                      struct sort_record *tmp, size_t n)
+{
+    for (size_t i = 0; i < n;)
+    {
+        uint64_t key = records[i].key;
+        size_t j = i + 1;
+        while (j < n && records[j].key == key)
+            j++;
+
+        if (j - i < 2)
+        {
+            i = j;
+            continue;
+        }
+
+        if (key_is_exact(job, level, offset, key))
+        {
+            // ordenar o grupo pela chave da coluna seguinte
+            if (level + 1 < job->num_keys)
+            {
+                for (size_t r = i; r < j; r++)
+                    records[r].key = row_key(job, level + 1, records[r].row);
+                radix_sort_records(records + i, tmp + i, j - i);
+                sort_ties(job, level + 1, 0, records + i, tmp + i, j - i);
+            }
+        }
+        else if (!job->keys[level].numeric && (offset > 0 || key != UINT64_MAX))
+        {
+            // strings com os mesmos 8 bytes (nenhum é o fim): ordenar pelos 8 bytes seguintes
+            for (size_t r = i; r < j; r++)
+                records[r].key = string_tail_key(job, level, records[r].row, offset + 8);
+            radix_sort_records(records + i, tmp + i, j - i);
+            sort_ties(job, level, offset + 8, records + i, tmp + i, j - i);
+        }
+        else
+        {
+            // linhas sem valor (ou com a chave máxima): comparar as células
+            merge_sort_records(job, level, records + i, tmp + i, j - i);
+        }
+
+        // repor a chave deste nível
+        for (size_t r = i; r < j; r++)
+            records[r].key = key;
+        i = j;
+    }
+}
+
+// tarefa: calcular os registos de um bloco de linhas e confirmar as colunas SORT_AUTO
+static void extract_task(void *arg, size_t index)
+{
+    struct sort_job *job = (struct sort_job *)arg;
+    size_t begin = index * job->chunk_rows;
+    size_t end = begin + job->chunk_rows;
+    if (end > job->count)
+        end = job->count;
+
+    const struct sort_column *first = &job->keys[0];
+    for (size_t i = begin; i < end; i++)
+    {
+        size_t row = job->first + i;
+        job->records[i].key = row_key(job, 0, row);
+        job->records[i].row = (uint32_t)row;
+
+        // a primeira coluna é confirmada com a própria chave: só as linhas sem número são vistas
+        if (first->check && job->records[i].key == UINT64_MAX)
+        {
+            const char *cell = table_row(job->table, row)[first->col];
+            double value;
+            if (cell && !is_blank(cell) && !parse_number(cell, &value))
+                __atomic_store_n(&job->not_numeric[0], 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    for (size_t k = 1; k < job->num_keys; k++)
+    {
+        const struct sort_column *key = &job->keys[k];
+        if (!key->check)
+            continue;
+
+        for (size_t i = begin; i < end; i++)
+        {
+            const char *cell = table_row(job->table, job->first + i)[key->col];
+            double value;
+            if (cell && !is_blank(cell) && !parse_number(cell, &value))
+            {
+                __atomic_store_n(&job->not_numeric[k], 1, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+    }
+}
+
+// função auxiliar para calcular o início da parte run
+static size_t run_start(const struct sort_job *job, size_t run)
+{
+    return run * job->count / job->num_runs;
+}
+
+// tarefa: ordenar uma parte dos registos por radix sort e resolver os empates de chave
+static void run_sort_task(void *arg, size_t run)
+{
+    struct sort_job *job = (struct sort_job *)arg;
+    size_t begin = run_start(job, run);
+    size_t n = run_start(job, run + 1) - begin;
+
+    radix_sort_records(job->records + begin, job->tmp + begin, n);
+    sort_ties(job, 0, 0, job->records + begin, job->tmp + begin, n);
+}
+
+// tarefa: juntar duas partes vizinhas (cada uma com job->width partes já juntadas)
+static void merge_task(void *arg, size_t index)
+{
+    struct sort_job *job = (struct sort_job *)arg;
+    size_t a = run_start(job, 2 * index * job->width);
+    size_t b = run_start(job, (2 * index + 1) * job->width);
+    size_t end = run_start(job, (2 * index + 2) * job->width);
+
+    merge_records(job, 0, job->src + a, b - a, job->src + b, end - b, job->dst + a);
+}
+
+// tarefa: copiar os ponteiros das linhas de um bloco pela nova ordem
+static void copy_rows_task(void *arg, size_t index)
+{
+    struct sort_job *job = (struct sort_job *)arg;
+    const struct table *table = job->table;
+    size_t begin = index * job->chunk_rows;
+    size_t end = begin + job->chunk_rows;
+    if (end > table->num_rows)
+        end = table->num_rows;
+
+    for (size_t i = begin; i < end; i++)
+        memcpy(job->cells + i * table->num_cols, table->cells + job->order[i] * table->num_cols,
+               table->num_cols * sizeof(char *));
+}
+
+// função auxiliar para decidir se as colunas SORT_AUTO são numéricas: as colunas com tipo
+// numérico inferido são; as outras só se todas as células de uma amostra forem números (e
+// a extração confirma depois as restantes)
+static void resolve_keys(struct sort_job *job, const struct table_sort_key *keys)
+{
+    const struct table *base = job->table->source ? job->table->source : job->table;
+
+    for (size_t k = 0; k < job->num_keys; k++)
+    {
+        struct sort_column *key = &job->keys[k];
+        key->col = keys[k].col;
+        key->descending = keys[k].descending;
+        key->numeric = keys[k].type == SORT_NUMERIC;
+        key->check = false;
+
+        const struct column_info *info = base->columns ? &base->columns[key->col] : NULL;
+        key->info = info && info->type != COLUMN_STRING ? info : NULL;
+
+        if (keys[k].type != SORT_AUTO)
+            continue;
+        if (key->info)
+        {
+            key->numeric = true;
+            continue;
+        }
+
+        bool numbers = true;
+        size_t samples = job->count < EXPR_SAMPLE_ROWS ? job->count : EXPR_SAMPLE_ROWS;
+        for (size_t s = 0; s < samples && numbers; s++)
+        {
+            const char *cell = table_row(job->table, job->first + s * job->count / samples)[key->col];
+            double value;
+            numbers = !cell || is_blank(cell) || parse_number(cell, &value);
+        }
+        key->numeric = numbers;
+        key->check = numbers;
+    }
+}
+
+// função auxiliar para aplicar a nova ordem às linhas (order[i]: linha que fica na posição i)
+static int apply_order(struct sort_job *job, struct table *table, uint32_t *order, int num_threads)
+{
+    // numa vista só mudam os índices da seleção (e os índices e tipos criados sobre a vista)
+    if (table->source)
+    {
+        uint32_t *selection = malloc((table->num_rows ? table->num_rows : 1) * sizeof(uint32_t));
+        if (!selection)
+            return -1;
+        for (size_t i = 0; i < table->num_rows; i++)
+            selection[i] = table->selection[order[i]];
+        free(table->selection);
+        table->selection = selection;
+
+        table_columns_permute(table, order);
+        return 0;
+    }
+
+    char **cells = malloc((table->num_rows ? table->num_rows : 1) * table->num_cols * sizeof(char *));
+    if (!cells)
+        return -1;
+
+    job->order = order;
+    job->cells = cells;
+    thread_pool_run(num_threads, copy_rows_task, job, (table->num_rows + job->chunk_rows - 1) / job->chunk_rows);
+
+    free(table->cells);
+    table->cells = cells;
+    table->pointer_array_capacity = table->num_rows;
+
+    table_columns_permute(table, order);
+    return 0;
+}
+
+// função para ordenar as linhas da tabela pelas colunas keys, com num_threads threads
+int table_sort(struct table *table, const struct table_sort_key *keys, size_t num_keys, int num_threads)
+{
+    if (num_keys == 0 || table->num_rows > UINT32_MAX || table_flush_deletes(table) != 0)
+        return -1;
+    uint32_t cols = 0;
+    for (size_t k = 0; k < num_keys; k++)
+    {
+        if (keys[k].col >= table->num_cols)
+            return -1;
+        cols |= 1u << keys[k].col;
+    }
+
+    // as linhas de uma tabela base usada por vistas não podem mudar de posição
+    // (as outras colunas podem continuar a ser vistas: só os ponteiros mudam de linha)
+    if ((!table->source && table->refcount > 1) || table_materialize_columns(table, cols) != 0)
+        return -1;
+
+    struct sort_job job;
+    memset(&job, 0, sizeof(job));
+    job.table = table;
+    job.num_keys = num_keys;
+
+    // o cabeçalho (primeira linha da tabela carregada) fica no lugar
+    job.first = table_has_header(table) ? 1 : 0;
+    job.count = table->num_rows - job.first;
+    job.chunk_rows = SORT_MIN_RUN_ROWS;
+
+    job.keys = malloc(num_keys * sizeof(struct sort_column));
+    job.not_numeric = calloc(num_keys, sizeof(int));
+    job.records = malloc((job.count ? job.count : 1) * sizeof(struct sort_record));
+    job.tmp = malloc((job.count ? job.count : 1) * sizeof(struct sort_record));
+    uint32_t *order = malloc((table->num_rows ? table->num_rows : 1) * sizeof(uint32_t));
+
+    int result = -1;
+    if (job.keys && job.not_numeric && job.records && job.tmp && order)
+    {
+        resolve_keys(&job, keys);
+        size_t num_chunks = (job.count + job.chunk_rows - 1) / job.chunk_rows;
+        thread_pool_run(num_threads, extract_task, &job, num_chunks);
+
+        // uma coluna SORT_AUTO com células que não são números passa a ser ordenada como strings
+        // (as chaves das outras colunas só são calculadas nos grupos de empates)
+        bool first_changed = job.keys[0].check && job.not_numeric[0];
+        for (size_t k = 0; k < num_keys; k++)
+        {
+            if (job.keys[k].check && job.not_numeric[k])
+                job.keys[k].numeric = false;
+            job.keys[k].check = false;
+        }
+        if (first_changed)
+            thread_pool_run(num_threads, extract_task, &job, num_chunks);
+
+        // partes: uma potência de 2, pelo menos uma por thread, com pelo menos SORT_MIN_RUN_ROWS linhas
+        job.num_runs = 1;
+        while ((int)job.num_runs < num_threads && job.count / (job.num_runs * 2) >= SORT_MIN_RUN_ROWS)
+            job.num_runs *= 2;
+        thread_pool_run(num_threads, run_sort_task, &job, job.num_runs);
+
+        // juntar as partes duas a duas, alternando entre records e tmp
+        job.src = job.records;
+        job.dst = job.tmp;
+        for (job.width = 1; job.width < job.num_runs; job.width *= 2)
+        {
+            thread_pool_run(num_threads, merge_task, &job, job.num_runs / (2 * job.width));
+            const struct sort_record *swap = job.src;
+            job.src = job.dst;
+            job.dst = (struct sort_record *)swap;
+        }
+
+        for (size_t i = 0; i < job.first; i++)
+            order[i] = (uint32_t)i;
+        for (size_t i = 0; i < job.count; i++)
+            order[job.first + i] = job.src[i].row;
+
+        result = apply_order(&job, table, order, num_threads);
+    }
+
+    free(order);
+    free(job.tmp);
+    free(job.records);
+    free(job.not_numeric);
+    free(job.keys);
+    return result;
+}
@@ -0,0 +1,241 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include "table.h"
+#include "table_internal.h"
+#include "thread_pool.h"
+
+// Tipos das colunas (table_infer_types)
+//
+// o texto das células nunca é alterado (show e save escrevem exatamente o que foi lido);
+// as colunas numéricas ganham, além do texto, um array com o valor de cada linha e um mapa
+// de bits com as linhas sem valor, para os filtros e agregações não voltarem a converter o texto
+// os arrays são indexados pelas linhas da tabela base: as vistas usam os tipos da tabela de origem
+
+bool is_blank(const char *s)
+{
+    while (isspace((unsigned char)*s))
+        s++;
+    return *s == '\0';
+}
+
+// a célula tem de ser só o número (com espaços opcionais à volta); "nan", "inf", ... não contam
+bool parse_number(const char *s, double *value)
+{
+    const char *p = s;
+    while (isspace((unsigned char)*p))
+        p++;
+
+    const char *digits = (*p == '-' || *p == '+') ? p + 1 : p;
+    if (!isdigit((unsigned char)*digits) && *digits != '.')
+        return false;
+
+    char *end;
+    *value = strtod(p, &end);
+    if (end == p)
+        return false;
+
+    while (isspace((unsigned char)*end))
+        end++;
+    return *end == '\0';
+}
+
+bool parse_int64(const char *s, int64_t *value)
+{
+    const char *p = s;
+    while (isspace((unsigned char)*p))
+        p++;
+
+    const char *digits = (*p == '-' || *p == '+') ? p + 1 : p;
+    if (!isdigit((unsigned char)*digits))
+        return false;
+
+    char *end;
+    errno = 0;
+    long long v = strtoll(p, &end, 10);
+    if (errno == ERANGE)
+        return false;
+
+    while (isspace((unsigned char)*end))
+        end++;
+    if (*end != '\0')
+        return false;
+
+    *value = v;
+    return true;
+}
+
+// função auxiliar para inferir o tipo de uma coluna e preencher os seus valores
+// o tipo é decidido pelas células a seguir ao cabeçalho (linha 0); as células vazias não contam
+// a coluna começa como inteira e passa a double (convertendo os valores já lidos) ou a string
+// quando aparece uma célula que não cabe no tipo atual
+static int infer_column(struct table *table, size_t col)
+{
+    struct column_info *info = &table->columns[col];
+    size_t num_words = (table->num_rows + 63) / 64;
+    enum column_type type = COLUMN_INT64;
+    bool has_values = false;
+
+    union column_value *values = malloc((table->num_rows ? table->num_rows : 1) * sizeof(union column_value));
+    uint64_t *nulls = calloc(num_words ? num_words : 1, sizeof(uint64_t));
+    if (!values || !nulls)
+    {
+        free(values);
+        free(nulls);
+        return -1;
+    }
+
+    for (size_t i = 0; i < table->num_rows && type != COLUMN_STRING; i++)
+    {
+        const char *cell = table_row(table, i)[col];
+        bool ok;
+
+        if (type == COLUMN_INT64)
+        {
+            ok = cell && parse_int64(cell, &values[i].i);
+            if (!ok && cell && parse_number(cell, &values[i].d))
+            {
+                // primeira célula não inteira: os valores anteriores passam a double
+                for (size_t k = 0; k < i; k++)
+                {
+                    if (!(nulls[k / 64] >> (k % 64) & 1))
+                        values[k].d = (double)values[k].i;
+                }
+                type = COLUMN_DOUBLE;
+                ok = true;
+            }
+        }
+        else
+            ok = cell && parse_number(cell, &values[i].d);
+
+        if (ok)
+        {
+            if (i > 0)
+                has_values = true;
+            continue;
+        }
+
+        // o cabeçalho e as células vazias ficam sem valor; qualquer outra célula faz a coluna string
+        nulls[i / 64] |= (uint64_t)1 << (i % 64);
+        if (i > 0 && cell && !is_blank(cell))
+            type = COLUMN_STRING;
+    }
+
+    if (type == COLUMN_STRING || !has_values)
+    {
+        free(values);
+        free(nulls);
+        info->type = COLUMN_STRING;
+        return 0;
+    }
+
+    free(info->values);
+    free(info->nulls);
+    info->type = type;
+    info->values = values;
+    info->nulls = nulls;
+
+    return 0;
+}
+
+struct infer_job
+{
+    struct table *table;
+    int error;
+};
+
+static void infer_column_task(void *arg, size_t col)
+{
+    struct infer_job *job = (struct infer_job *)arg;
+    if (infer_column(job->table, col) != 0)
+        __atomic_store_n(&job->error, -1, __ATOMIC_RELAXED);
+}
+
+// função para inferir os tipos das colunas (uma tarefa do pool de threads por coluna)
+int table_infer_types(struct table *table, int num_threads)
+{
+    // os tipos pertencem aos dados: numa vista são inferidos na tabela de origem
+    if (table->source)
+        table = table->source;
+
+    if (table_flush_deletes(table) != 0 || table->num_rows > UINT32_MAX || table_ensure_columns(table) != 0 ||
+        table_materialize_columns(table, ALL_COLUMNS) != 0)
+        return -1;
+
+    struct infer_job job;
+    job.table = table;
+    job.error = 0;
+    thread_pool_run(num_threads, infer_column_task, &job, table->num_cols);
+
+    return job.error;
+}
+
+enum column_type table_column_type(const struct table *table, size_t col)
+{
+    const struct table *base = table->source ? table->source : table;
+    if (!base->columns || col >= base->num_cols)
+        return COLUMN_STRING;
+    return base->columns[col].type;
+}
+
+bool table_get_int64(const struct table *table, size_t row_index, size_t col, int64_t *value)
+{
+    const struct table *base = table->source ? table->source : table;
+    if (table_column_type(table, col) != COLUMN_INT64 || row_index >= table->num_rows)
+        return false;
+
+    const struct column_info *info = &base->columns[col];
+    size_t row = table_physical_row(table, row_index);
+    if (info->nulls[row / 64] >> (row % 64) & 1)
+        return false;
+
+    *value = info->values[row].i;
+    return true;
+}
+
+bool table_get_double(const struct table *table, size_t row_index, size_t col, double *value)
+{
+    const struct table *base = table->source ? table->source : table;
+    if (table_column_type(table, col) == COLUMN_STRING || row_index >= table->num_rows)
+        return false;
+
+    return column_number(&base->columns[col], table_physical_row(table, row_index), value);
+}
+
+// função auxiliar para remover as posições eliminadas dos arrays das colunas na compactação
+// (as posições vivas só andam para trás, por isso tudo é feito no próprio array)
+void table_types_compact(struct table *table)
+{
+    const struct tombstones *ts = table->deleted;
+    if (!table->columns)
+        return;
+
+    for (size_t col = 0; col < table->num_cols; col++)
+    {
+        struct column_info *info = &table->columns[col];
+        if (!info->codes && info->type == COLUMN_STRING)
+            continue;
+
+        size_t w = 0;
+        for (size_t slot = 0; slot < ts->num_slots; slot++)
+        {
+            if (ts->bits[slot / 64] >> (slot % 64) & 1)
+                continue;
+
+            if (info->codes)
+                info->codes[w] = info->codes[slot];
+
+            if (info->type != COLUMN_STRING)
+            {
+                uint64_t bit = (uint64_t)1 << (w % 64);
+                info->values[w] = info->values[slot];
+                if (info->nulls[slot / 64] >> (slot % 64) & 1)
+                    info->nulls[w / 64] |= bit;
+                else
+                    info->nulls[w / 64] &= ~bit;
+            }
+            w++;
+        }
+    }
+}
@@ -0,0 +1,291 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "table.h"
+#include "table_internal.h"
+#include "csv_scan.h"
+#include "thread_pool.h"
+
+// Escrita de CSV (table_save_csv)
+//
+// as células são copiadas com memcpy para um buffer grande, que só é escrito no ficheiro
+// (com write) quando enche; o comprimento de cada célula e a necessidade de aspas são
+// encontrados numa só passagem por csv_cell_length
+// em table_save_csv_parallel, as threads formatam blocos de linhas em buffers próprios
+// (escritores sem ficheiro) e a thread que chamou escreve-os no ficheiro pela ordem da tabela
+
+// função auxiliar para escrever o buffer todo em fd (write pode escrever só uma parte)
+static int write_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int csv_writer_init(struct csv_writer *w, int fd)
+{
+    w->fd = fd;
+    w->len = 0;
+    w->size = SAVE_BUFFER_SIZE;
+    w->bytes = 0;
+    w->error = false;
+    w->buf = malloc(w->size);
+    return w->buf ? 0 : -1;
+}
+
+int csv_writer_flush(struct csv_writer *w)
+{
+    if (w->fd >= 0 && w->len > 0 && !w->error)
+    {
+        if (write_all(w->fd, w->buf, w->len) != 0)
+            w->error = true;
+        w->len = 0;
+    }
+    return w->error ? -1 : 0;
+}
+
+void csv_writer_free(struct csv_writer *w)
+{
+    free(w->buf);
+    w->buf = NULL;
+}
+
+// função auxiliar para arranjar espaço para n bytes no buffer
+// com ficheiro, o buffer é escrito; sem ficheiro, o buffer cresce
+// devolve falso se os n bytes não couberem (só com ficheiro: têm de ser escritos diretamente)
+static bool writer_reserve(struct csv_writer *w, size_t n)
+{
+    if (w->size - w->len >= n)
+        return true;
+
+    if (w->fd >= 0)
+    {
+        csv_writer_flush(w);
+        return n <= w->size;
+    }
+
+    size_t size = w->size;
+    while (size - w->len < n)
+        size *= 2;
+    char *tmp = realloc(w->buf, size);
+    if (!tmp)
+    {
+        w->error = true;
+        w->len = 0;
+        return false;
+    }
+    w->buf = tmp;
+    w->size = size;
+    return true;
+}
+
+// função auxiliar para acrescentar n bytes à saída
+static void writer_put(struct csv_writer *w, const char *data, size_t n)
+{
+    w->bytes += n;
+    if (writer_reserve(w, n))
+    {
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+    }
+    else if (w->fd >= 0 && !w->error && write_all(w->fd, data, n) != 0)
+        w->error = true;
+}
+
+// função auxiliar para escrever uma célula entre aspas (" torna-se "")
+static void writer_put_quoted(struct csv_writer *w, const char *s, size_t len)
+{
+    writer_put(w, "\"", 1);
+
+    const char *end = s + len;
+    const char *quote;
+    while ((quote = memchr(s, '"', end - s)) != NULL)
+    {
+        writer_put(w, s, quote + 1 - s);
+        writer_put(w, "\"", 1);
+        s = quote + 1;
+    }
+    writer_put(w, s, end - s);
+
+    writer_put(w, "\"", 1);
+}
+
+// função auxiliar para obter o texto de uma célula vista sobre o ficheiro mapeado
+// (o campo não é copiado, por isso não tem '\0'); needs_quotes como em csv_cell_length
+static const char *view_text(const struct table *base, const char *cell, size_t *len, bool *needs_quotes)
+{
+    const char *s = cell;
+    *len = cell_view_length(base, cell);
+
+    *needs_quotes = false;
+    for (size_t k = 0; k < *len && !*needs_quotes; k++)
+        *needs_quotes = s[k] == '"' || s[k] == ',' || s[k] == '\n' || s[k] == '\r';
+    return s;
+}
+
+void csv_writer_rows(struct csv_writer *w, const struct table *table, size_t first, size_t end)
+{
+    const struct table *base = table->source ? table->source : table;
+    size_t num_cols = table->num_cols;
+
+    for (size_t i = first; i < end && !w->error; i++)
+    {
+        char **row = table_row(table, i);
+        for (size_t j = 0; j < num_cols; j++)
+        {
+            // células NULL (linhas com menos colunas) são escritas vazias
+            const char *str = row[j];
+            if (str)
+            {
+                bool needs_quotes;
+                size_t len;
+                if (cell_is_view(base, str))
+                    str = view_text(base, str, &len, &needs_quotes);
+                else
+                    len = csv_cell_length(str, &needs_quotes);
+
+                if (needs_quotes)
+                    writer_put_quoted(w, str, len);
+                else if (w->size - w->len > len)
+                {
+                    // caso normal: a célula e o separador cabem no buffer
+                    memcpy(w->buf + w->len, str, len);
+                    w->len += len;
+                    w->bytes += len;
+                }
+                else
+                    writer_put(w, str, len);
+            }
+
+            // separador, ou fim da linha
+            writer_put(w, j + 1 < num_cols ? "," : "\n", 1);
+        }
+    }
+}
+
+// função auxiliar para abrir o ficheiro de destino de table_save_csv
+static int open_dest(const char *filename)
+{
+    return open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+}
+
+// função para salvar uma tabela num ficheiro CSV
+long table_save_csv(const struct table *table, const char *filename)
+{
+    // guardar é um bom momento para remover as linhas eliminadas
+    if (table_flush_deletes(table) != 0)
+        return -1;
+
+    int fd = open_dest(filename);
+    if (fd < 0)
+        return -1;
+
+    struct csv_writer w;
+    if (csv_writer_init(&w, fd) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    csv_writer_rows(&w, table, 0, table->num_rows);
+    int result = csv_writer_flush(&w);
+    csv_writer_free(&w);
+
+    if (close(fd) != 0)
+        result = -1;
+
+    return result == 0 ? w.bytes : -1;
+}
+
+// estado partilhado pelas threads de table_save_csv_parallel
+struct save_job
+{
+    const struct table *table;
+    struct csv_writer *chunks; // um escritor sem ficheiro por bloco da ronda atual
+    size_t first_chunk;        // primeiro bloco da ronda atual
+};
+
+static void save_chunk_task(void *arg, size_t index)
+{
+    struct save_job *job = (struct save_job *)arg;
+    struct csv_writer *w = &job->chunks[index];
+    size_t first = (job->first_chunk + index) * SAVE_CHUNK_ROWS;
+    size_t end = first + SAVE_CHUNK_ROWS;
+    if (end > job->table->num_rows)
+        end = job->table->num_rows;
+
+    w->len = 0;
+    w->bytes = 0;
+    csv_writer_rows(w, job->table, first, end);
+}
+
+// função para salvar uma tabela num ficheiro CSV, formatando as linhas com num_threads threads
+long table_save_csv_parallel(const struct table *table, const char *filename, int num_threads)
+{
+    size_t num_chunks = (table->num_rows + SAVE_CHUNK_ROWS - 1) / SAVE_CHUNK_ROWS;
+    if (num_threads > TABLE_MAX_THREADS)
+        num_threads = TABLE_MAX_THREADS;
+    if (num_threads <= 1 || num_chunks < 2)
+        return table_save_csv(table, filename);
+
+    if (table_flush_deletes(table) != 0)
+        return -1;
+
+    int fd = open_dest(filename);
+    if (fd < 0)
+        return -1;
+
+    // cada ronda formata num_threads blocos em paralelo e escreve-os por ordem
+    // (a memória usada não depende do tamanho da tabela)
+    struct csv_writer chunks[TABLE_MAX_THREADS];
+    int num_writers = 0;
+    int result = 0;
+    for (; num_writers < num_threads; num_writers++)
+    {
+        if (csv_writer_init(&chunks[num_writers], -1) != 0)
+        {
+            result = -1;
+            break;
+        }
+    }
+
+    struct save_job job;
+    job.table = table;
+    job.chunks = chunks;
+    long bytes = 0;
+
+    for (size_t first = 0; first < num_chunks && result == 0; first += num_threads)
+    {
+        size_t count = num_chunks - first < (size_t)num_threads ? num_chunks - first : (size_t)num_threads;
+        job.first_chunk = first;
+        thread_pool_run(num_threads, save_chunk_task, &job, count);
+
+        for (size_t k = 0; k < count && result == 0; k++)
+        {
+            if (chunks[k].error || write_all(fd, chunks[k].buf, chunks[k].len) != 0)
+                result = -1;
+            bytes += chunks[k].bytes;
+        }
+    }
+
+    for (int k = 0; k < num_writers; k++)
+        csv_writer_free(&chunks[k]);
+
+    if (close(fd) != 0)
+        result = -1;
+
+    return result == 0 ? bytes : -1;
+}
@@ -0,0 +1,113 @@
+#include <stdbool.h>
+#include <pthread.h>
+#include "table.h"
+#include "thread_pool.h"
+
+// estado do pool (um único pool para toda a biblioteca)
+// só corre um trabalho de cada vez: chamadas concorrentes a thread_pool_run esperam em run_lock
+static struct
+{
+    pthread_mutex_t run_lock;  // serializa os trabalhos
+    pthread_mutex_t lock;      // protege o resto do estado
+    pthread_cond_t work_ready; // há um novo trabalho
+    pthread_cond_t work_done;  // o trabalho atual terminou
+    int num_workers;           // threads já criadas
+
+    // trabalho atual
+    unsigned long generation; // incrementado a cada trabalho
+    int max_workers;          // só os workers com id < max_workers participam
+    void (*task)(void *arg, size_t index);
+    void *arg;
+    size_t num_tasks;
+    size_t next_task;  // próxima tarefa a atribuir
+    size_t tasks_done; // tarefas terminadas
+} pool = {
+    .run_lock = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_ready = PTHREAD_COND_INITIALIZER,
+    .work_done = PTHREAD_COND_INITIALIZER,
+};
+
+// função auxiliar para executar tarefas do trabalho atual até não haver mais
+// chamada com pool.lock fechado (e devolve com pool.lock fechado)
+static void run_pending_tasks(void)
+{
+    while (pool.next_task < pool.num_tasks)
+    {
+        size_t index = pool.next_task++;
+
+        pthread_mutex_unlock(&pool.lock);
+        pool.task(pool.arg, index);
+        pthread_mutex_lock(&pool.lock);
+
+        if (++pool.tasks_done == pool.num_tasks)
+            pthread_cond_signal(&pool.work_done);
+    }
+}
+
+// ciclo de cada worker: esperar por trabalho e executar tarefas
+static void *worker_main(void *arg)
+{
+    int id = (int)(size_t)arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;)
+    {
+        while (pool.generation == seen)
+            pthread_cond_wait(&pool.work_ready, &pool.lock);
+        seen = pool.generation;
+
+        if (id < pool.max_workers)
+            run_pending_tasks();
+    }
+
+    return NULL;
+}
+
+void thread_pool_run(int num_threads, void (*task)(void *arg, size_t index), void *arg, size_t num_tasks)
+{
+    if (num_tasks == 0)
+        return;
+
+    if (num_threads > TABLE_MAX_THREADS)
+        num_threads = TABLE_MAX_THREADS;
+
+    // com uma só thread (ou uma só tarefa) não vale a pena acordar o pool
+    if (num_threads <= 1 || num_tasks == 1)
+    {
+        for (size_t i = 0; i < num_tasks; i++)
+            task(arg, i);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.run_lock);
+    pthread_mutex_lock(&pool.lock);
+
+    // criar os workers que faltam (a thread que chama também trabalha)
+    while (pool.num_workers < num_threads - 1)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker_main, (void *)(size_t)pool.num_workers) != 0)
+            break;
+        pthread_detach(thread);
+        pool.num_workers++;
+    }
+
+    pool.task = task;
+    pool.arg = arg;
+    pool.num_tasks = num_tasks;
+    pool.next_task = 0;
+    pool.tasks_done = 0;
+    pool.max_workers = num_threads - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.work_ready);
+
+    // a thread que chama também executa tarefas e depois espera pelas restantes
+    run_pending_tasks();
+    while (pool.tasks_done < pool.num_tasks)
+        pthread_cond_wait(&pool.work_done, &pool.lock);
+
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&pool.run_lock);
+}
@@ -0,0 +1,15 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+
+// Pool de threads partilhado pelas operações paralelas da biblioteca
+// as threads são criadas na primeira utilização e ficam à espera de trabalho,
+// para não pagarmos a criação de threads em cada operação
+
+// Executa task(arg, i) para todos os i em [0, num_tasks) usando até num_threads threads
+// (incluindo a que chama) e só retorna quando todas as tarefas tiverem terminado
+// as tarefas não podem chamar thread_pool_run
+void thread_pool_run(int num_threads, void (*task)(void *arg, size_t index), void *arg, size_t num_tasks);
+
+#endif